@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include "arena.h"
+
+static thread_local Arena* current_arena = nullptr;
+
+// Every ArenaAllocated object is preceded by a header telling whether it lives in an arena.
+// The header is as large as the strictest alignment, so objects keep their alignment.
+static constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+Arena::Arena(size_t block_size) : block_size(block_size) {}
+
+Arena::~Arena() {
+    release();
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(ptr);
+    uintptr_t aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    if (!ptr || aligned + size > reinterpret_cast<uintptr_t>(end)) {
+        grow(size + alignment);
+        address = reinterpret_cast<uintptr_t>(ptr);
+        aligned = (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+    ptr = reinterpret_cast<char*>(aligned + size);
+    used += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::release() {
+    for (auto& block: blocks)
+        ::operator delete(block.data);
+    blocks.clear();
+    next = 0;
+    ptr = end = nullptr;
+    used = 0;
+}
+
+void Arena::reset() {
+    next = 0;
+    ptr = end = nullptr;
+    used = 0;
+}
+
+size_t Arena::bytes_used() const {
+    return used;
+}
+
+size_t Arena::bytes_reserved() const {
+    size_t reserved = 0;
+    for (const auto& block: blocks)
+        reserved += block.size;
+    return reserved;
+}
+
+void Arena::grow(size_t min_size) {
+    // Kept blocks that are too small stay unused until the next reset.
+    while (next < blocks.size()) {
+        const Block& block = blocks[next++];
+        if (block.size >= min_size) {
+            ptr = block.data;
+            end = block.data + block.size;
+            return;
+        }
+    }
+    size_t size = std::max(block_size, min_size);
+    auto* data = static_cast<char*>(::operator new(size));
+    blocks.push_back({data, size});
+    next = blocks.size();
+    ptr = data;
+    end = data + size;
+}
+
+Arena* Arena::current() {
+    return current_arena;
+}
+
+Arena::Scope::Scope(Arena& arena) : previous(current_arena) {
+    current_arena = &arena;
+}
+
+Arena::Scope::~Scope() {
+    current_arena = previous;
+}
+
+void* ArenaAllocated::operator new(size_t size) {
+    return allocate(size);
+}
+
+void ArenaAllocated::operator delete(void* ptr) noexcept {
+    deallocate(ptr);
+}
+
+void* ArenaAllocated::allocate(size_t size) {
+    Arena* arena = current_arena;
+    char* base = static_cast<char*>(arena ? arena->allocate(HEADER_SIZE + size) : ::operator new(HEADER_SIZE + size));
+    *reinterpret_cast<Arena**>(base) = arena;
+    return base + HEADER_SIZE;
+}
+
+void ArenaAllocated::deallocate(void* ptr) noexcept {
+    if (!ptr)
+        return;
+    char* base = static_cast<char*>(ptr) - HEADER_SIZE;
+    if (!*reinterpret_cast<Arena**>(base))
+        ::operator delete(base);
+}
+
+bool ArenaAllocated::in_arena(const void* object) {
+    return object && arena_of(object) != nullptr;
+}
+
+Arena* ArenaAllocated::arena_of(const void* object) {
+    const char* base = reinterpret_cast<const char*>(object) - HEADER_SIZE;
+    return *reinterpret_cast<Arena* const*>(base);
+}
@@ -0,0 +1,137 @@
+#include <cstring>
+
+#include "interner.h"
+
+constexpr Atom Interner::EMPTY;
+constexpr Atom Interner::NONE;
+constexpr size_t Interner::SHARDS;
+constexpr unsigned Interner::FIRST_CHUNK_BITS;
+constexpr size_t Interner::FIRST_CHUNK;
+constexpr unsigned Interner::CHUNKS;
+
+static thread_local Interner* current_interner = nullptr;
+
+namespace {
+    // Returns the index of the highest set bit of `value`, which is not 0.
+    inline unsigned highest_bit(uint64_t value) {
+#if defined(__GNUC__)
+        return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+        unsigned bit = 0;
+        while (value >>= 1)
+            ++bit;
+        return bit;
+#endif
+    }
+}
+
+Interner::Interner() {
+    for (auto& chunk : chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+    intern("", 0);
+}
+
+Interner::~Interner() {
+    for (auto& chunk : chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+Interner& Interner::global() {
+    static Interner interner;
+    return interner;
+}
+
+Interner& Interner::current() {
+    return current_interner ? *current_interner : global();
+}
+
+Interner::Scope::Scope(Interner& interner) : previous(current_interner) {
+    current_interner = &interner;
+}
+
+Interner::Scope::~Scope() {
+    current_interner = previous;
+}
+
+Atom Interner::intern(const char* str, size_t length) {
+    const Key key{str, length};
+    Shard& owner = shard(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    auto item = owner.atoms.find(key);
+    if (item != owner.atoms.end())
+        return item->second;
+
+    const Atom atom = next.fetch_add(1, std::memory_order_relaxed);
+    std::string& stored = slot(atom);
+    stored.assign(str, length);
+    owner.atoms.emplace(Key{stored.data(), stored.size()}, atom);
+    return atom;
+}
+
+Atom Interner::intern(const std::string& str) {
+    return intern(str.data(), str.size());
+}
+
+Atom Interner::find(const std::string& str) const {
+    const Key key{str.data(), str.size()};
+    const Shard& owner = shard(key);
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    auto item = owner.atoms.find(key);
+    if (item == owner.atoms.end())
+        return NONE;
+    return item->second;
+}
+
+const std::string& Interner::str(Atom atom) const {
+    const size_t index = atom + FIRST_CHUNK;
+    const unsigned chunk = highest_bit(index) - FIRST_CHUNK_BITS;
+    return chunks[chunk].load(std::memory_order_acquire)[index - (FIRST_CHUNK << chunk)];
+}
+
+size_t Interner::size() const {
+    return next.load(std::memory_order_relaxed);
+}
+
+void Interner::clear() {
+    for (auto& owner : shards)
+        owner.atoms.clear();
+    // The strings keep their capacity, for the strings interned next.
+    const size_t count = next.load(std::memory_order_relaxed);
+    for (Atom atom = 0; atom < count; ++atom)
+        slot(atom).clear();
+    next.store(0, std::memory_order_relaxed);
+    intern("", 0);
+}
+
+Interner::Shard& Interner::shard(const Key& key) const {
+    return shards[KeyHash()(key) % SHARDS];
+}
+
+std::string& Interner::slot(Atom atom) {
+    const size_t index = atom + FIRST_CHUNK;
+    const unsigned chunk = highest_bit(index) - FIRST_CHUNK_BITS;
+    std::string* strings = chunks[chunk].load(std::memory_order_acquire);
+    if (!strings) {
+        // Threads interning in different shards may race to create the chunk: the first one wins.
+        auto* created = new std::string[FIRST_CHUNK << chunk];
+        if (chunks[chunk].compare_exchange_strong(strings, created, std::memory_order_acq_rel))
+            strings = created;
+        else
+            delete[] created;
+    }
+    return strings[index - (FIRST_CHUNK << chunk)];
+}
+
+bool Interner::Key::operator==(const Key& other) const {
+    return length == other.length && std::memcmp(data, other.data, length) == 0;
+}
+
+size_t Interner::KeyHash::operator()(const Key& key) const {
+    // FNV-1a: identifiers are short, so a simple bytewise hash does fine.
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t x = 0; x < key.length; ++x) {
+        hash ^= static_cast<unsigned char>(key.data[x]);
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
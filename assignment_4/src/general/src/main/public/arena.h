@@ -0,0 +1,131 @@
+#ifndef COCO_FRAMEWORK_GENERAL_ARENA
+#define COCO_FRAMEWORK_GENERAL_ARENA
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Bump-pointer allocator for objects that live as long as one compilation.
+// Memory is handed out from large blocks, and all of it is released at once.
+// An arena is not thread-safe: use one arena per thread.
+class Arena {
+    public:
+    explicit Arena(size_t block_size = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Returns `size` bytes of memory, aligned to `alignment` (a power of 2).
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // Frees all memory at once. Objects in the arena are not destructed.
+    void release();
+
+    // Frees all objects at once, like `release`, but keeps the blocks to hand out memory from again.
+    void reset();
+
+    // Returns the number of bytes handed out since construction or the last release or reset.
+    size_t bytes_used() const;
+
+    // Returns the number of bytes in the blocks of the arena.
+    size_t bytes_reserved() const;
+
+    // Returns the arena in which `ArenaAllocated` objects are created on this thread, or `nullptr` if there is none.
+    static Arena* current();
+
+    // Makes an arena the current arena on this thread, for the lifetime of the Scope object.
+    class Scope {
+        public:
+        explicit Scope(Arena& arena);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        private:
+        Arena* previous;
+    };
+
+    private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    // Starts a new block of at least `min_size` bytes: the next kept block that is large enough, or else a new one.
+    void grow(size_t min_size);
+
+    size_t block_size;
+    std::vector<Block> blocks;
+    // Index in `blocks` of the first block not handed out from since the last reset
+    size_t next = 0;
+    char* ptr = nullptr;
+    char* end = nullptr;
+    size_t used = 0;
+};
+
+// Base class for objects which are created in the current arena if there is one, and on the heap otherwise.
+// Deleting an object that lives in an arena runs its destructor, but frees no memory: its arena frees it in bulk.
+// Owners can use `in_arena` to skip deleting such objects altogether, if their destructors have no side effects.
+class ArenaAllocated {
+    public:
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr) noexcept;
+
+    // Returns `size` bytes of memory, in the current arena if there is one, and on the heap otherwise.
+    static void* allocate(size_t size);
+
+    // Frees memory returned by `allocate`, unless it lives in an arena.
+    static void deallocate(void* ptr) noexcept;
+
+    // Returns whether `object` (a pointer returned by `new`, or `nullptr`) lives in an arena.
+    static bool in_arena(const void* object);
+
+    // Returns the arena `object` (a pointer returned by `new`) lives in, or `nullptr` if it lives on the heap.
+    static Arena* arena_of(const void* object);
+};
+
+// Standard allocator for containers owned by `ArenaAllocated` objects, so their storage lives where their owner does:
+// in the arena of the owner, or on the heap. Which arena is current when the container grows does not matter.
+// Storage in an arena is freed with the arena, so containers in an arena need not be destructed.
+template<typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    // An allocator on the heap
+    ArenaAllocator() = default;
+    explicit ArenaAllocator(Arena* arena) : arena(arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    // Returns an allocator for the containers of `owner`, a pointer returned by `new` of an `ArenaAllocated` object.
+    static ArenaAllocator of(const void* owner) {
+        return ArenaAllocator(ArenaAllocated::arena_of(owner));
+    }
+
+    T* allocate(size_t n) {
+        if (arena)
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t) noexcept {
+        if (!arena)
+            ::operator delete(ptr);
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+
+    Arena* arena = nullptr;
+};
+
+#endif
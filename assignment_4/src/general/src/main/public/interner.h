@@ -0,0 +1,101 @@
+#ifndef COCO_FRAMEWORK_GENERAL_INTERNER
+#define COCO_FRAMEWORK_GENERAL_INTERNER
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// A handle to an interned string. Equal strings always get the same atom.
+using Atom = uint32_t;
+
+// String interner, which stores every distinct string exactly once and hands out a 32-bit atom for it.
+// All functions but `clear` are thread-safe. Interning locks one of several shards, picked by the hash of the string,
+// so threads interning different strings rarely wait for each other. Looking up the string of an atom takes no lock.
+// Strings live until the interner is cleared or destroyed, so references to them stay valid until then.
+class Interner {
+    public:
+    // Atom of the empty string, which is always interned.
+    static constexpr Atom EMPTY = 0;
+    // Atom that never refers to a string.
+    static constexpr Atom NONE = UINT32_MAX;
+
+    Interner();
+    ~Interner();
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    // Returns the interner shared by the whole process.
+    static Interner& global();
+
+    // Returns the interner used on this thread: the one of the innermost Scope, or else the global one.
+    static Interner& current();
+
+    // Makes an interner the current interner on this thread, for the lifetime of the Scope object.
+    class Scope {
+        public:
+        explicit Scope(Interner& interner);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        private:
+        Interner* previous;
+    };
+
+    // Returns the atom for the `length` characters at `str`, interning them if needed.
+    Atom intern(const char* str, size_t length);
+
+    // Returns the atom for `str`, interning it if needed.
+    Atom intern(const std::string& str);
+
+    // Returns the atom for `str` if it was interned before, `Interner::NONE` otherwise.
+    Atom find(const std::string& str) const;
+
+    // Returns the string for `atom`. `atom` must have been handed out by this interner.
+    const std::string& str(Atom atom) const;
+
+    // Returns the number of interned strings.
+    size_t size() const;
+
+    // Forgets all strings but the empty one, and invalidates their atoms. Keeps the memory of the interner for reuse.
+    // Not thread-safe: no other thread may use the interner meanwhile.
+    void clear();
+
+    private:
+    // A key viewing a string, so lookups do not have to copy the string they look for.
+    struct Key {
+        const char* data;
+        size_t length;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, Atom, KeyHash> atoms;
+    };
+
+    static constexpr size_t SHARDS = 16;
+    // Strings are stored in chunks of doubling size, starting with FIRST_CHUNK strings. Chunks never move,
+    // so keys can point into them, and a chunk is published once, so readers need no lock.
+    static constexpr unsigned FIRST_CHUNK_BITS = 8;
+    static constexpr size_t FIRST_CHUNK = size_t(1) << FIRST_CHUNK_BITS;
+    static constexpr unsigned CHUNKS = 32 - FIRST_CHUNK_BITS;
+
+    Shard& shard(const Key& key) const;
+    // Returns the storage of `atom`, creating its chunk if needed.
+    std::string& slot(Atom atom);
+
+    mutable Shard shards[SHARDS];
+    std::atomic<std::string*> chunks[CHUNKS];
+    std::atomic<Atom> next{0};
+};
+
+#endif
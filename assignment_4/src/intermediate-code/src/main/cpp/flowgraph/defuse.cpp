@@ -0,0 +1,342 @@
+#include "defuse.h"
+#include "utility.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+constexpr size_t DefUse::NONE;
+
+namespace {
+    // The sets of a block in DefUse::sets
+    enum Set { GEN, KILL, IN, OUT };
+
+    inline uint64_t* block_set(std::vector<uint64_t>& sets, size_t index, Set set, size_t words) {
+        return sets.data() + (4 * index + set) * words;
+    }
+
+    inline void set_bit(uint64_t* set, size_t bit) {
+        set[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    inline bool test_bit(const uint64_t* set, size_t bit) {
+        return (set[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    // Label a jump goes to, or NONE
+    size_t target(const IStatement& stmt) {
+        const IOperandSlot label = iop_is_cond_jmp(stmt.getOperator()) ? stmt.getResultSlot() : stmt.getOperand1Slot();
+        return label.isSymbol() ? label.getId() : DefUse::NONE;
+    }
+
+    // Whether control never continues with the next line
+    bool ends_block(IOperator op) {
+        return op == IOP_RETURN || (iop_is_goto(op) && op != IOP_FUNCCALL);
+    }
+}
+
+DefUse::DefUse(const SymbolTable& table, const IntermediateCode& ic) {
+    build(table, ic);
+}
+
+void DefUse::build(const SymbolTable& table, const IntermediateCode& ic) {
+    const size_t count = ic.getStatementCount();
+    definitions.clear();
+    line_definitions.assign(count, NONE);
+    use_offsets.assign(2 * count + 1, 0);
+    use_definitions.clear();
+    blocks.clear();
+    preds.clear();
+    succs.clear();
+    tracked.clear();
+
+    // Functions run from their IOP_FUNC up to the next one
+    for (size_t start = 0; start < count;) {
+        size_t end = start + 1;
+        while (end < count && ic.getStatement(end)->getOperator() != IOP_FUNC)
+            ++end;
+        build_function(table, ic, start, end);
+        start = end;
+    }
+
+    // Invert the use-def chains. A line reading a definition at both operands lists it once.
+    def_offsets.assign(definitions.size() + 1, 0);
+    std::vector<size_t> last(definitions.size(), NONE); // definition --> last line reading it
+    for (size_t line = 0; line < count; ++line) {
+        for (size_t x = use_offsets[2 * line]; x < use_offsets[2 * line + 2]; ++x) {
+            const size_t def = use_definitions[x];
+            if (last[def] != line)
+                ++def_offsets[def + 1];
+            last[def] = line;
+        }
+    }
+    for (size_t def = 0; def < definitions.size(); ++def)
+        def_offsets[def + 1] += def_offsets[def];
+    def_uses.resize(def_offsets.back());
+    std::vector<size_t> next(def_offsets.begin(), def_offsets.end() - 1);
+    for (size_t line = 0; line < count; ++line) {
+        for (size_t x = use_offsets[2 * line]; x < use_offsets[2 * line + 2]; ++x) {
+            const size_t def = use_definitions[x];
+            if (next[def] == def_offsets[def] || def_uses[next[def] - 1] != line)
+                def_uses[next[def]++] = line;
+        }
+    }
+}
+
+bool DefUse::is_tracked(const SymbolTable& table, const IOperandSlot& slot) {
+    return slot.isSymbol() && is_tracked(table, slot.getId());
+}
+
+bool DefUse::is_tracked(const SymbolTable& table, size_t id) {
+    if (id >= tracked.size())
+        tracked.resize(id + 1, 0);
+    if (tracked[id] == 0) {
+        const Symbol* symbol = table.getSymbol(id);
+        const bool local = symbol && !table.isGlobal(id) && !types::isArray(symbol->getReturnType())
+                           && (symbol->getSymbolType() == ST_VARIABLE || symbol->getSymbolType() == ST_PARAMETER || symbol->getSymbolType() == ST_TEMPVAR);
+        tracked[id] = local ? 1 : 2;
+    }
+    return tracked[id] == 1;
+}
+
+void DefUse::build_blocks(const IntermediateCode& ic, size_t start, size_t end) {
+    std::unordered_map<size_t, size_t> labels; // label --> first block
+    const size_t first = blocks.size();
+    for (size_t line = start; line < end;) {
+        Block block{line, line + 1, 0, 0, 0, 0, false};
+        if (ic.getStatement(line)->getOperator() == IOP_LABEL)
+            labels.emplace(ic.getStatement(line)->getOperand1Slot().getId(), blocks.size());
+        while (block.end < end && !ends_block(ic.getStatement(block.end - 1)->getOperator())
+               && ic.getStatement(block.end)->getOperator() != IOP_LABEL)
+            ++block.end;
+        blocks.push_back(block);
+        line = block.end;
+    }
+
+    // Edges by successor, then sorted into the ranges of predecessors
+    std::vector<std::pair<size_t, size_t>> edges;
+    for (size_t x = first; x < blocks.size(); ++x) {
+        const IStatement& last = *ic.getStatement(blocks[x].end - 1);
+        if (iop_is_goto(last.getOperator()) && last.getOperator() != IOP_FUNCCALL) {
+            const auto label = labels.find(target(last));
+            if (label != labels.end())
+                edges.emplace_back(label->second, x);
+        }
+        if (!ends_block(last.getOperator()) || iop_is_cond_jmp(last.getOperator()))
+            if (x + 1 < blocks.size())
+                edges.emplace_back(x + 1, x);
+    }
+    std::sort(edges.begin(), edges.end());
+    auto edge = edges.begin();
+    for (size_t x = first; x < blocks.size(); ++x) {
+        blocks[x].preds_begin = preds.size();
+        for (; edge != edges.end() && edge->first == x; ++edge)
+            preds.push_back(edge->second);
+        blocks[x].preds_end = preds.size();
+    }
+
+    // The same edges by predecessor, for the successors
+    for (auto& reversed : edges)
+        std::swap(reversed.first, reversed.second);
+    std::sort(edges.begin(), edges.end());
+    edge = edges.begin();
+    for (size_t x = first; x < blocks.size(); ++x) {
+        blocks[x].succs_begin = succs.size();
+        for (; edge != edges.end() && edge->first == x; ++edge)
+            succs.push_back(edge->second);
+        blocks[x].succs_end = succs.size();
+    }
+}
+
+void DefUse::build_function(const SymbolTable& table, const IntermediateCode& ic, size_t start, size_t end) {
+    const size_t first = blocks.size();
+    build_blocks(ic, start, end);
+
+    // Parameters, by the statement of their function
+    std::vector<size_t> parameters;
+    const IStatement& head = *ic.getStatement(start);
+    if (head.getOperator() == IOP_FUNC && head.getOperand1Slot().isSymbol())
+        for (size_t id : table.getParameters(head.getOperand1Slot().getId()))
+            if (is_tracked(table, id))
+                parameters.push_back(id);
+
+    // Definitions, numbered in order of their lines
+    const size_t first_def = definitions.size();
+    for (size_t line = start; line < end; ++line) {
+        if (line == start)
+            for (size_t id : parameters)
+                definitions.push_back(Definition{line, id});
+        const IStatement& stmt = *ic.getStatement(line);
+        if (iop_has_result(stmt.getOperator()) && is_tracked(table, stmt.getResultSlot())) {
+            line_definitions[line] = definitions.size();
+            definitions.push_back(Definition{line, stmt.getResultSlot().getId()});
+        }
+    }
+    const size_t last_def = definitions.size();
+    const size_t words = (last_def - first_def + 63) / 64;
+
+    // Variables, in order of their first definition, and their definitions
+    variables.clear();
+    variable_offsets.assign(1, 0);
+    for (size_t def = first_def; def < last_def; ++def) {
+        const size_t id = definitions[def].symbol;
+        if (id >= variable_ids.size())
+            variable_ids.resize(id + 1, NONE);
+        if (variable_ids[id] == NONE) {
+            variable_ids[id] = variables.size();
+            variables.push_back(Variable{NONE, NONE, NONE, NONE});
+            variable_offsets.push_back(0);
+        }
+        ++variable_offsets[variable_ids[id] + 1];
+    }
+    for (size_t v = 0; v < variables.size(); ++v)
+        variable_offsets[v + 1] += variable_offsets[v];
+    variable_defs.resize(variable_offsets.back());
+    {
+        std::vector<size_t> next(variable_offsets.begin(), variable_offsets.end() - 1);
+        for (size_t def = first_def; def < last_def; ++def)
+            variable_defs[next[variable_ids[definitions[def].symbol]]++] = def;
+    }
+
+    // gen: the last definition of each variable in the block. kill: all definitions of the variables the block defines.
+    sets.assign(4 * (blocks.size() - first) * words, 0);
+    size_t def = first_def;
+    for (size_t x = first; x < blocks.size(); ++x) {
+        uint64_t* gen = block_set(sets, x - first, GEN, words);
+        uint64_t* kill = block_set(sets, x - first, KILL, words);
+        const size_t block_def = def;
+        for (; def < last_def && definitions[def].line < blocks[x].end; ++def) {
+            const size_t v = variable_ids[definitions[def].symbol];
+            if (variables[v].block != x) {
+                variables[v].block = x;
+                for (size_t y = variable_offsets[v]; y < variable_offsets[v + 1]; ++y)
+                    set_bit(kill, variable_defs[y] - first_def);
+            }
+            variables[v].def = def;
+        }
+        for (size_t y = block_def; y < def; ++y)
+            if (variables[variable_ids[definitions[y].symbol]].def == y)
+                set_bit(gen, y - first_def);
+    }
+
+    solve(first, words);
+
+    // Uses: the last definition before them in their block, or those reaching the block
+    for (Variable& variable : variables)
+        variable = Variable{NONE, NONE, NONE, NONE};
+    auto state = [this](size_t block, size_t v) -> Variable& {
+        if (variables[v].block != block)
+            variables[v] = Variable{block, NONE, NONE, NONE};
+        return variables[v];
+    };
+    for (size_t x = first; x < blocks.size(); ++x) {
+        const uint64_t* in = block_set(sets, x - first, IN, words);
+        for (size_t line = blocks[x].start; line < blocks[x].end; ++line) {
+            if (line == start)
+                for (size_t param = 0; param < parameters.size(); ++param)
+                    state(x, variable_ids[parameters[param]]).def = first_def + param;
+            const IStatement& stmt = *ic.getStatement(line);
+            const int arity = iop_arity(stmt.getOperator());
+            for (int operand = OPERAND1; operand <= OPERAND2; ++operand) {
+                const IOperandSlot slot = operand == OPERAND1 ? stmt.getOperand1Slot() : stmt.getOperand2Slot();
+                const size_t id = slot.isSymbol() ? slot.getId() : NONE;
+                // Variables without definitions in the function have no reaching definitions.
+                if (arity > operand && id < variable_ids.size() && variable_ids[id] != NONE && is_tracked(table, id)) {
+                    const size_t v = variable_ids[id];
+                    Variable& variable = state(x, v);
+                    if (variable.def != NONE) {
+                        use_definitions.push_back(variable.def);
+                    } else if (variable.begin == NONE) {
+                        variable.begin = use_definitions.size();
+                        for (size_t y = variable_offsets[v]; y < variable_offsets[v + 1]; ++y)
+                            if (test_bit(in, variable_defs[y] - first_def))
+                                use_definitions.push_back(variable_defs[y]);
+                        variable.end = use_definitions.size();
+                    } else {
+                        for (size_t y = variable.begin; y < variable.end; ++y)
+                            use_definitions.push_back(use_definitions[y]);
+                    }
+                }
+                use_offsets[2 * line + operand + 1] = use_definitions.size();
+            }
+            if (line_definitions[line] != NONE)
+                state(x, variable_ids[definitions[line_definitions[line]].symbol]).def = line_definitions[line];
+        }
+    }
+
+    for (size_t y = first_def; y < last_def; ++y)
+        variable_ids[definitions[y].symbol] = NONE;
+}
+
+void DefUse::solve(size_t first, size_t words) {
+    worklist.clear();
+    for (size_t x = blocks.size(); x-- > first;) {
+        const uint64_t* gen = block_set(sets, x - first, GEN, words);
+        std::copy(gen, gen + words, block_set(sets, x - first, OUT, words));
+        blocks[x].queued = true;
+        worklist.push_back(x); // The entry block comes off first
+    }
+    while (!worklist.empty()) {
+        const size_t x = worklist.back();
+        worklist.pop_back();
+        blocks[x].queued = false;
+
+        // in: the union of the out sets of the predecessors. out: gen, and what reaches in and the block does not kill.
+        uint64_t* in = block_set(sets, x - first, IN, words);
+        std::fill(in, in + words, 0);
+        for (size_t y = blocks[x].preds_begin; y < blocks[x].preds_end; ++y) {
+            const uint64_t* out = block_set(sets, preds[y] - first, OUT, words);
+            for (size_t w = 0; w < words; ++w)
+                in[w] |= out[w];
+        }
+        const uint64_t* gen = block_set(sets, x - first, GEN, words);
+        const uint64_t* kill = block_set(sets, x - first, KILL, words);
+        uint64_t* out = block_set(sets, x - first, OUT, words);
+        bool changed = false;
+        for (size_t w = 0; w < words; ++w) {
+            const uint64_t value = gen[w] | (in[w] & ~kill[w]);
+            changed = changed || value != out[w];
+            out[w] = value;
+        }
+        if (changed) {
+            for (size_t y = blocks[x].succs_begin; y < blocks[x].succs_end; ++y) {
+                if (!blocks[succs[y]].queued) {
+                    blocks[succs[y]].queued = true;
+                    worklist.push_back(succs[y]);
+                }
+            }
+        }
+    }
+}
+
+size_t DefUse::getDefinitionCount() const {
+    return definitions.size();
+}
+
+size_t DefUse::getLine(size_t def) const {
+    return definitions[def].line;
+}
+
+size_t DefUse::getSymbol(size_t def) const {
+    return definitions[def].symbol;
+}
+
+size_t DefUse::getDefinition(size_t line) const {
+    return line < line_definitions.size() ? line_definitions[line] : NONE;
+}
+
+DefUse::Ids DefUse::getUses(size_t def) const {
+    return Ids(def_uses.data() + def_offsets[def], def_uses.data() + def_offsets[def + 1]);
+}
+
+DefUse::Ids DefUse::getDefinitions(size_t line, Operand operand) const {
+    if (line >= line_definitions.size())
+        return Ids();
+    const size_t x = 2 * line + operand;
+    return Ids(use_definitions.data() + use_offsets[x], use_definitions.data() + use_offsets[x + 1]);
+}
+
+size_t DefUse::getReachingDefinition(size_t line, Operand operand) const {
+    const Ids defs = getDefinitions(line, operand);
+    return defs.size() == 1 ? defs[0] : NONE;
+}
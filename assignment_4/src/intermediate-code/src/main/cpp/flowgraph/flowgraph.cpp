@@ -2,6 +2,7 @@
 #include "utility.h"
 
 #include <algorithm>
+#include <iterator>
 #include <utility>
 
 
@@ -24,6 +25,36 @@ struct BasicBlockBuilder {
     std::weak_ptr<BasicBlock> build(size_t start);
 };
 
+void ICInfo::remap(const std::vector<size_t>& lines) {
+    const auto moved = [&lines](size_t line) { return line < lines.size() ? lines[line] : IntermediateCode::REMOVED; };
+
+    // Edits keep statements in order, so leaders stay sorted.
+    size_t kept = 0;
+    for (size_t leader : leaders)
+        if (moved(leader) != IntermediateCode::REMOVED)
+            leaders[kept++] = moved(leader);
+    leaders.resize(kept);
+
+    for (auto it = labels.begin(); it != labels.end();) {
+        it->second = moved(it->second);
+        it = it->second == IntermediateCode::REMOVED ? labels.erase(it) : std::next(it);
+    }
+
+    for (auto& call : calls) {
+        kept = 0;
+        for (size_t line : call.second)
+            if (moved(line) != IntermediateCode::REMOVED)
+                call.second[kept++] = moved(line);
+        call.second.resize(kept);
+    }
+
+    std::unordered_map<size_t, size_t> remapped;
+    for (const auto& func : funcs)
+        if (moved(func.first) != IntermediateCode::REMOVED)
+            remapped.emplace(moved(func.first), func.second);
+    funcs.swap(remapped);
+}
+
 /**
  * Constructs an ICInfo given an IntermediateCode
  * Leaders are instructions which:
@@ -48,7 +79,7 @@ static size_t find_main(const std::vector<size_t>& leaders, const SymbolTable& t
     for (size_t leader : leaders) {
         IStatement* stmt = ic.getStatement(leader);
         if (stmt->getOperator() == IOP_FUNC)
-            if (table.getSymbol(std::dynamic_pointer_cast<SymbolIOperand>(stmt->getOperand1())->getId())->getName() == "main")
+            if (table.getSymbol(stmt->getOperand1Slot().getId())->getName() == "main")
                 return leader;
     }
     return std::numeric_limits<size_t>::max();
@@ -101,6 +132,17 @@ std::weak_ptr<BasicBlock> BasicBlockBuilder::build(size_t start) {
 }
 
 FlowGraph::FlowGraph(const SymbolTable& table, const IntermediateCode& ic, Logger& logger) : logger(logger) {
+    build(table, ic);
+}
+
+void FlowGraph::build(const SymbolTable& table, const IntermediateCode& ic) {
+    entry.reset();
+    block_map.clear();
+    live_out.clear();
+    live_in.clear();
+    gen.clear();
+    kill.clear();
+
     ICInfo info = get_ic_info(ic);
     entry = BasicBlockBuilder(block_map, info, ic).build(find_main(info.leaders, table, ic));
 
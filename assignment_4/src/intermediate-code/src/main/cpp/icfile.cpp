@@ -0,0 +1,305 @@
+#include "icfile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char MAGIC[4] = {'C', 'M', 'I', 'C'};
+    const uint32_t ENDIANNESS = 0x01020304;
+
+    // A range of records, at a multiple of 8 bytes from the start of the file
+    struct Section {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t byte_order;      // ENDIANNESS, as written
+        uint32_t statement_size;  // sizeof(IStatement)
+        Section statements;       // IStatement
+        Section symbols;          // SymbolRecord, for ids 1, 2, ...
+        Section functions;        // FunctionRecord
+        Section names;            // char
+        uint64_t program_name;    // Offset in names
+        uint64_t program_name_size;
+    };
+
+    struct SymbolRecord {
+        uint64_t name;      // Offset in names
+        uint32_t name_size;
+        uint32_t function;  // Function the symbol belongs to, 0 for globals and functions
+        int64_t size;
+        int32_t line;
+        uint8_t return_type;
+        uint8_t symbol_type;
+        uint8_t is_function;
+        uint8_t padding;
+    };
+
+    struct FunctionRecord {
+        uint64_t symbol;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    static_assert(sizeof(Header) == 96 && sizeof(SymbolRecord) == 32 && sizeof(FunctionRecord) == 24, "Records should not depend on the compiler");
+
+    size_t align(size_t offset) {
+        return (offset + 7) & ~static_cast<size_t>(7);
+    }
+
+    template<typename T>
+    void write(std::ostream& out, const T* records, size_t count, size_t& offset) {
+        static const char zeros[8] = {};
+        out.write(zeros, static_cast<std::streamsize>(align(offset) - offset));
+        out.write(reinterpret_cast<const char*>(records), static_cast<std::streamsize>(count * sizeof(T)));
+        offset = align(offset) + count * sizeof(T);
+    }
+
+    template<typename T>
+    const T* section(const char* data, const Section& section) {
+        return reinterpret_cast<const T*>(data + section.offset);
+    }
+
+    template<typename T>
+    bool fits(const Section& section, size_t size) {
+        return section.offset % 8 == 0 && section.offset <= size && section.count <= (size - section.offset) / sizeof(T);
+    }
+}
+
+bool intermediate::save(std::ostream& out, const IntermediateCode& icode, const SymbolTable& table) {
+    // Symbols in order of id, so loading adds them with the same ids
+    const std::vector<size_t> functions = table.getFunctions();
+    size_t count = 0;
+    for (size_t id : functions)
+        count = std::max(count, id);
+    for (size_t id : table.globalIds())
+        count = std::max(count, id);
+    for (size_t func : functions) {
+        for (size_t id : table.getParameters(func))
+            count = std::max(count, id);
+        for (size_t id : table.getVariables(func))
+            count = std::max(count, id);
+    }
+    std::vector<uint32_t> owners(count + 1, 0); // id --> function
+    for (size_t func : functions) {
+        for (size_t id : table.getParameters(func))
+            owners[id] = static_cast<uint32_t>(func);
+        for (size_t id : table.getVariables(func))
+            owners[id] = static_cast<uint32_t>(func);
+    }
+
+    std::string names = icode.getProgramName();
+    std::vector<SymbolRecord> symbols(count);
+    for (size_t id = 1; id <= count; ++id) {
+        const Symbol* symbol = table.getSymbol(id);
+        SymbolRecord& record = symbols[id - 1];
+        std::memset(&record, 0, sizeof(record));
+        record.name = names.size();
+        record.name_size = static_cast<uint32_t>(symbol->getName().size());
+        record.function = owners[id];
+        record.size = symbol->getSize();
+        record.line = symbol->getLine();
+        record.return_type = static_cast<uint8_t>(symbol->getReturnType());
+        record.symbol_type = static_cast<uint8_t>(symbol->getSymbolType());
+        names += symbol->getName();
+    }
+    for (size_t func : functions)
+        symbols[func - 1].is_function = 1;
+
+    std::vector<FunctionRecord> lines;
+    for (unsigned line = 0; line < icode.getStatementCount(); ++line) {
+        if (icode.getStatement(line)->getOperator() != IOP_FUNC)
+            continue;
+        if (!lines.empty())
+            lines.back().end = line;
+        lines.push_back(FunctionRecord{icode.getStatement(line)->getOperand1Slot().getId(), line, icode.getStatementCount()});
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = CODE_FILE_VERSION;
+    header.byte_order = ENDIANNESS;
+    header.statement_size = sizeof(IStatement);
+    header.statements = Section{align(sizeof(Header)), icode.getStatementCount()};
+    header.symbols = Section{align(header.statements.offset + header.statements.count * sizeof(IStatement)), symbols.size()};
+    header.functions = Section{align(header.symbols.offset + header.symbols.count * sizeof(SymbolRecord)), lines.size()};
+    header.names = Section{align(header.functions.offset + header.functions.count * sizeof(FunctionRecord)), names.size()};
+    header.program_name = 0;
+    header.program_name_size = icode.getProgramName().size();
+
+    size_t offset = 0;
+    write(out, &header, 1, offset);
+    write(out, icode.getStatementCount() ? icode.getStatement(0) : nullptr, icode.getStatementCount(), offset);
+    write(out, symbols.data(), symbols.size(), offset);
+    write(out, lines.data(), lines.size(), offset);
+    write(out, names.data(), names.size(), offset);
+    return static_cast<bool>(out);
+}
+
+bool intermediate::save(const std::string& path, const IntermediateCode& icode, const SymbolTable& table, Logger& logger) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out || !save(out, icode, table)) {
+        logger.error(-1) << "Could not write intermediate code to " << path << '\n';
+        return false;
+    }
+    return true;
+}
+
+intermediate::MappedCode::MappedCode(const std::string& path, Logger& logger) : logger(logger) {
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st {};
+    if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base != MAP_FAILED) {
+            data = static_cast<const char*>(base);
+            size = static_cast<size_t>(st.st_size);
+            mapped = true;
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+    if (mapped) {
+        check();
+        return;
+    }
+#endif
+    // Not mappable: read it instead
+    std::ifstream in(path, std::ios::binary);
+    buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (!in && !in.eof()) {
+        logger.error(-1) << "Could not read intermediate code from " << path << '\n';
+        return;
+    }
+    data = buffer.data();
+    size = buffer.size();
+    check();
+}
+
+intermediate::MappedCode::MappedCode(const char* data, size_t size, Logger& logger) : logger(logger), data(data), size(size) {
+    check();
+}
+
+intermediate::MappedCode::~MappedCode() {
+#ifndef _WIN32
+    if (mapped)
+        munmap(const_cast<char*>(data), size);
+#endif
+}
+
+bool intermediate::MappedCode::check() {
+    const auto* header = reinterpret_cast<const Header*>(data);
+    if (!data || size < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        logger.error(-1) << "Not an intermediate code file\n";
+        return false;
+    }
+    if (header->version != CODE_FILE_VERSION || header->byte_order != ENDIANNESS || header->statement_size != sizeof(IStatement)) {
+        logger.error(-1) << "Intermediate code file of another version, byte order or statement layout\n";
+        return false;
+    }
+    if (!fits<IStatement>(header->statements, size) || !fits<SymbolRecord>(header->symbols, size) || !fits<FunctionRecord>(header->functions, size)
+        || !fits<char>(header->names, size) || header->program_name > header->names.count || header->program_name_size > header->names.count - header->program_name) {
+        logger.error(-1) << "Intermediate code file is truncated or damaged\n";
+        return false;
+    }
+
+    // The records are used as they are, so all their enums, ids and ranges must be in bounds.
+    const uint64_t symbol_count = header->symbols.count;
+    const SymbolRecord* symbols = section<SymbolRecord>(data, header->symbols);
+    for (uint64_t id = 1; id <= symbol_count; ++id) {
+        const SymbolRecord& record = symbols[id - 1];
+        if (record.name > header->names.count || record.name_size > header->names.count - record.name
+            || record.return_type > RT_BOOL || record.symbol_type > ST_LABEL || record.function > symbol_count) {
+            logger.error(-1) << "Intermediate code file has a damaged symbol " << id << '\n';
+            return false;
+        }
+    }
+    const IStatement* statements = section<IStatement>(data, header->statements);
+    for (uint64_t line = 0; line < header->statements.count; ++line) {
+        const IStatement& stmt = statements[line];
+        if (!stmt.isWellFormed() || (stmt.getOperand1Slot().isSymbol() && stmt.getOperand1Slot().getId() > symbol_count)
+            || (stmt.getOperand2Slot().isSymbol() && stmt.getOperand2Slot().getId() > symbol_count)
+            || (stmt.getResultSlot().isSymbol() && stmt.getResultSlot().getId() > symbol_count)) {
+            logger.error(-1) << "Intermediate code file has a damaged statement at line " << line << '\n';
+            return false;
+        }
+    }
+    const FunctionRecord* functions = section<FunctionRecord>(data, header->functions);
+    for (uint64_t index = 0; index < header->functions.count; ++index) {
+        const FunctionRecord& record = functions[index];
+        if (record.symbol == 0 || record.symbol > symbol_count || record.begin > record.end || record.end > header->statements.count) {
+            logger.error(-1) << "Intermediate code file has a damaged function " << index << '\n';
+            return false;
+        }
+    }
+    checked = true;
+    return true;
+}
+
+bool intermediate::MappedCode::valid() const {
+    return checked;
+}
+
+std::string intermediate::MappedCode::getProgramName() const {
+    if (!checked)
+        return std::string();
+    const auto* header = reinterpret_cast<const Header*>(data);
+    return std::string(section<char>(data, header->names) + header->program_name, header->program_name_size);
+}
+
+const IStatement* intermediate::MappedCode::getStatements() const {
+    return checked ? section<IStatement>(data, reinterpret_cast<const Header*>(data)->statements) : nullptr;
+}
+
+size_t intermediate::MappedCode::getStatementCount() const {
+    return checked ? reinterpret_cast<const Header*>(data)->statements.count : 0;
+}
+
+size_t intermediate::MappedCode::getFunctionCount() const {
+    return checked ? reinterpret_cast<const Header*>(data)->functions.count : 0;
+}
+
+intermediate::MappedCode::Function intermediate::MappedCode::getFunction(size_t index) const {
+    if (index >= getFunctionCount()) {
+        logger.error(-1) << "[MappedCode::getFunction()] Error: invalid parameter index.\n";
+        return Function{0, 0, 0};
+    }
+    const FunctionRecord& record = section<FunctionRecord>(data, reinterpret_cast<const Header*>(data)->functions)[index];
+    return Function{record.symbol, record.begin, record.end};
+}
+
+bool intermediate::MappedCode::load(SymbolTable& table, IntermediateCode& icode) const {
+    if (!checked)
+        return false;
+    const auto* header = reinterpret_cast<const Header*>(data);
+    const char* names = section<char>(data, header->names);
+    const SymbolRecord* symbols = section<SymbolRecord>(data, header->symbols);
+
+    table.clear();
+    for (size_t id = 1; id <= header->symbols.count; ++id) {
+        const SymbolRecord& record = symbols[id - 1]; // Checked by `check`
+        const Symbol symbol(std::string(names + record.name, record.name_size), record.line, static_cast<ReturnType>(record.return_type),
+                            static_cast<SymbolType>(record.symbol_type), static_cast<ssize_t>(record.size));
+        if ((record.is_function ? table.addFunction(symbol) : table.addSymbol(symbol, record.function)) != id) {
+            logger.error(-1) << "Intermediate code file has a symbol " << id << " outside of any function\n";
+            return false;
+        }
+    }
+
+    icode.clear();
+    icode.setProgramName(getProgramName());
+    icode.setStatements(getStatements(), getStatementCount());
+    return true;
+}
@@ -16,3 +16,14 @@ intermediate::Intermediate intermediate::generate(const SyntaxTree& tree, Symbol
     generator.postprocess(icode, table);
     return {std::move(icode), graph};
 }
+
+void intermediate::generate(const SyntaxTree& tree, SymbolTable& table, Logger& logger, Intermediate& result) {
+    ICGenerator generator(logger);
+    generator.preprocess(tree, table);
+
+    result.icode.clear();
+    generator.generateIntermediateCode(tree, table, result.icode);
+    result.graph.build(table, result.icode);
+
+    generator.postprocess(result.icode, table);
+}
@@ -0,0 +1,45 @@
+#include "constantpool.h"
+
+#include <functional>
+
+constexpr size_t ConstantPool::NONE;
+
+size_t ConstantPool::intern(const IOperandSlot& slot) {
+    if (!slot.isImmediate())
+        return NONE;
+    const auto inserted = ids.emplace(slot, constants.size());
+    if (inserted.second) {
+        constants.push_back(slot);
+        operands.emplace_back();
+    }
+    return inserted.first->second;
+}
+
+size_t ConstantPool::find(const IOperandSlot& slot) const {
+    const auto it = ids.find(slot);
+    return it == ids.end() ? NONE : it->second;
+}
+
+const IOperandSlot& ConstantPool::get(size_t id) const {
+    return constants[id];
+}
+
+const std::shared_ptr<const IOperand>& ConstantPool::operand(size_t id) const {
+    if (!operands[id])
+        operands[id] = constants[id].toOperand();
+    return operands[id];
+}
+
+size_t ConstantPool::size() const {
+    return constants.size();
+}
+
+void ConstantPool::clear() {
+    constants.clear();
+    operands.clear();
+    ids.clear();
+}
+
+size_t ConstantPool::Hash::operator()(const IOperandSlot& slot) const {
+    return std::hash<uint64_t>()(slot.value) ^ (static_cast<size_t>(slot.kind) << 8 | static_cast<size_t>(slot.rt)) * 0x9e3779b97f4a7c15ull;
+}
@@ -0,0 +1,495 @@
+#include "constantfolder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include <syntaxtree.h>
+
+namespace {
+    inline bool is_integer(ReturnType rt) {
+        return rt == RT_INT || rt == RT_INT8 || rt == RT_UINT || rt == RT_UINT8;
+    }
+
+    inline bool is_signed(ReturnType rt) {
+        return rt == RT_INT || rt == RT_INT8;
+    }
+
+    // Wraps `value` around to the range of `rt`, just like the machine does.
+    int64_t wrap(ReturnType rt, uint64_t value) {
+        switch (rt) {
+            case RT_INT8:
+                return static_cast<int8_t>(static_cast<uint8_t>(value));
+            case RT_UINT8:
+                return static_cast<uint8_t>(value);
+            case RT_INT:
+                return static_cast<int32_t>(static_cast<uint32_t>(value));
+            case RT_UINT:
+                return static_cast<uint32_t>(value);
+            case RT_BOOL:
+                return value != 0;
+            default:
+                return static_cast<int64_t>(value);
+        }
+    }
+
+    bool constant_value(const Node* node, int64_t& value) {
+        switch (node->getKind()) {
+            case NK_CONST_INT8:
+                value = static_cast<const ConstantNode<int8_t>*>(node)->getValue();
+                return true;
+            case NK_CONST_UINT8:
+                value = static_cast<const ConstantNode<uint8_t>*>(node)->getValue();
+                return true;
+            case NK_CONST_INT:
+                value = static_cast<const ConstantNode<int>*>(node)->getValue();
+                return true;
+            case NK_CONST_UNSIGNED:
+                value = static_cast<const ConstantNode<unsigned>*>(node)->getValue();
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    Node* make_constant(ReturnType rt, int64_t value) {
+        switch (rt) {
+            case RT_INT8:
+                return SyntaxTree::createNumNode<int8_t>(static_cast<int8_t>(value), rt);
+            case RT_UINT8:
+                return SyntaxTree::createNumNode<uint8_t>(static_cast<uint8_t>(value), rt);
+            case RT_INT:
+                return SyntaxTree::createNumNode<int>(static_cast<int>(value), rt);
+            case RT_UINT:
+                return SyntaxTree::createNumNode<unsigned>(static_cast<unsigned>(value), rt);
+            default:
+                return nullptr;
+        }
+    }
+
+    size_t child_count(const Node* node) {
+        switch (node->getKind()) {
+            case NK_UNARY:
+                return 1;
+            case NK_BINARY:
+                return 2;
+            case NK_LIST:
+                return static_cast<const ListNode*>(node)->size();
+            default:
+                return 0;
+        }
+    }
+
+    Node* child_at(Node* node, size_t index) {
+        switch (node->getKind()) {
+            case NK_UNARY:
+                return static_cast<UnaryNode*>(node)->getChild();
+            case NK_BINARY:
+                return index == 0 ? static_cast<BinaryNode*>(node)->getLeftChild() : static_cast<BinaryNode*>(node)->getRightChild();
+            default:
+                return static_cast<ListNode*>(node)->getChild(index);
+        }
+    }
+
+    void set_child_at(Node* node, size_t index, Node* child) {
+        switch (node->getKind()) {
+            case NK_UNARY:
+                static_cast<UnaryNode*>(node)->setChild(child);
+                break;
+            case NK_BINARY:
+                (index == 0 ? static_cast<BinaryNode*>(node)->setLeftChild(child) : static_cast<BinaryNode*>(node)->setRightChild(child));
+                break;
+            default:
+                static_cast<ListNode*>(node)->setChild(index, child);
+                break;
+        }
+    }
+
+    // Deletes a replaced node. Nodes in an arena may be shared with other parents (see SyntaxTree::HashConsing), and need
+    // no destruction: their arena frees them.
+    void discard(Node* node) {
+        if (!ArenaAllocated::in_arena(node))
+            delete node;
+    }
+
+    // The value of an operand of an expression, if it is constant
+    struct Operand {
+        bool constant = false;
+        int64_t value = 0;
+    };
+
+    // Stores the operands of the unary or binary `node` (which has both children) in `operands`, and returns their number.
+    size_t operands_of(const Node* node, const Node* (&operands)[2]) {
+        if (const auto* unary = node_cast<const UnaryNode>(node)) {
+            operands[0] = unary->getChild();
+            return 1;
+        }
+        const auto* binary = node_cast<const BinaryNode>(node);
+        if (!binary || !binary->getLeftChild() || !binary->getRightChild())
+            return 0;
+        operands[0] = binary->getLeftChild();
+        operands[1] = binary->getRightChild();
+        return 2;
+    }
+
+    // Computes the value of the operator `expr`, of return type RT_BOOL or an integer type, from its `operands`.
+    bool evaluate_operator(const Node* expr, const Operand (&operands)[2], int64_t& value) {
+        const ReturnType rt = expr->getReturnType();
+        if (expr->getKind() == NK_UNARY) {
+            if (!operands[0].constant)
+                return false;
+            const int64_t v = operands[0].value;
+            switch (expr->getNodeType()) {
+                case NODE_NOT:
+                    value = !v;
+                    return rt == RT_BOOL;
+                case NODE_SIGNPLUS:
+                case NODE_COERCION:
+                    value = wrap(rt, static_cast<uint64_t>(v));
+                    return is_integer(rt);
+                case NODE_SIGNMINUS:
+                    value = wrap(rt, 0 - static_cast<uint64_t>(v));
+                    return is_integer(rt);
+                default:
+                    return false;
+            }
+        }
+
+        const auto* binary = node_as<const BinaryNode>(expr);
+        const Node* lhs = binary->getLeftChild();
+        const Node* rhs = binary->getRightChild();
+        const bool lconst = operands[0].constant;
+        const bool rconst = operands[1].constant;
+        const int64_t l = operands[0].value;
+        const int64_t r = operands[1].value;
+
+        // Absorbing elements make the result constant, as long as we drop no side effects (x * 0, x % 1, x && false, x || true).
+        switch (expr->getNodeType()) {
+            case NODE_MUL:
+                if ((lconst && l == 0 && ConstantFolder::is_pure(rhs)) || (rconst && r == 0 && ConstantFolder::is_pure(lhs))) {
+                    value = 0;
+                    return is_integer(rt);
+                }
+                break;
+            case NODE_MOD:
+                if (rconst && r == 1 && ConstantFolder::is_pure(lhs)) {
+                    value = 0;
+                    return is_integer(rt);
+                }
+                break;
+            case NODE_AND:
+                if ((lconst && !l && ConstantFolder::is_pure(rhs)) || (rconst && !r && ConstantFolder::is_pure(lhs))) {
+                    value = 0;
+                    return rt == RT_BOOL;
+                }
+                break;
+            case NODE_OR:
+                if ((lconst && l && ConstantFolder::is_pure(rhs)) || (rconst && r && ConstantFolder::is_pure(lhs))) {
+                    value = 1;
+                    return rt == RT_BOOL;
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (!lconst || !rconst || lhs->getReturnType() != rhs->getReturnType())
+            return false;
+        switch (expr->getNodeType()) {
+            case NODE_REL_EQUAL:
+                value = l == r;
+                return rt == RT_BOOL;
+            case NODE_REL_LT:
+                value = l < r;
+                return rt == RT_BOOL;
+            case NODE_REL_GT:
+                value = l > r;
+                return rt == RT_BOOL;
+            case NODE_REL_LTE:
+                value = l <= r;
+                return rt == RT_BOOL;
+            case NODE_REL_GTE:
+                value = l >= r;
+                return rt == RT_BOOL;
+            case NODE_REL_NOTEQUAL:
+                value = l != r;
+                return rt == RT_BOOL;
+            case NODE_AND:
+                value = l && r;
+                return rt == RT_BOOL;
+            case NODE_OR:
+                value = l || r;
+                return rt == RT_BOOL;
+            case NODE_ADD:
+                value = wrap(rt, static_cast<uint64_t>(l) + static_cast<uint64_t>(r));
+                return is_integer(rt);
+            case NODE_SUB:
+                value = wrap(rt, static_cast<uint64_t>(l) - static_cast<uint64_t>(r));
+                return is_integer(rt);
+            case NODE_MUL:
+                value = wrap(rt, static_cast<uint64_t>(l) * static_cast<uint64_t>(r));
+                return is_integer(rt);
+            case NODE_DIV:
+            case NODE_IDIV:
+            case NODE_MOD: {
+                // Division by zero, and the overflowing signed division (e.g. INT_MIN / -1), trap at run time. We leave those alone.
+                if (!is_integer(rt) || r == 0)
+                    return false;
+                const int64_t quotient = l / r;
+                if (is_signed(rt) && wrap(rt, static_cast<uint64_t>(quotient)) != quotient)
+                    return false;
+                value = wrap(rt, static_cast<uint64_t>(expr->getNodeType() == NODE_MOD ? l % r : quotient));
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+void ConstantFolder::fold(Node* root) {
+    Node* folded = fold_statement(root);
+    (void) folded;
+    assert(folded == root);
+}
+
+Node* ConstantFolder::fold_statement(Node* stmt) {
+    if (!stmt)
+        return stmt;
+    switch (stmt->getNodeType()) {
+        case NODE_STATEMENT_LIST: {
+            auto* list = node_as<ListNode>(stmt);
+            for (size_t x = 0; x < list->size(); ++x)
+                list->setChild(x, fold_statement(list->getChild(x)));
+            return list;
+        }
+        case NODE_ASSIGNMENT: {
+            auto* assignment = node_as<BinaryNode>(stmt);
+            assignment->setLeftChild(fold_expr(assignment->getLeftChild()));
+            assignment->setRightChild(fold_expr(assignment->getRightChild()));
+            return assignment;
+        }
+        case NODE_IF: {
+            auto* ifNode = node_as<BinaryNode>(stmt);
+            ifNode->setLeftChild(fold_expr(ifNode->getLeftChild()));
+            BinaryNode* ifTargets = nullptr;
+            if (ifNode->getRightChild() && ifNode->getRightChild()->getNodeType() == NODE_IF_TARGETS) {
+                ifTargets = node_as<BinaryNode>(ifNode->getRightChild());
+                ifTargets->setLeftChild(fold_statement(ifTargets->getLeftChild()));
+                ifTargets->setRightChild(fold_statement(ifTargets->getRightChild()));
+                ifNode->setRightChild(ifTargets);
+            } else {
+                ifNode->setRightChild(fold_statement(ifNode->getRightChild()));
+            }
+
+            int64_t condition;
+            if (!evaluate(ifNode->getLeftChild(), condition))
+                return ifNode;
+            Node* taken;
+            if (ifTargets) {
+                taken = condition ? ifTargets->getLeftChild() : ifTargets->getRightChild();
+                (condition ? ifTargets->setLeftChild(nullptr) : ifTargets->setRightChild(nullptr));
+            } else if (condition) {
+                taken = ifNode->getRightChild();
+                ifNode->setRightChild(nullptr);
+            } else {
+                taken = SyntaxTree::createLeaf();
+            }
+            discard(ifNode);
+            return taken;
+        }
+        case NODE_WHILE: {
+            auto* whileNode = node_as<BinaryNode>(stmt);
+            whileNode->setLeftChild(fold_expr(whileNode->getLeftChild()));
+            whileNode->setRightChild(fold_statement(whileNode->getRightChild()));
+
+            int64_t condition;
+            if (evaluate(whileNode->getLeftChild(), condition) && !condition) {
+                discard(whileNode);
+                return SyntaxTree::createLeaf();
+            }
+            return whileNode;
+        }
+        case NODE_FUNCTIONCALL:
+            return fold_expr(stmt);
+        case NODE_RETURN: {
+            auto* returnNode = node_as<UnaryNode>(stmt);
+            returnNode->setChild(fold_expr(returnNode->getChild()));
+            return returnNode;
+        }
+        default:
+            return stmt;
+    }
+}
+
+Node* ConstantFolder::fold_expr(Node* expr) {
+    // Operands first, with a heap-allocated work stack: expressions can nest deeper than the native stack allows.
+    struct Frame {
+        Node* node;
+        size_t next; // Index of the next child to fold
+    };
+    std::vector<Frame> stack;
+    if (expr)
+        stack.push_back({expr, 0});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next < child_count(frame.node)) {
+            if (Node* child = child_at(frame.node, frame.next++))
+                stack.push_back({child, 0});
+            continue;
+        }
+        Node* node = frame.node;
+        stack.pop_back();
+        Node* folded = node->getKind() == NK_UNARY || node->getKind() == NK_BINARY ? fold_operator(node) : node;
+        if (stack.empty())
+            return folded;
+        // Also when `node` stayed: its fingerprint may have changed with its children (see Node::getFingerprint).
+        set_child_at(stack.back().node, stack.back().next - 1, folded);
+    }
+    return expr;
+}
+
+Node* ConstantFolder::fold_operator(Node* expr) {
+    const ReturnType rt = expr->getReturnType();
+    int64_t value;
+    if (is_integer(rt) && evaluate(expr, value)) {
+        discard(expr);
+        return make_constant(rt, value);
+    }
+
+    // Identities. The remaining operand must have the type of the whole expression.
+    if (auto* unary = node_cast<UnaryNode>(expr)) {
+        if (expr->getNodeType() == NODE_SIGNPLUS && unary->getChild() && unary->getChild()->getReturnType() == rt)
+            return replace_with_child(expr, unary->getChild());
+        return expr;
+    }
+    auto* binary = node_as<BinaryNode>(expr);
+    Node* lhs = binary->getLeftChild();
+    Node* rhs = binary->getRightChild();
+    if (!lhs || !rhs)
+        return expr;
+    int64_t l, r;
+    const bool lkeep = lhs->getReturnType() == rt && evaluate(rhs, r);
+    const bool rkeep = rhs->getReturnType() == rt && evaluate(lhs, l);
+    switch (expr->getNodeType()) {
+        case NODE_ADD: // x + 0, 0 + x
+        case NODE_OR:  // x || false, false || x
+            if (lkeep && r == 0)
+                return replace_with_child(expr, lhs);
+            if (rkeep && l == 0)
+                return replace_with_child(expr, rhs);
+            break;
+        case NODE_MUL: // x * 1, 1 * x
+        case NODE_AND: // x && true, true && x
+            if (lkeep && r == 1)
+                return replace_with_child(expr, lhs);
+            if (rkeep && l == 1)
+                return replace_with_child(expr, rhs);
+            break;
+        case NODE_SUB: // x - 0
+            if (lkeep && r == 0)
+                return replace_with_child(expr, lhs);
+            break;
+        case NODE_DIV: // x / 1
+        case NODE_IDIV:
+            if (is_integer(rt) && lkeep && r == 1)
+                return replace_with_child(expr, lhs);
+            break;
+        default:
+            break;
+    }
+    return expr;
+}
+
+bool ConstantFolder::evaluate(const Node* expr, int64_t& value) const {
+    // Integer operands are folded already, so they are constant iff they are a NODE_NUM. Boolean operands never are,
+    // so those we evaluate first, children before their parents, with a heap-allocated work stack like fold_expr.
+    struct Frame {
+        const Node* node;
+        const Node* children[2];
+        size_t count;
+        // Operands evaluated so far
+        size_t next;
+        Operand operands[2];
+    };
+    std::vector<Frame> stack;
+    const auto push = [&stack](const Node* node) {
+        stack.emplace_back(); // Value-initialized: no operands yet
+        Frame& frame = stack.back();
+        frame.node = node;
+        const ReturnType rt = node->getReturnType();
+        if (node->getNodeType() != NODE_NUM && (rt == RT_BOOL || is_integer(rt)))
+            frame.count = operands_of(node, frame.children);
+    };
+    if (!expr)
+        return false;
+    push(expr);
+    Operand result;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.next < frame.count) {
+            const Node* child = frame.children[frame.next];
+            if (child && child->getReturnType() == RT_BOOL) {
+                push(child);
+                continue;
+            }
+            Operand& operand = frame.operands[frame.next++];
+            operand.constant = child && child->getNodeType() == NODE_NUM && constant_value(child, operand.value);
+            continue;
+        }
+        const Node* node = frame.node;
+        if (node->getNodeType() == NODE_NUM)
+            result.constant = constant_value(node, result.value);
+        else
+            result.constant = frame.count != 0 && evaluate_operator(node, frame.operands, result.value);
+        stack.pop_back();
+        if (!stack.empty())
+            stack.back().operands[stack.back().next++] = result;
+    }
+    if (result.constant)
+        value = result.value;
+    return result.constant;
+}
+
+bool ConstantFolder::is_pure(const Node* expr) {
+    // With a heap-allocated work stack, like fold_expr
+    std::vector<const Node*> stack{expr};
+    while (!stack.empty()) {
+        const Node* node = stack.back();
+        stack.pop_back();
+        if (!node)
+            return false;
+        switch (node->getKind()) {
+            case NK_UNARY:
+                if (node->getReturnType() == RT_ERROR)
+                    return false;
+                stack.push_back(static_cast<const UnaryNode*>(node)->getChild());
+                break;
+            case NK_BINARY:
+                if (node->getReturnType() == RT_ERROR || node->getNodeType() == NODE_FUNCTIONCALL)
+                    return false;
+                stack.push_back(static_cast<const BinaryNode*>(node)->getLeftChild());
+                stack.push_back(static_cast<const BinaryNode*>(node)->getRightChild());
+                break;
+            case NK_LIST:
+                stack.insert(stack.end(), static_cast<const ListNode*>(node)->getChildren().begin(), static_cast<const ListNode*>(node)->getChildren().end());
+                break;
+            default:
+                if (node->getReturnType() == RT_ERROR)
+                    return false;
+                break;
+        }
+    }
+    return true;
+}
+
+Node* ConstantFolder::replace_with_child(Node* expr, Node* keep) {
+    if (ArenaAllocated::in_arena(expr)) // May be shared, so it must stay intact (see discard)
+        return keep;
+    if (auto* unary = node_cast<UnaryNode>(expr)) {
+        unary->setChild(nullptr);
+    } else if (auto* binary = node_cast<BinaryNode>(expr)) {
+        (binary->getLeftChild() == keep ? binary->setLeftChild(nullptr) : binary->setRightChild(nullptr));
+    }
+    delete expr;
+    return keep;
+}
@@ -0,0 +1,44 @@
+#ifndef COCO_FRAMEWORK_INTERMEDIATECODE_CONSTANTFOLDER
+#define COCO_FRAMEWORK_INTERMEDIATECODE_CONSTANTFOLDER
+
+#include <cstdint>
+#include <node.h>
+#include <types.h>
+
+/**
+ * Folds constant expressions and applies algebraic identities on a syntax tree, in place.
+ * Integer results wrap around to the return type of the folded node (int8, uint8, int or unsigned).
+ * Boolean expressions have no constant node, so a constant condition folds its if- or while-statement away instead.
+ * Replaced nodes are deleted, unless they live in an arena (where they may be shared).
+ */
+class ConstantFolder {
+    public:
+    // Folds the statement tree of a function. The root itself (a NODE_STATEMENT_LIST or NODE_EMPTY) is never replaced.
+    void fold(Node* root);
+
+    // Folds a statement. Returns the node that replaces `stmt` (possibly `stmt` itself).
+    Node* fold_statement(Node* stmt);
+
+    // Folds an expression. Returns the node that replaces `expr` (possibly `expr` itself).
+    Node* fold_expr(Node* expr);
+
+    /**
+     * Computes the value of a constant expression.
+     * @param expr Expression to compute, with its integer subexpressions already folded.
+     * @param value Receives the value (0 or 1 for RT_BOOL) on success.
+     * @return `true` if `expr` is constant, `false` otherwise.
+     */
+    bool evaluate(const Node* expr, int64_t& value) const;
+
+    // Returns whether evaluating `expr` has no side effects (i.e. it calls no functions).
+    static bool is_pure(const Node* expr);
+
+    private:
+    // Folds `expr`, a unary or binary node of which the operands are folded already.
+    Node* fold_operator(Node* expr);
+
+    // Replaces `expr` with its child `keep`, which is detached first (unless `expr` lives in an arena).
+    static Node* replace_with_child(Node* expr, Node* keep);
+};
+
+#endif
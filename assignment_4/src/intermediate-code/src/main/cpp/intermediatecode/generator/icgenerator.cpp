@@ -1,23 +1,31 @@
 #include "icgenerator.h"
+#include "folding/constantfolder.h"
 #include "visitor/icvisitor.h"
 #include <memory>
 #include <utility.h>
 #include <algorithm>
 
-// Note: use this for assignment 5
-void ICGenerator::preprocess(const SyntaxTree& /*tree*/, SymbolTable& /*table*/) {}
+// Folds constant expressions in every function body. Nodes are replaced in place, below the (unchanging) function roots.
+void ICGenerator::preprocess(const SyntaxTree& tree, SymbolTable& table) {
+    ConstantFolder folder;
+    for (size_t id: table.getFunctions())
+        folder.fold(tree.getRoot(id));
+}
 
 // Takes a SyntaxTree and converts it into an IntermediateCode structure.
 IntermediateCode ICGenerator::generateIntermediateCode(const SyntaxTree& tree, SymbolTable& table) {
     IntermediateCode icode(logger);
+    generateIntermediateCode(tree, table, icode);
+    return icode;
+}
+
+void ICGenerator::generateIntermediateCode(const SyntaxTree& tree, SymbolTable& table, IntermediateCode& icode) {
     ICVisitor visitor(table, icode);
 
     auto ids = table.getFunctions();
     std::sort(ids.begin(), ids.end());
     for (size_t id: ids)
         visitor.visit_function(id, tree.getRoot(id));
-
-    return icode;
 }
 
 // Note: use this for assignment 5
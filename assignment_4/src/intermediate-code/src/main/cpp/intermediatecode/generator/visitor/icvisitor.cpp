@@ -11,20 +11,123 @@
 #include <symbol.h>
 #include <to_string.h>
 
-ICVisitor::IOperandPtr ICVisitor::createImmediateIOperand(Node* node) {
-    // TODO: implement me
-    return nullptr;
+namespace {
+    // Whether all operands of `expr` are evaluated, before the operator itself, unlike those of && and || or a function call.
+    bool eager(const Node* expr) {
+        switch (expr->getNodeType()) {
+            case NODE_RARRAY:
+            case NODE_REL_EQUAL:
+            case NODE_REL_LT:
+            case NODE_REL_GT:
+            case NODE_REL_LTE:
+            case NODE_REL_GTE:
+            case NODE_REL_NOTEQUAL:
+            case NODE_ADD:
+            case NODE_SUB:
+            case NODE_MUL:
+            case NODE_DIV:
+            case NODE_IDIV:
+            case NODE_MOD:
+            case NODE_NOT:
+            case NODE_SIGNPLUS:
+            case NODE_SIGNMINUS:
+            case NODE_COERCION:
+                return expr->getKind() == NK_UNARY || expr->getKind() == NK_BINARY;
+            default:
+                return false;
+        }
+    }
+
+    size_t operand_count(const Node* node) {
+        switch (node->getKind()) {
+            case NK_UNARY:
+                return 1;
+            case NK_BINARY:
+                return 2;
+            case NK_LIST:
+                return static_cast<const ListNode*>(node)->size();
+            default:
+                return 0;
+        }
+    }
+
+    // The operand (child) at `index` of `node`, or `nullptr` if there is none.
+    Node* operand_at(const Node* node, size_t index) {
+        switch (node->getKind()) {
+            case NK_UNARY:
+                return index == 0 ? static_cast<const UnaryNode*>(node)->getChild() : nullptr;
+            case NK_BINARY:
+                if (index > 1)
+                    return nullptr;
+                return index == 0 ? static_cast<const BinaryNode*>(node)->getLeftChild() : static_cast<const BinaryNode*>(node)->getRightChild();
+            case NK_LIST:
+                return index < static_cast<const ListNode*>(node)->size() ? static_cast<const ListNode*>(node)->getChild(index) : nullptr;
+            default:
+                return nullptr;
+        }
+    }
+}
+
+IOperandSlot ICVisitor::immediate_operand(const Node* node) {
+    switch (node->getKind()) {
+        case NK_CONST_INT8:
+            return IOperandSlot::immediate(static_cast<const ConstantNode<int8_t>*>(node)->getValue(), node->getReturnType());
+        case NK_CONST_UINT8:
+            return IOperandSlot::immediate(static_cast<const ConstantNode<uint8_t>*>(node)->getValue(), node->getReturnType());
+        case NK_CONST_INT:
+            return IOperandSlot::immediate(static_cast<const ConstantNode<int>*>(node)->getValue(), node->getReturnType());
+        case NK_CONST_UNSIGNED:
+            return IOperandSlot::immediate(static_cast<const ConstantNode<unsigned>*>(node)->getValue(), node->getReturnType());
+        default:
+            return IOperandSlot();
+    }
 }
 
 ICVisitor::ICVisitor(SymbolTable& symtab, IntermediateCode& icode) : symtab(symtab), icode(icode), temporaries(0), labels(0) {}
 
-void ICVisitor::emit(IOperatorType type, IOperator op, const std::shared_ptr<IOperand>& opnd1, const std::shared_ptr<IOperand>& opnd2, const std::shared_ptr<IOperand>& res) {
-    icode.appendStatement(new IStatement(type, op, opnd1, opnd2, res));
+void ICVisitor::emit(IOperatorType type, IOperator op, const IOperandSlot& opnd1, const IOperandSlot& opnd2, const IOperandSlot& res) {
+    switch (op) {
+        case IOP_FUNC:
+        case IOP_LABEL:
+        case IOP_FUNCCALL:
+        case IOP_ASSIGN:
+        case IOP_LARRAY:
+            values.clear();
+            break;
+        default:
+            break;
+    }
+    icode.appendStatement(IStatement(type, op, opnd1, opnd2, res));
+}
+
+void ICVisitor::emit(IOperatorType type, IOperator op, const std::shared_ptr<const IOperand>& opnd1, const std::shared_ptr<const IOperand>& opnd2, const std::shared_ptr<const IOperand>& res) {
+    emit(type, op, IOperandSlot::of(opnd1.get()), IOperandSlot::of(opnd2.get()), IOperandSlot::of(res.get()));
+}
+
+IOperandSlot ICVisitor::reuse_value(const Node* expr) const {
+    // Equal expressions have equal fingerprints, unless one went stale (see Node::getFingerprint): then we only miss a reuse.
+    auto range = values.equal_range(expr->getFingerprint());
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second.expr->equal_to(*expr, &symtab, &symtab))
+            return IOperandSlot::symbol(it->second.temporary, it->second.rt);
+    return IOperandSlot();
+}
+
+void ICVisitor::remember_value(const Node* expr, const IOperandSlot& result) {
+    if (!result.isSymbol())
+        return;
+    const Symbol* symbol = symtab.getSymbol(result.getId());
+    if (symbol && symbol->getSymbolType() == ST_TEMPVAR)
+        values.emplace(expr->getFingerprint(), Value{expr, result.getId(), result.rt});
 }
 
 ICVisitor::ISymbolOpPtr ICVisitor::make_temporary(ReturnType rt) {
+    return std::make_unique<SymbolIOperand>(temporary(rt).getId(), rt);
+}
+
+IOperandSlot ICVisitor::temporary(ReturnType rt) {
     size_t id = symtab.addTempvar(rt, "&" + std::to_string(temporaries++), function_stack.back());
-    return std::make_unique<SymbolIOperand>(id, rt);
+    return IOperandSlot::symbol(id, rt);
 }
 
 ICVisitor::ISymbolOpPtr ICVisitor::make_label() {
@@ -34,13 +137,155 @@ ICVisitor::ISymbolOpPtr ICVisitor::make_label() {
     return std::make_unique<SymbolIOperand>(id, RT_VOID);
 }
 
+// Dispatch is a switch on the NodeType. types.h fixes the node class for every NodeType handled below, so we static_cast (node_as).
 void ICVisitor::accept(Node* node) {
-    // TODO: implement me
+    if (!node)
+        return;
+    values.clear();
+    switch (node->getNodeType()) {
+        case NODE_STATEMENT_LIST:
+            for (auto* stmt: node_as<ListNode>(node)->getChildren())
+                accept(stmt);
+            break;
+        case NODE_ASSIGNMENT: {
+            auto* assignment = node_as<BinaryNode>(node);
+            visit_assignment(assignment->getLeftChild(), assignment->getRightChild());
+            break;
+        }
+        case NODE_IF: {
+            auto* ifNode = node_as<BinaryNode>(node);
+            Node* targets = ifNode->getRightChild();
+            if (targets->getNodeType() == NODE_IF_TARGETS) {
+                auto* ifTargets = node_as<BinaryNode>(targets);
+                visit_if_else(ifNode->getLeftChild(), ifTargets->getLeftChild(), ifTargets->getRightChild());
+            } else {
+                visit_if_else(ifNode->getLeftChild(), targets, nullptr);
+            }
+            break;
+        }
+        case NODE_WHILE: {
+            auto* whileNode = node_as<BinaryNode>(node);
+            visit_while(whileNode->getLeftChild(), whileNode->getRightChild());
+            break;
+        }
+        case NODE_FUNCTIONCALL:
+            visit_func_call(node_as<BinaryNode>(node));
+            break;
+        case NODE_RETURN:
+            visit_return(node_as<UnaryNode>(node)->getChild());
+            break;
+        default: // NODE_EMPTY, error nodes and expressions without side effects generate no code.
+            break;
+    }
 }
 
 ICVisitor::IOperandPtr ICVisitor::accept_expr(Node* expr) {
-    // TODO: implement me
-    return nullptr;
+    return accept_operand(expr).makeOperand();
+}
+
+IOperandSlot ICVisitor::accept_operand(Node* expr) {
+    if (!expr)
+        return IOperandSlot();
+    if (!eager(expr))
+        return dispatch_expr(expr);
+    // A value is only remembered for a pure expression, and an expression equal to it is just as pure.
+    IOperandSlot reused = reuse_value(expr);
+    if (!reused.empty())
+        return reused;
+    const size_t bottom = expr_stack.size();
+    expr_stack.push_back({expr, 0, expr_values.size(), expr->getReturnType() != RT_ERROR});
+    for (;;) {
+        ExprFrame& frame = expr_stack.back();
+        if (frame.next < operand_count(frame.node)) {
+            Node* operand = operand_at(frame.node, frame.next++);
+            if (operand && eager(operand)) {
+                IOperandSlot value = reuse_value(operand);
+                if (!value.empty())
+                    expr_values.push_back(value);
+                else
+                    expr_stack.push_back({operand, 0, expr_values.size(), operand->getReturnType() != RT_ERROR});
+                continue;
+            }
+            // Leaves are pure. Calls, `&&` and `||` generate their own code, and are not reused.
+            const bool pure = operand && operand_count(operand) == 0;
+            const IOperandSlot value = operand ? dispatch_expr(operand) : IOperandSlot(); // May call accept_expr, which moves `frame`
+            expr_stack.back().pure = expr_stack.back().pure && pure;
+            expr_values.push_back(value);
+            continue;
+        }
+        const ExprFrame done = frame;
+        expr_stack.pop_back();
+        const IOperandSlot result = emit_operator(done.node, expr_values.data() + done.base);
+        expr_values.resize(done.base);
+        if (done.pure)
+            remember_value(done.node, result);
+        if (expr_stack.size() == bottom)
+            return result;
+        expr_stack.back().pure = expr_stack.back().pure && done.pure;
+        expr_values.push_back(result);
+    }
+}
+
+IOperandSlot ICVisitor::emit_operator(Node* expr, const IOperandSlot* operands) {
+    const size_t count = operand_count(expr);
+    for (size_t x = 0; x < count; ++x)
+        if (operands[x].empty())
+            return IOperandSlot();
+    const ReturnType rt = expr->getReturnType();
+    IOperatorType type = util::to_iopt(rt);
+    IOperator op;
+    switch (expr->getNodeType()) {
+        case NODE_SIGNPLUS: // +x is x
+            return operands[0];
+        case NODE_NOT: op = IOP_NOT; break;
+        case NODE_SIGNMINUS: op = IOP_UNARY_MINUS; break;
+        case NODE_COERCION: op = IOP_COERCE; break;
+        case NODE_RARRAY: op = IOP_RARRAY; break;
+        case NODE_ADD: op = IOP_ADD; break;
+        case NODE_SUB: op = IOP_SUB; break;
+        case NODE_MUL: op = IOP_MUL; break;
+        case NODE_DIV: op = types::isSigned(rt) ? IOP_IDIV : IOP_DIV; break;
+        case NODE_IDIV: op = IOP_IDIV; break;
+        case NODE_MOD: op = types::isSigned(rt) ? IOP_IMOD : IOP_MOD; break;
+        default: {
+            // Comparisons have the type of their operands, and set a bool.
+            const ReturnType operand_rt = operands[0].rt;
+            const bool is_signed = types::isSigned(operand_rt);
+            type = util::to_iopt(operand_rt);
+            switch (expr->getNodeType()) {
+                case NODE_REL_EQUAL: op = IOP_SETE; break;
+                case NODE_REL_NOTEQUAL: op = IOP_SETNE; break;
+                case NODE_REL_LT: op = is_signed ? IOP_SETL : IOP_SETB; break;
+                case NODE_REL_GT: op = is_signed ? IOP_SETG : IOP_SETA; break;
+                case NODE_REL_LTE: op = is_signed ? IOP_SETLE : IOP_SETBE; break;
+                case NODE_REL_GTE: op = is_signed ? IOP_SETGE : IOP_SETNB; break;
+                default: return IOperandSlot();
+            }
+            break;
+        }
+    }
+    const IOperandSlot result = temporary(rt);
+    emit(type, op, operands[0], count > 1 ? operands[1] : IOperandSlot(), result);
+    return result;
+}
+
+IOperandSlot ICVisitor::dispatch_expr(Node* expr) {
+    // The other operators are handled by accept_expr (see `eager`). The visit functions still return operand objects.
+    switch (expr->getNodeType()) {
+        case NODE_NUM:
+            return immediate_operand(expr);
+        case NODE_ID:
+            return IOperandSlot::symbol(node_as<SymbolNode>(expr)->getSymbolId(), expr->getReturnType());
+        case NODE_LARRAY:
+            return IOperandSlot::of(visit_larray_access(node_as<BinaryNode>(expr)).get());
+        case NODE_FUNCTIONCALL:
+            return IOperandSlot::of(visit_func_call(node_as<BinaryNode>(expr)).get());
+        case NODE_OR:
+        case NODE_AND:
+            return IOperandSlot::of(visit_binary_op(node_as<BinaryNode>(expr)).get());
+        default: // Statements, NODE_EMPTY, error nodes and malformed operators are no expressions.
+            return IOperandSlot();
+    }
 }
 
 void ICVisitor::visit_function(size_t id, Node* root) {
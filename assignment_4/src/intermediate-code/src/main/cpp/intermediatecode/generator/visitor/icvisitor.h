@@ -4,7 +4,10 @@
 #include "intermediatecode.h"
 #include "ioperand.h"
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include <node.h>
 #include <symboltable.h>
 #include <types.h>
@@ -20,17 +23,56 @@ class ICVisitor {
     size_t temporaries, labels;
     std::vector<size_t> function_stack;
 
+    // A temporary holding the value of an expression without side effects.
+    struct Value {
+        const Node* expr;
+        size_t temporary;
+        ReturnType rt;
+    };
+    // Values computed in the current statement, since the last label, call or store. Any of those may change them,
+    // or (a label) be reached from code that did not compute them. By fingerprint of their expression.
+    std::unordered_multimap<uint64_t, Value> values;
+
+    // An operator of which accept_expr is computing the operands.
+    struct ExprFrame {
+        Node* node;
+        size_t next; // Index of the next operand
+        size_t base; // Index of the first operand in `expr_values`
+        bool pure;   // Whether the operands computed so far have no side effects
+    };
+    // Work stack and computed operands of accept_expr. Kept across calls for their capacity; visit functions called
+    // from accept_expr may call it again, which works on top of the entries of the outer call.
+    std::vector<ExprFrame> expr_stack;
+    std::vector<IOperandSlot> expr_values;
+
     //helper function
-    static IOperandPtr createImmediateIOperand(Node* node);
+    static IOperandSlot immediate_operand(const Node* node);
+
+    // Returns a temporary holding the value of `expr`, if it was computed before in this statement, or an empty slot.
+    IOperandSlot reuse_value(const Node* expr) const;
+    // Remembers that `result` holds the value of `expr`, if it is a temporary.
+    void remember_value(const Node* expr, const IOperandSlot& result);
+    // Dispatches a leaf, or an expression that generates its own code (a call, `&&` or `||`), to the visit function for its type.
+    IOperandSlot dispatch_expr(Node* expr);
+    /**
+     * Generates code for an operator of which all operands are evaluated first (see accept_expr).
+     * @param operands The values of the operands, in order; an empty slot for a missing one.
+     * @return the operand holding the result, or an empty slot if `expr` is malformed.
+     */
+    IOperandSlot emit_operator(Node* expr, const IOperandSlot* operands);
 
     public:
     ICVisitor(SymbolTable& symtab, IntermediateCode& icode);
 
     // Utility function to emit a new instruction to the intermediate code.
-    void emit(IOperatorType type, IOperator op, const std::shared_ptr<IOperand>& opnd1, const std::shared_ptr<IOperand>& opnd2, const std::shared_ptr<IOperand>& res);
+    void emit(IOperatorType type, IOperator op, const IOperandSlot& opnd1, const IOperandSlot& opnd2, const IOperandSlot& res);
+    // Like above, for operand objects. `nullptr` is no operand.
+    void emit(IOperatorType type, IOperator op, const std::shared_ptr<const IOperand>& opnd1, const std::shared_ptr<const IOperand>& opnd2, const std::shared_ptr<const IOperand>& res);
 
     // Utility function to create a new unique temporary variable, of type rt
     ISymbolOpPtr make_temporary(ReturnType rt);
+    // Like above, by value
+    IOperandSlot temporary(ReturnType rt);
 
     // Utility function to create a unique label.
     ISymbolOpPtr make_label();
@@ -39,7 +81,12 @@ class ICVisitor {
     void accept(Node* node);
 
     // Process and generate intermediate code for an expression subtree.
+    // Operators of which all operands are evaluated first are walked in postorder with a heap-allocated work stack, so
+    // they can nest arbitrarily deep, and their code is emitted right away. Calls, `&&` and `||` go to their visit function.
+    // A side-effect-free operator that was computed before in the same statement is not computed again.
     IOperandPtr accept_expr(Node* expr);
+    // Like above, returning the operand by value: allocates nothing. Empty if `expr` is no expression.
+    IOperandSlot accept_operand(Node* expr);
 
     // Process and generate intermediate code for a function.
     void visit_function(size_t id, Node* root);
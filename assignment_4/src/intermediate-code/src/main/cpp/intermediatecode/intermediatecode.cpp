@@ -1,13 +1,22 @@
 #include "intermediatecode.h"
+#include <algorithm>
 #include <utility>
 
-IntermediateCode::~IntermediateCode() {
-    for (auto& statement: statements)
-        delete statement;
+constexpr size_t IntermediateCode::REMOVED;
+
+void IntermediateCode::clear() {
+    statements.clear();
+    constants.clear();
+    interned = 0;
+    programName.clear();
+}
+
+size_t IntermediateCode::capacity() const {
+    return statements.capacity();
 }
 
 // gets the program name
-std::string IntermediateCode::getProgramName() {
+std::string IntermediateCode::getProgramName() const {
     return programName;
 }
 
@@ -21,6 +30,24 @@ unsigned IntermediateCode::getStatementCount() const {
     return statements.size();
 }
 
+ConstantPool& IntermediateCode::getConstants() {
+    internConstants();
+    return constants;
+}
+
+const ConstantPool& IntermediateCode::getConstants() const {
+    internConstants();
+    return constants;
+}
+
+std::shared_ptr<const IOperand> IntermediateCode::getOperand(const IOperandSlot& slot) const {
+    if (!slot.isImmediate())
+        return slot.toOperand();
+    internConstants();
+    const size_t id = constants.find(slot);
+    return id == ConstantPool::NONE ? slot.toOperand() : constants.operand(id);
+}
+
 // get the i-th statement
 IStatement* IntermediateCode::getStatement(unsigned i) const {
     if (i >= statements.size()) {
@@ -28,19 +55,32 @@ IStatement* IntermediateCode::getStatement(unsigned i) const {
         return nullptr;
     }
 
-    return statements[i];
+    return &statements[i];
+}
+
+void IntermediateCode::setStatements(const IStatement* first, size_t count) {
+    statements.assign(first, first + count);
+    constants.clear();
+    interned = 0;
 }
 
 // Append a statement
+void IntermediateCode::appendStatement(const IStatement& stmt) {
+    statements.push_back(stmt);
+}
+
 void IntermediateCode::appendStatement(IStatement* stmt) {
-    if (!stmt)
+    if (!stmt) {
         logger.warn(-1) << "[IntermediateCode::appendStatement()] Warning: received nullptr statement.\n";
-    statements.push_back(stmt);
+        return;
+    }
+    appendStatement(*stmt);
+    delete stmt;
 }
 
 // Insert a statement before the i-th statement
-void IntermediateCode::insertStatement(IStatement* stmt, unsigned i) {
-    std::vector<IStatement*>::iterator iter;
+void IntermediateCode::insertStatement(const IStatement& stmt, unsigned i) {
+    std::vector<IStatement>::iterator iter;
 
     if (i > statements.size()) {
         logger.error(-1) << "[IntermediateCode::insertStatement()] Error: parameter i > statement list size.\n";
@@ -49,11 +89,32 @@ void IntermediateCode::insertStatement(IStatement* stmt, unsigned i) {
 
     iter = statements.begin() + i;
     statements.insert(iter, stmt);
+    interned = std::min<size_t>(interned, i);
+}
+
+void IntermediateCode::insertStatement(IStatement* stmt, unsigned i) {
+    if (!stmt) {
+        logger.warn(-1) << "[IntermediateCode::insertStatement()] Warning: received nullptr statement.\n";
+        return;
+    }
+    insertStatement(*stmt, i);
+    delete stmt;
+}
+
+void IntermediateCode::internConstants() const {
+    // Constants of removed statements stay in the pool, and interning a statement again finds its constants: a pool that
+    // holds too much is still correct, so edits only have to move `interned` back to their first line.
+    for (; interned < statements.size(); ++interned) {
+        const IStatement& stmt = statements[interned];
+        constants.intern(stmt.getOperand1Slot());
+        constants.intern(stmt.getOperand2Slot());
+        constants.intern(stmt.getResultSlot());
+    }
 }
 
 // Remove the i-th statement
 void IntermediateCode::removeStatement(unsigned i) {
-    std::vector<IStatement*>::iterator iter;
+    std::vector<IStatement>::iterator iter;
 
     if (i >= statements.size()) {
         logger.error(-1) << "[IntermediateCode::removeStatement()] Error: invalid parameter i\n";
@@ -62,4 +123,60 @@ void IntermediateCode::removeStatement(unsigned i) {
 
     iter = statements.begin() + i;
     statements.erase(iter);
-}
\ No newline at end of file
+    interned = std::min<size_t>(interned, i);
+}
+
+void IntermediateCode::Edit::remove(unsigned i) {
+    if (i >= code.statements.size()) {
+        code.logger.error(-1) << "[IntermediateCode::Edit::remove()] Error: invalid parameter i\n";
+        return;
+    }
+    if (dead.empty())
+        dead.resize(code.statements.size());
+    dead[i] = true;
+}
+
+void IntermediateCode::Edit::insertBefore(unsigned i, const IStatement& stmt) {
+    if (i > code.statements.size()) {
+        code.logger.error(-1) << "[IntermediateCode::Edit::insertBefore()] Error: parameter i > statement list size.\n";
+        return;
+    }
+    insertions.push_back(Insertion{3 * static_cast<size_t>(i), stmt});
+}
+
+void IntermediateCode::Edit::insertAfter(unsigned i, const IStatement& stmt) {
+    if (i >= code.statements.size()) {
+        code.logger.error(-1) << "[IntermediateCode::Edit::insertAfter()] Error: invalid parameter i\n";
+        return;
+    }
+    insertions.push_back(Insertion{3 * static_cast<size_t>(i) + 2, stmt});
+}
+
+std::vector<size_t> IntermediateCode::Edit::commit() {
+    std::vector<IStatement>& statements = code.statements;
+    std::stable_sort(insertions.begin(), insertions.end(), [](const Insertion& a, const Insertion& b) { return a.key < b.key; });
+
+    std::vector<size_t> lines(statements.size(), REMOVED);
+    std::vector<IStatement> result;
+    result.reserve(statements.size() + insertions.size());
+    size_t unchanged = REMOVED; // Number of leading lines the edit keeps in place
+    auto insertion = insertions.begin();
+    for (size_t line = 0; line < statements.size(); ++line) {
+        for (; insertion != insertions.end() && insertion->key <= 3 * line; ++insertion)
+            result.push_back(insertion->stmt);
+        if (dead.empty() || !dead[line]) {
+            lines[line] = result.size();
+            result.push_back(statements[line]);
+        }
+        if (unchanged == REMOVED && lines[line] != line)
+            unchanged = line;
+    }
+    for (; insertion != insertions.end(); ++insertion)
+        result.push_back(insertion->stmt);
+
+    statements.swap(result);
+    code.interned = std::min(code.interned, std::min(unchanged, statements.size()));
+    dead.clear();
+    insertions.clear();
+    return lines;
+}
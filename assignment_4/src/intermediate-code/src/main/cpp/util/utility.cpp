@@ -112,29 +112,32 @@ static bool isVariable(const SymbolTable& tab, size_t id) {
 }
 
 bool iop_reads_op1(const SymbolTable& tab, IStatement* stmt) {
-    if (iop_arity(stmt->getOperator()) == 0 || stmt->getOperand1() == nullptr)
+    if (iop_arity(stmt->getOperator()) == 0)
         return false;
-    if (stmt->getOperand1()->getOperandType() != OT_SYMBOL)
+    const IOperandSlot operand = stmt->getOperand1Slot();
+    if (!operand.isSymbol())
         return false;
-    return isVariable(tab, std::dynamic_pointer_cast<SymbolIOperand>(stmt->getOperand1())->getId());
+    return isVariable(tab, operand.getId());
 }
 
 // Return whether the statement reads a variable at operand 2
 bool iop_reads_op2(const SymbolTable& tab, IStatement* stmt) {
     if (iop_arity(stmt->getOperator()) < 2)
         return false;
-    if (stmt->getOperand2()->getOperandType() != OT_SYMBOL)
+    const IOperandSlot operand = stmt->getOperand2Slot();
+    if (!operand.isSymbol())
         return false;
-    return isVariable(tab, std::dynamic_pointer_cast<SymbolIOperand>(stmt->getOperand2())->getId());
+    return isVariable(tab, operand.getId());
 }
 
 bool iop_writes_result(const SymbolTable& tab, IStatement* stmt) {
     if (!iop_has_result(stmt->getOperator()))
         return false;
-    if (stmt->getResult() == nullptr || stmt->getResult()->getOperandType() != OT_SYMBOL)
+    const IOperandSlot result = stmt->getResultSlot();
+    if (!result.isSymbol())
         return false;
 
-    size_t id = std::dynamic_pointer_cast<SymbolIOperand>(stmt->getResult())->getId();
+    size_t id = result.getId();
     if (types::isArray(tab.getSymbol(id)->getReturnType()))
         return false;
     return isVariable(tab, id);
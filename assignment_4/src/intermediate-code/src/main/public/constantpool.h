@@ -0,0 +1,60 @@
+#ifndef COCO_FRAMEWORK_INTERMEDIATECODE_CONSTANTPOOL
+#define COCO_FRAMEWORK_INTERMEDIATECODE_CONSTANTPOOL
+
+#include "ioperand.h"
+
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// The immediates of an IntermediateCode, interned: every distinct (value, type) gets a dense id and one shared operand object.
+class ConstantPool {
+    public:
+    // Id of no constant
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    /**
+     * Interns an immediate.
+     * @param slot an immediate operand.
+     * @return the id of the immediate, or NONE if the slot holds no immediate.
+     */
+    size_t intern(const IOperandSlot& slot);
+
+    /**
+     * @return the id of an immediate that was interned before, or NONE.
+     */
+    size_t find(const IOperandSlot& slot) const;
+
+    /**
+     * @param id the id of a constant.
+     * @return the constant, by value.
+     */
+    const IOperandSlot& get(size_t id) const;
+
+    /**
+     * The operand object of a constant. All users share the same object, so constants compare by identity; it is const,
+     * as writing to it would change the constant for all of them.
+     * @param id the id of a constant.
+     */
+    const std::shared_ptr<const IOperand>& operand(size_t id) const;
+
+    // Returns the number of constants
+    size_t size() const;
+
+    // Removes all constants. Ids start over at 0.
+    void clear();
+
+    private:
+    struct Hash {
+        size_t operator()(const IOperandSlot& slot) const;
+    };
+
+    // Constants by id
+    std::vector<IOperandSlot> constants;
+    // Operand objects by id, created on first use
+    mutable std::vector<std::shared_ptr<const IOperand>> operands;
+    std::unordered_map<IOperandSlot, size_t, Hash> ids;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef COCO_FRAMEWORK_INTERMEDIATECODE_DEFUSE
+#define COCO_FRAMEWORK_INTERMEDIATECODE_DEFUSE
+
+#include "intermediatecode.h"
+#include <symboltable.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Def-use and use-def chains of an IntermediateCode, from reaching definitions.
+ * Tracks the local scalar variables of each function: variables, parameters and temporaries. Globals and arrays are not tracked,
+ * as calls and element stores change them behind the back of the statements.
+ * A definition is a statement writing a variable to its result. Parameters are defined by the IOP_FUNC statement of their function.
+ * Reaching definitions are found with a worklist pass over bitsets of the definitions of each function, and the chains are built
+ * in one sweep over the code after it. All queries take constant time. The analysis is invalid after the code changes: build it again.
+ */
+class DefUse {
+    public:
+    // No definition, or no single definition
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    // Operand of a statement that can read a variable
+    enum Operand { OPERAND1, OPERAND2 };
+
+    /**
+     * A read-only view of a list of definitions or lines. Allocates nothing.
+     */
+    class Ids {
+        public:
+        Ids() = default;
+        Ids(const size_t* first, const size_t* last) : first(first), last(last) {}
+
+        const size_t* begin() const { return first; }
+        const size_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+        size_t operator[](size_t index) const { return first[index]; }
+
+        private:
+        const size_t* first = nullptr;
+        const size_t* last = nullptr;
+    };
+
+    DefUse() = default;
+    DefUse(const SymbolTable& table, const IntermediateCode& ic);
+
+    /**
+     * Analyses `ic` from scratch, dropping the previous results.
+     * @param table the symbol table of `ic`
+     * @param ic the code to analyse
+     */
+    void build(const SymbolTable& table, const IntermediateCode& ic);
+
+    // Returns the number of definitions. Definitions are numbered in order of their lines.
+    size_t getDefinitionCount() const;
+
+    // Returns the line of a definition
+    size_t getLine(size_t def) const;
+
+    // Returns the variable of a definition
+    size_t getSymbol(size_t def) const;
+
+    /**
+     * @param line a line of the code.
+     * @return the definition made by the result of the line, or NONE.
+     */
+    size_t getDefinition(size_t line) const;
+
+    /**
+     * @param def a definition.
+     * @return the lines reading the definition, in order. A line reading it twice is listed once.
+     */
+    Ids getUses(size_t def) const;
+
+    /**
+     * @param line a line of the code.
+     * @param operand the operand of the line.
+     * @return the definitions that reach the variable read by the operand, or an empty view if it reads no tracked variable.
+     */
+    Ids getDefinitions(size_t line, Operand operand) const;
+
+    /**
+     * @return the single definition that reaches the variable read by the operand, or NONE if there is none or more than one.
+     */
+    size_t getReachingDefinition(size_t line, Operand operand) const;
+
+    private:
+    struct Definition {
+        size_t line;
+        size_t symbol;
+    };
+
+    struct Block {
+        size_t start;        // First line
+        size_t end;          // One past the last line
+        size_t preds_begin;  // Range of the predecessors in `preds`
+        size_t preds_end;
+        size_t succs_begin;  // Range of the successors in `succs`
+        size_t succs_end;
+        bool queued;         // Whether the block is on the worklist
+    };
+
+    // A tracked variable of the function being built, while the sweep is in `block`
+    struct Variable {
+        size_t block;  // Block the fields below are for
+        size_t def;    // Last definition in the block so far, or NONE
+        size_t begin;  // Definitions reaching the block, in use_definitions, once looked up: NONE before
+        size_t end;
+    };
+
+    std::vector<Definition> definitions;
+    std::vector<size_t> line_definitions; // line --> definition
+    // Definitions reaching each use, by line and operand: the range [use_offsets[2 * line + operand], use_offsets[2 * line + operand + 1])
+    std::vector<size_t> use_offsets;
+    std::vector<size_t> use_definitions;
+    // Lines reading each definition: the range [def_offsets[def], def_offsets[def + 1])
+    std::vector<size_t> def_offsets;
+    std::vector<size_t> def_uses;
+
+    // Scratch space of build, kept for reuse
+    std::vector<Block> blocks;
+    std::vector<size_t> preds;
+    std::vector<size_t> succs;
+    std::vector<uint8_t> tracked; // symbol id --> 0 unknown yet, 1 tracked, 2 not tracked
+    std::vector<size_t> variable_ids; // symbol id --> variable of the current function, or NONE
+    std::vector<Variable> variables;
+    // Definitions of each variable, in order: the range [variable_offsets[v], variable_offsets[v + 1]) of variable_defs
+    std::vector<size_t> variable_offsets;
+    std::vector<size_t> variable_defs;
+    // gen, kill, in and out sets of each block, `words` words each, by bit: definition - first definition of the function
+    std::vector<uint64_t> sets;
+    std::vector<size_t> worklist;
+
+    bool is_tracked(const SymbolTable& table, const IOperandSlot& slot);
+    bool is_tracked(const SymbolTable& table, size_t id);
+    // Splits the function in lines [start, end) in blocks and links them
+    void build_blocks(const IntermediateCode& ic, size_t start, size_t end);
+    void build_function(const SymbolTable& table, const IntermediateCode& ic, size_t start, size_t end);
+    // Computes the in and out sets of the blocks from `first` on from their gen and kill sets, until nothing changes
+    void solve(size_t first, size_t words);
+};
+
+#endif
@@ -26,6 +26,13 @@ struct ICInfo {
         else
             calls_it->second.push_back(line);
     }
+
+    /**
+     * Moves all line numbers after an edit of the intermediate code. Drops the lines of removed statements.
+     * Statements inserted before a leader do not become leaders: compute the info again if that matters.
+     * @param lines the new line of each old line, as returned by IntermediateCode::Edit::commit
+     */
+    void remap(const std::vector<size_t>& lines);
 };
 
 struct BasicBlock {
@@ -95,6 +102,16 @@ class FlowGraph {
 public:
     FlowGraph(const SymbolTable& table, const IntermediateCode& ic, Logger& logger);
 
+    // An empty graph, to be built later
+    explicit FlowGraph(Logger& logger) : logger(logger) {}
+
+    /**
+     * Builds the graph of `ic` from scratch, dropping the previous one. Keeps the capacity of the maps for reuse.
+     * @param table the symbol table of `ic`
+     * @param ic the code to build the graph of
+     */
+    void build(const SymbolTable& table, const IntermediateCode& ic);
+
     inline friend std::ostream& operator<<(std::ostream& stream, FlowGraph& graph) {
         FlowGraph::graph_walk(graph.entry, [&stream, &graph](const std::weak_ptr<BasicBlock> &block) {
             block.lock()->doStream(stream, graph.live_in, graph.live_out);
@@ -0,0 +1,90 @@
+#ifndef COCO_FRAMEWORK_INTERMEDIATECODE_ICFILE
+#define COCO_FRAMEWORK_INTERMEDIATECODE_ICFILE
+
+#include <logger.h>
+#include <symboltable.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "intermediatecode.h"
+
+/*
+ * Intermediate code saved to a file, with the symbol table it refers to and the lines of its functions.
+ * The file is versioned and position-independent: all sections are found by offset, and statements are stored as they are in memory.
+ * So, a memory-mapped file is used in place, without parsing. Files are only read on machines with the byte order they were written on.
+ */
+namespace intermediate {
+    // Version of the file format. Files of other versions are rejected.
+    constexpr uint32_t CODE_FILE_VERSION = 1;
+
+    /**
+     * Writes code and its symbol table to `out`, which should be opened in binary mode.
+     * @return whether all was written.
+     */
+    bool save(std::ostream& out, const IntermediateCode& icode, const SymbolTable& table);
+
+    /**
+     * Writes code and its symbol table to the file at `path`.
+     * @return whether all was written. Errors go to `logger`.
+     */
+    bool save(const std::string& path, const IntermediateCode& icode, const SymbolTable& table, Logger& logger);
+
+    /**
+     * A file written by `save`, memory-mapped and checked. The statements are used in place.
+     * Checking reads every record once, without copying: enums, symbol ids and line ranges must all be in bounds.
+     */
+    class MappedCode {
+        public:
+        // Lines [begin, end) of the function with symbol id `symbol`
+        struct Function {
+            size_t symbol;
+            size_t begin;
+            size_t end;
+        };
+
+        // Maps the file at `path`. Errors go to `logger`: check `valid` afterwards.
+        MappedCode(const std::string& path, Logger& logger);
+
+        // Uses the `size` bytes at `data`, e.g. a file read into memory, which must be 8-byte aligned and outlive this object.
+        MappedCode(const char* data, size_t size, Logger& logger);
+
+        MappedCode(const MappedCode&) = delete;
+        MappedCode& operator=(const MappedCode&) = delete;
+
+        ~MappedCode();
+
+        // Whether the file could be read, is a code file of this version and all its records are in bounds
+        bool valid() const;
+
+        std::string getProgramName() const;
+
+        // The statements of the code, in the file. Valid for the lifetime of this object.
+        const IStatement* getStatements() const;
+        size_t getStatementCount() const;
+
+        size_t getFunctionCount() const;
+        // The function at `index`, which must be below getFunctionCount(). Errors go to the logger and return an empty function.
+        Function getFunction(size_t index) const;
+
+        /**
+         * Fills a symbol table and code with the contents of the file, replacing their previous contents.
+         * Symbols get the ids they had when saved, so the statements refer to them unchanged.
+         * @return whether the file is valid and consistent.
+         */
+        bool load(SymbolTable& table, IntermediateCode& icode) const;
+
+        private:
+        Logger& logger;
+        const char* data = nullptr;
+        size_t size = 0;
+        bool mapped = false; // Whether `data` is a mapping of ours
+        std::vector<char> buffer; // Contents of the file, where it cannot be mapped
+        bool checked = false;
+
+        bool check();
+    };
+}
+
+#endif
@@ -19,6 +19,9 @@ class ICGenerator {
     // Takes a SyntaxTree and converts it into an IntermediateCode structure.
     IntermediateCode generateIntermediateCode(const SyntaxTree& tree, SymbolTable& table);
 
+    // Like above, but appends the statements to `icode`, e.g. one cleared for reuse.
+    void generateIntermediateCode(const SyntaxTree& tree, SymbolTable& table, IntermediateCode& icode);
+
     // Postprocesses the intermediate code; this method is called after GenerateIntermediateCode() if optimizations are enabled.
     void postprocess(IntermediateCode& code, SymbolTable& table);
 };
@@ -13,9 +13,16 @@ namespace intermediate {
         FlowGraph graph;
 
         Intermediate(IntermediateCode icode, FlowGraph graph) : icode(std::move(icode)), graph(std::move(graph)) {};
+        // Empty code and graph, to be filled by `generate`
+        explicit Intermediate(Logger& logger) : icode(logger), graph(logger) {};
     };
 
     Intermediate generate(const SyntaxTree& tree, SymbolTable& table, Logger& logger);
+
+    /**
+     * Like above, but fills `result`, replacing its previous contents while keeping their capacity.
+     */
+    void generate(const SyntaxTree& tree, SymbolTable& table, Logger& logger, Intermediate& result);
 }
 
 #endif
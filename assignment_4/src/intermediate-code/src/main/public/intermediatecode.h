@@ -2,28 +2,69 @@
 #define COCO_FRAMEWORK_INTERMEDIATECODE_INTERMEDIATECODE
 
 
+#include "constantpool.h"
 #include "istatement.h"
 #include <symboltable.h>
 
 #include <logger.h>
 
+#include <iomanip>
+#include <limits>
 #include <string>
 #include <vector>
-#include <iomanip>
 
 // This class stores a linear list of intermediate statements and provides
-// operations to modify that list.
+// operations to modify that list. Statements are stored by value, in one contiguous vector.
 class IntermediateCode {
     public:
+    // Line of a removed statement, in the remap of an Edit
+    static constexpr size_t REMOVED = std::numeric_limits<size_t>::max();
+
+    /**
+     * A batch of edits to the code: statements to remove and statements to insert.
+     * Positions refer to the lines of the code when the edit started. Nothing changes until `commit`, which applies all edits
+     * in one linear pass, so passes that remove or insert many statements should use this instead of insertStatement/removeStatement.
+     * Edits that are not committed are dropped.
+     */
+    class Edit {
+        public:
+        explicit Edit(IntermediateCode& code) : code(code) {}
+
+        // Marks the i-th statement dead
+        void remove(unsigned i);
+
+        // Queues a statement to insert before the i-th statement. Statements queued at the same place keep their order.
+        void insertBefore(unsigned i, const IStatement& stmt);
+
+        // Queues a statement to insert after the i-th statement. Statements queued at the same place keep their order.
+        void insertAfter(unsigned i, const IStatement& stmt);
+
+        /**
+         * Applies the edits and starts a new, empty edit.
+         * @return the new line of each old line, or REMOVED for removed statements. Use it to move line-based structures, like ICInfo.
+         */
+        std::vector<size_t> commit();
+
+        private:
+        struct Insertion {
+            size_t key; // 3 * line before the line, 3 * line + 2 after it: the line itself sorts at 3 * line + 1
+            IStatement stmt;
+        };
+
+        IntermediateCode& code;
+        std::vector<bool> dead;
+        std::vector<Insertion> insertions;
+    };
+
     explicit IntermediateCode(Logger& logger) : logger(logger) {}
 
-    IntermediateCode(IntermediateCode&& other) noexcept : logger(other.logger), programName(std::move(other.programName)), statements(std::move(other.statements)) {}
+    IntermediateCode(IntermediateCode&& other) noexcept : logger(other.logger), programName(std::move(other.programName)), statements(std::move(other.statements)), constants(std::move(other.constants)), interned(other.interned) {}
     IntermediateCode(IntermediateCode& other) = delete;
 
-    virtual ~IntermediateCode();
+    virtual ~IntermediateCode() = default;
 
     // gets the program name
-    std::string getProgramName();
+    std::string getProgramName() const;
 
     // sets the program name
     void setProgramName(std::string name);
@@ -31,18 +72,41 @@ class IntermediateCode {
     // Returns the number of statements
     unsigned getStatementCount() const;
 
-    // gets the i-th statement
+    // gets the i-th statement. The pointer is valid until the next statement is added or removed.
     IStatement* getStatement(unsigned i) const;
 
     // Appends a statement
+    void appendStatement(const IStatement& stmt);
+
+    // Appends a copy of a statement created with `new`, and deletes it
     void appendStatement(IStatement* stmt);
 
-    // Inserts a statement before the i-th statement
+    // Inserts a statement before the i-th statement. Moves all later statements: see Edit to insert many.
+    void insertStatement(const IStatement& stmt, unsigned i);
+
+    // Inserts a copy of a statement created with `new` before the i-th statement, and deletes it
     void insertStatement(IStatement* stmt, unsigned i);
 
-    // Removes the i-th statement
+    // Removes the i-th statement. Moves all later statements: see Edit to remove many.
     void removeStatement(unsigned i);
 
+    // The pool of immediates used by the statements. Statements are interned lazily, when the pool is asked for, so adding
+    // a statement costs no lookups. Immediates written through `getStatement` are only pooled if their statement was not yet.
+    ConstantPool& getConstants();
+    const ConstantPool& getConstants() const;
+
+    // Creates the operand object of a slot. Immediates come from the constant pool, shared with all other uses.
+    std::shared_ptr<const IOperand> getOperand(const IOperandSlot& slot) const;
+
+    // Replaces all statements with copies of the `count` statements at `first`, e.g. those of an intermediate::MappedCode
+    void setStatements(const IStatement* first, size_t count);
+
+    // Removes all statements, constants and the program name, keeping the capacity for the next program
+    void clear();
+
+    // Returns the number of statements the code holds before it allocates again
+    size_t capacity() const;
+
     inline friend std::ostream& operator<<(std::ostream& stream, const IntermediateCode& code) {
         return code.doStream(stream);
     }
@@ -60,9 +124,8 @@ class IntermediateCode {
         stream << std::setfill('-') << std::setw(idxSize) << "" << "-+-" << std::setw(colSize) << "" << "-+-" << std::setw(colSize) << "" << "-+-" << std::setw(colSize) << "" << "-+-" << std::setw(colSize) << "" << '\n';
         stream << std::setfill(' '); // Need to return default fill for next stream input.
         for (size_t x = 0; x < statements.size(); ++x) {
-            const auto* statement = statements[x];
             stream << std::setw(idxSize) << x << " | ";
-            statement->doStream(stream, table, colSize);
+            statements[x].doStream(stream, table, colSize);
         }
         stream << std::setfill('-') << std::setw(idxSize) << "" << "-+-" << std::setw(colSize) << "" << "-+-" << std::setw(colSize) << "" << "-+-" << std::setw(colSize) << "" << "-+-" << std::setw(colSize) << "" << '\n';
         stream << std::setfill(' '); // Need to return default fill for the rest of the stream.
@@ -74,7 +137,14 @@ class IntermediateCode {
     private:
     Logger& logger;
     std::string programName;
-    std::vector<IStatement*> statements;
+    // Mutable, as getStatement hands out modifiable statements, like when they were stored by pointer.
+    mutable std::vector<IStatement> statements;
+    // Pool of the immediates of the first `interned` statements. Mutable, as it is brought up to date when asked for.
+    mutable ConstantPool constants;
+    mutable size_t interned = 0;
+
+    // Interns the immediates of the statements added since the last call
+    void internConstants() const;
 };
 
 #endif
@@ -1,10 +1,13 @@
 #ifndef COCO_FRAMEWORK_INTERMEDIATECODE_IOPERAND
 #define COCO_FRAMEWORK_INTERMEDIATECODE_IOPERAND
 
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <string>
 #include <sstream>
-#include <limits>
 #include <symbol.h>
+#include <arena.h>
 #include <hacks/template_hacks.h>
 #include <symboltable.h>
 
@@ -15,6 +18,7 @@
  *   - SymbolIOperand
  * You can instantiate these objects with e.g:
  *   IOperand* myOperand = new ImmediateIOperand<int>(42);
+ * Statements store their operands by value, as an IOperandSlot, which converts from and to these objects.
  */
 
 // The type of an operand
@@ -24,11 +28,21 @@ typedef enum ioperandtype {
     OT_SYMBOL   // Symbol object
 } IOperandType;
 
-// Operand of an IStatement
-class IOperand {
+// What an IOperandSlot holds: nothing, a symbol id or an immediate of the given C type
+typedef enum ioperandkind : uint8_t {
+    OK_NONE,
+    OK_SYMBOL,
+    OK_INT8,
+    OK_UINT8,
+    OK_INT,
+    OK_UNSIGNED
+} IOperandKind;
+
+// Operand of an IStatement. Operands created with `new` are placed in the current arena, if there is one.
+class IOperand : public ArenaAllocated {
     public:
     IOperand() = default;
-    explicit IOperand(IOperandType type, ReturnType rt) : optype(type), rt(rt) {}
+    explicit IOperand(IOperandType type, ReturnType rt, IOperandKind kind = OK_NONE) : optype(type), rt(rt), kind(kind) {}
     IOperand(const IOperand& iop) = default;
 
     virtual ~IOperand() = default;
@@ -49,6 +63,11 @@ class IOperand {
         rt = type;
     }
 
+    // What the operand holds, so it converts to an IOperandSlot without trying each subclass
+    inline IOperandKind getKind() const {
+        return kind;
+    }
+
     inline friend std::ostream& operator<<(std::ostream& stream, const IOperand& operand) {
         return operand.doStream(stream);
     }
@@ -59,18 +78,26 @@ class IOperand {
 protected:
     IOperandType optype = OT_UNKNOWN;
     ReturnType rt = RT_UNKNOWN;
+    IOperandKind kind = OK_NONE;
 };
 
+// The IOperandKind of an immediate of type T, OK_NONE for types a slot cannot hold
+template<typename T> struct ImmediateKind { static constexpr IOperandKind value = OK_NONE; };
+template<> struct ImmediateKind<int8_t> { static constexpr IOperandKind value = OK_INT8; };
+template<> struct ImmediateKind<uint8_t> { static constexpr IOperandKind value = OK_UINT8; };
+template<> struct ImmediateKind<int> { static constexpr IOperandKind value = OK_INT; };
+template<> struct ImmediateKind<unsigned> { static constexpr IOperandKind value = OK_UNSIGNED; };
+
 template<typename T>
 class ImmediateIOperand : public IOperand {
     public:
-    explicit ImmediateIOperand(ReturnType rt) : IOperand(OT_IMM, rt) {};
-    ImmediateIOperand(T newvalue, ReturnType rt) : IOperand(OT_IMM, rt), value(newvalue){};
+    explicit ImmediateIOperand(ReturnType rt) : IOperand(OT_IMM, rt, ImmediateKind<T>::value) {};
+    ImmediateIOperand(T newvalue, ReturnType rt) : IOperand(OT_IMM, rt, ImmediateKind<T>::value), value(newvalue){};
     ImmediateIOperand(const ImmediateIOperand<T>& iop) = default;
 
     ~ImmediateIOperand() override = default;
 
-    inline T getValue() {
+    inline T getValue() const {
         return value;
     };
     inline void setValue(T newvalue) {
@@ -94,8 +121,8 @@ protected:
 
 class SymbolIOperand : public IOperand {
     public:
-    explicit SymbolIOperand(ReturnType rt) : IOperand(OT_SYMBOL, rt) {}
-    SymbolIOperand(size_t newsym, ReturnType rt) : IOperand(OT_SYMBOL, rt), sym_id(newsym){};
+    explicit SymbolIOperand(ReturnType rt) : IOperand(OT_SYMBOL, rt, OK_SYMBOL) {}
+    SymbolIOperand(size_t newsym, ReturnType rt) : IOperand(OT_SYMBOL, rt, OK_SYMBOL), sym_id(newsym){};
     SymbolIOperand(const SymbolIOperand& iop) = default;
 
     ~SymbolIOperand() override = default;
@@ -121,4 +148,110 @@ class SymbolIOperand : public IOperand {
     size_t sym_id = std::numeric_limits<size_t>::max();
 };
 
+// An operand by value: a tagged 64-bit symbol id or immediate, with its return type. Allocates nothing.
+struct IOperandSlot {
+    uint64_t value = 0; // Symbol id, or the immediate extended to 64 bits
+    IOperandKind kind = OK_NONE;
+    ReturnType rt = RT_UNKNOWN;
+
+    IOperandSlot() = default;
+    IOperandSlot(uint64_t value, IOperandKind kind, ReturnType rt) : value(value), kind(kind), rt(rt) {}
+
+    static IOperandSlot symbol(size_t id, ReturnType rt) {
+        return IOperandSlot(id, OK_SYMBOL, rt);
+    }
+    static IOperandSlot immediate(int8_t value, ReturnType rt) {
+        return IOperandSlot(static_cast<uint64_t>(static_cast<int64_t>(value)), OK_INT8, rt);
+    }
+    static IOperandSlot immediate(uint8_t value, ReturnType rt) {
+        return IOperandSlot(value, OK_UINT8, rt);
+    }
+    static IOperandSlot immediate(int value, ReturnType rt) {
+        return IOperandSlot(static_cast<uint64_t>(static_cast<int64_t>(value)), OK_INT, rt);
+    }
+    static IOperandSlot immediate(unsigned value, ReturnType rt) {
+        return IOperandSlot(value, OK_UNSIGNED, rt);
+    }
+
+    // The slot of an operand object, or an empty slot for `nullptr`
+    static IOperandSlot of(const IOperand* operand) {
+        if (!operand)
+            return IOperandSlot();
+        const ReturnType rt = operand->getReturnType();
+        switch (operand->getKind()) {
+            case OK_SYMBOL: return symbol(static_cast<const SymbolIOperand*>(operand)->getId(), rt);
+            case OK_INT8: return immediate(static_cast<const ImmediateIOperand<int8_t>*>(operand)->getValue(), rt);
+            case OK_UINT8: return immediate(static_cast<const ImmediateIOperand<uint8_t>*>(operand)->getValue(), rt);
+            case OK_INT: return immediate(static_cast<const ImmediateIOperand<int>*>(operand)->getValue(), rt);
+            case OK_UNSIGNED: return immediate(static_cast<const ImmediateIOperand<unsigned>*>(operand)->getValue(), rt);
+            default: return IOperandSlot();
+        }
+    }
+
+    // A new operand object for the slot, or `nullptr` for an empty slot
+    std::unique_ptr<IOperand> makeOperand() const {
+        switch (kind) {
+            case OK_SYMBOL: return std::unique_ptr<IOperand>(new SymbolIOperand(getId(), rt));
+            case OK_INT8: return std::unique_ptr<IOperand>(new ImmediateIOperand<int8_t>(static_cast<int8_t>(value), rt));
+            case OK_UINT8: return std::unique_ptr<IOperand>(new ImmediateIOperand<uint8_t>(static_cast<uint8_t>(value), rt));
+            case OK_INT: return std::unique_ptr<IOperand>(new ImmediateIOperand<int>(static_cast<int>(value), rt));
+            case OK_UNSIGNED: return std::unique_ptr<IOperand>(new ImmediateIOperand<unsigned>(static_cast<unsigned>(value), rt));
+            default: return nullptr;
+        }
+    }
+    std::shared_ptr<IOperand> toOperand() const {
+        return makeOperand();
+    }
+
+    inline bool empty() const {
+        return kind == OK_NONE;
+    }
+    inline bool isSymbol() const {
+        return kind == OK_SYMBOL;
+    }
+    inline bool isImmediate() const {
+        return kind != OK_NONE && kind != OK_SYMBOL;
+    }
+    inline IOperandType getOperandType() const {
+        return empty() ? OT_UNKNOWN : isSymbol() ? OT_SYMBOL : OT_IMM;
+    }
+    inline size_t getId() const {
+        return static_cast<size_t>(value);
+    }
+    // The immediate, sign-extended for signed types
+    inline int64_t getImmediate() const {
+        return static_cast<int64_t>(value);
+    }
+
+    inline bool operator==(const IOperandSlot& other) const {
+        return value == other.value && kind == other.kind && rt == other.rt;
+    }
+    inline bool operator!=(const IOperandSlot& other) const {
+        return !(*this == other);
+    }
+
+    // Streams like the matching operand object
+    inline std::ostream& doStream(std::ostream& stream, const SymbolTable* const table) const {
+        switch (kind) {
+            case OK_SYMBOL:
+                if (table)
+                    return stream << hack::format("%s (id: %zu)", table->getSymbol(getId())->getName().c_str(), getId());
+                return stream << hack::format("(id: %zu)", getId());
+            case OK_INT8: return streamImmediate(stream, static_cast<int8_t>(value));
+            case OK_UINT8: return streamImmediate(stream, static_cast<uint8_t>(value));
+            case OK_INT: return streamImmediate(stream, static_cast<int>(value));
+            case OK_UNSIGNED: return streamImmediate(stream, static_cast<unsigned>(value));
+            default: return stream << ' ';
+        }
+    }
+
+    private:
+    template<typename T>
+    static std::ostream& streamImmediate(std::ostream& stream, T value) {
+        std::stringstream stringstream;
+        stringstream << std::to_string(value) << " (" << hack::get_name<T>() << ')';
+        return stream << stringstream.str();
+    }
+};
+
 #endif
\ No newline at end of file
@@ -8,89 +8,132 @@
 #include <symboltable.h>
 #include <iomanip>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
-// A statement in the intermediate code (quadruple)
+// A statement in the intermediate code (quadruple), as 32 bytes of plain data: the operator, its type and three operand slots.
+// IntermediateCode stores statements by value. The deprecated shared_ptr getters allocate an operand object on every call,
+// for older code. Those objects are const copies: writing to them would not change the statement. Use the slots instead.
 class IStatement {
     public:
-    IStatement(IOperatorType type, IOperator op, std::shared_ptr<IOperand>  operand1, std::shared_ptr<IOperand>  operand2, std::shared_ptr<IOperand>  result) : itype(type), ioperator(op), operand1(std::move(operand1)), operand2(std::move(operand2)), result(std::move(result)){}
-    explicit IStatement(IOperator op) : itype(IOPT_WORD), ioperator(op), operand1(nullptr), operand2(nullptr), result(nullptr){}
-    IStatement() : itype(IOPT_WORD), ioperator(IOP_UNKNOWN), operand1(nullptr), operand2(nullptr), result(nullptr){}
-
-    inline virtual ~IStatement() = default;
+    IStatement(IOperatorType type, IOperator op, const IOperandSlot& operand1, const IOperandSlot& operand2, const IOperandSlot& result) : ioperator(static_cast<uint8_t>(op)), itype(static_cast<uint8_t>(type)) {
+        setSlot(OPERAND1, operand1);
+        setSlot(OPERAND2, operand2);
+        setSlot(RESULT, result);
+    }
+    IStatement(IOperatorType type, IOperator op, const std::shared_ptr<const IOperand>& operand1, const std::shared_ptr<const IOperand>& operand2, const std::shared_ptr<const IOperand>& result)
+        : IStatement(type, op, IOperandSlot::of(operand1.get()), IOperandSlot::of(operand2.get()), IOperandSlot::of(result.get())) {}
+    explicit IStatement(IOperator op) : IStatement(IOPT_WORD, op, IOperandSlot(), IOperandSlot(), IOperandSlot()) {}
+    IStatement() : IStatement(IOP_UNKNOWN) {}
 
     inline IOperatorType getIType() const {
-        return itype;
+        return static_cast<IOperatorType>(itype);
     }
 
     inline IOperator getOperator() const {
-        return ioperator;
+        return static_cast<IOperator>(ioperator);
     }
     inline void setOperator(IOperator op) {
-        ioperator = op;
+        ioperator = static_cast<uint8_t>(op);
     }
 
-    inline std::shared_ptr<IOperand> getOperand1() const {
-        return operand1;
+    inline IOperandSlot getOperand1Slot() const {
+        return getSlot(OPERAND1);
+    }
+    inline IOperandSlot getOperand2Slot() const {
+        return getSlot(OPERAND2);
+    }
+    inline IOperandSlot getResultSlot() const {
+        return getSlot(RESULT);
+    }
+
+    [[deprecated("allocates a copy of the operand: use getOperand1Slot instead")]]
+    inline std::shared_ptr<const IOperand> getOperand1() const {
+        return getSlot(OPERAND1).toOperand();
     };
-    inline void setOperand1(const std::shared_ptr<IOperand>& operand) {
-        operand1 = operand;
+    inline void setOperand1(const IOperandSlot& operand) {
+        setSlot(OPERAND1, operand);
+    }
+    inline void setOperand1(const std::shared_ptr<const IOperand>& operand) {
+        setSlot(OPERAND1, IOperandSlot::of(operand.get()));
     };
 
-    inline std::shared_ptr<IOperand> getOperand2() const {
-        return operand2;
+    [[deprecated("allocates a copy of the operand: use getOperand2Slot instead")]]
+    inline std::shared_ptr<const IOperand> getOperand2() const {
+        return getSlot(OPERAND2).toOperand();
     }
-    inline void setOperand2(const std::shared_ptr<IOperand>& operand) {
-        operand2 = operand;
+    inline void setOperand2(const IOperandSlot& operand) {
+        setSlot(OPERAND2, operand);
+    }
+    inline void setOperand2(const std::shared_ptr<const IOperand>& operand) {
+        setSlot(OPERAND2, IOperandSlot::of(operand.get()));
     }
 
-    inline std::shared_ptr<IOperand> getResult() {
-        return result;
+    [[deprecated("allocates a copy of the operand: use getResultSlot instead")]]
+    inline std::shared_ptr<const IOperand> getResult() const {
+        return getSlot(RESULT).toOperand();
+    }
+    inline void setResult(const IOperandSlot& operand) {
+        setSlot(RESULT, operand);
     }
-    inline void setResult(const std::shared_ptr<IOperand>& operand) {
-        result = operand;
+    inline void setResult(const std::shared_ptr<const IOperand>& operand) {
+        setSlot(RESULT, IOperandSlot::of(operand.get()));
+    }
+
+    // Whether the operator, its type and the operand slots hold values of their enums, e.g. for a statement read from a file
+    inline bool isWellFormed() const {
+        if (ioperator > static_cast<uint8_t>(IOP_COERCE) || itype > static_cast<uint8_t>(IOPT_QUAD))
+            return false;
+        for (int slot = OPERAND1; slot <= RESULT; ++slot)
+            if (kinds[slot] > OK_UNSIGNED || rts[slot] > static_cast<uint8_t>(RT_BOOL))
+                return false;
+        return true;
     }
 
     inline friend std::ostream& operator<<(std::ostream& stream, const IStatement& statement) {
         return statement.doStream(stream, 20);
     }
 
-    inline virtual std::ostream& doStream(std::ostream& stream, unsigned width) const {
+    inline std::ostream& doStream(std::ostream& stream, unsigned width) const {
         return doStream(stream, nullptr, width);
     }
 
-    inline virtual std::ostream& doStream(std::ostream& stream, const SymbolTable* const table, unsigned width) const {
-        stream << std::setw(width) << hack::format("%s (%s)", util::to_string(ioperator).c_str(), util::to_string(itype).c_str()) << " | ";
+    inline std::ostream& doStream(std::ostream& stream, const SymbolTable* const table, unsigned width) const {
+        stream << std::setw(width) << hack::format("%s (%s)", util::to_string(getOperator()).c_str(), util::to_string(getIType()).c_str()) << " | ";
         stream << std::setw(width);
-        if (operand1)
-           operand1->doStream(stream, table);
-        else
-            stream  << ' ';
-
+        getSlot(OPERAND1).doStream(stream, table);
         stream << " | " << std::setw(width);
-        if (operand2)
-            operand2->doStream(stream, table);
-        else
-            stream << ' ';
-
+        getSlot(OPERAND2).doStream(stream, table);
         stream << " | " << std::setw(width);
-        if (result)
-            result->doStream(stream, table);
-        else
-            stream << ' ';
+        getSlot(RESULT).doStream(stream, table);
         stream << '\n';
 
-        if (ioperator == IOP_RETURN)
+        if (getOperator() == IOP_RETURN)
             stream << '\n';
         return stream;
     }
 
     private:
-    IOperatorType itype;
-    IOperator ioperator;
-    std::shared_ptr<IOperand> operand1;
-    std::shared_ptr<IOperand> operand2;
-    std::shared_ptr<IOperand> result;
+    enum Slot { OPERAND1, OPERAND2, RESULT };
+
+    inline IOperandSlot getSlot(Slot slot) const {
+        return IOperandSlot(values[slot], kinds[slot], static_cast<ReturnType>(rts[slot]));
+    }
+    inline void setSlot(Slot slot, const IOperandSlot& operand) {
+        values[slot] = operand.value;
+        kinds[slot] = operand.kind;
+        rts[slot] = static_cast<uint8_t>(operand.rt);
+    }
+
+    // The slots are split in fields, so the statement packs into 32 bytes
+    uint64_t values[3];
+    uint8_t ioperator;   // IOperator
+    uint8_t itype;       // IOperatorType
+    IOperandKind kinds[3];
+    uint8_t rts[3];      // ReturnType
 };
 
+static_assert(sizeof(IStatement) == 32, "IStatement should pack into 32 bytes");
+static_assert(std::is_trivially_copyable<IStatement>::value && std::is_standard_layout<IStatement>::value, "IStatement should be plain data");
+
 #endif
@@ -1,7 +1,15 @@
 #include "../support/fixture.h"
 #include "../support/testutil.h"
+#include <flowgraph.h>
+#include <icfile.h>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <sstream>
 #include <string>
+#include <type_traits>
 #include <node.h>
+#include <syntaxtree.h>
 
 class APITest: public IntermediateCorrectTest {
 public:
@@ -113,17 +121,17 @@ TEST_F(APITest, int8_coerce_int) {
     EXPECT_EQ(stmt->getOperator(), IOP_COERCE);
     size_t tmp_id = dynamic_cast<SymbolIOperand*>(operand.get())->getId();
 
-    std::shared_ptr<IOperand> arg = stmt->getOperand1();
-    ASSERT_NE(arg, nullptr);
-    EXPECT_EQ(arg->getReturnType(), RT_INT8);
-    ASSERT_EQ(arg->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg.get())->getId(), child_id);
+    const IOperandSlot arg = stmt->getOperand1Slot();
+    ASSERT_FALSE(arg.empty());
+    EXPECT_EQ(arg.rt, RT_INT8);
+    ASSERT_EQ(arg.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg.getId(), child_id);
 
-    std::shared_ptr<IOperand> res = stmt->getResult();
-    ASSERT_NE(res, nullptr);
-    EXPECT_EQ(res->getReturnType(), RT_INT);
-    ASSERT_EQ(res->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(res.get())->getId(), tmp_id);
+    const IOperandSlot res = stmt->getResultSlot();
+    ASSERT_FALSE(res.empty());
+    EXPECT_EQ(res.rt, RT_INT);
+    ASSERT_EQ(res.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(res.getId(), tmp_id);
 
     visitor.emulate_function_end();
 
@@ -152,29 +160,123 @@ TEST_F(APITest, add_int) {
     EXPECT_EQ(stmt->getOperator(), IOP_ADD);
     size_t tmp_id = dynamic_cast<SymbolIOperand*>(operand.get())->getId();
 
-    std::shared_ptr<IOperand> arg1 = stmt->getOperand1();
-    ASSERT_NE(arg1, nullptr);
-    EXPECT_EQ(arg1->getReturnType(), RT_INT);
-    ASSERT_EQ(arg1->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg1.get())->getId(), left_id);
+    const IOperandSlot arg1 = stmt->getOperand1Slot();
+    ASSERT_FALSE(arg1.empty());
+    EXPECT_EQ(arg1.rt, RT_INT);
+    ASSERT_EQ(arg1.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg1.getId(), left_id);
 
-    std::shared_ptr<IOperand> arg2 = stmt->getOperand2();
-    ASSERT_NE(arg2, nullptr);
-    EXPECT_EQ(arg2->getReturnType(), RT_INT);
-    ASSERT_EQ(arg2->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg2.get())->getId(), right_id);
+    const IOperandSlot arg2 = stmt->getOperand2Slot();
+    ASSERT_FALSE(arg2.empty());
+    EXPECT_EQ(arg2.rt, RT_INT);
+    ASSERT_EQ(arg2.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg2.getId(), right_id);
 
-    std::shared_ptr<IOperand> res = stmt->getResult();
-    ASSERT_NE(res, nullptr);
-    EXPECT_EQ(res->getReturnType(), RT_INT);
-    ASSERT_EQ(res->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(res.get())->getId(), tmp_id);
+    const IOperandSlot res = stmt->getResultSlot();
+    ASSERT_FALSE(res.empty());
+    EXPECT_EQ(res.rt, RT_INT);
+    ASSERT_EQ(res.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(res.getId(), tmp_id);
 
 
     visitor.emulate_function_end();
     delete node;
 }
 
+TEST_F(APITest, repeated_subexpression) {
+    // Only temporaries in the table are reused, so the function must exist.
+    const size_t func_id = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
+    visitor.emulate_function_start(func_id);
+    const size_t a = table.addSymbol(Symbol("a", 1, RT_INT, ST_VARIABLE), func_id);
+    const size_t b = table.addSymbol(Symbol("b", 1, RT_INT, ST_VARIABLE), func_id);
+    const auto sum = [a, b]() {
+        auto* node = new BinaryNode(NODE_ADD, RT_INT);
+        node->setLeftChild(new SymbolNode(NODE_ID, RT_INT, a));
+        node->setRightChild(new SymbolNode(NODE_ID, RT_INT, b));
+        return node;
+    };
+    // (a + b) * (a + b) computes a + b once
+    auto* node = new BinaryNode(NODE_MUL, RT_INT);
+    node->setLeftChild(sum());
+    node->setRightChild(sum());
+
+    const size_t stmt_count = icode.getStatementCount();
+    IOperandPtr operand = visitor.accept_expr(node);
+    ASSERT_NE(operand, nullptr);
+    ASSERT_EQ(icode.getStatementCount(), stmt_count + 2);
+    EXPECT_EQ(icode.getStatement(stmt_count)->getOperator(), IOP_ADD);
+    const IStatement* product = icode.getStatement(stmt_count + 1);
+    EXPECT_EQ(product->getOperator(), IOP_MUL);
+    EXPECT_EQ(product->getOperand1Slot(), icode.getStatement(stmt_count)->getResultSlot());
+    EXPECT_EQ(product->getOperand2Slot(), product->getOperand1Slot());
+
+    visitor.emulate_function_end();
+    delete node;
+}
+
+TEST_F(APITest, wide_expression) {
+    const size_t func_id = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
+    visitor.emulate_function_start(func_id);
+    const size_t x = table.addSymbol(Symbol("x", 1, RT_INT, ST_VARIABLE), func_id);
+    // Balanced sum of x * 2, x * 3, ...: every product and sum is a different remembered value
+    const int leaves = 1 << 14;
+    std::function<Node*(int, int)> sum = [&](int begin, int end) -> Node* {
+        if (end - begin == 1) {
+            auto* product = new BinaryNode(NODE_MUL, RT_INT);
+            product->setLeftChild(new SymbolNode(NODE_ID, RT_INT, x));
+            product->setRightChild(SyntaxTree::createNumNode<int>(begin + 2, RT_INT));
+            return product;
+        }
+        auto* node = new BinaryNode(NODE_ADD, RT_INT);
+        node->setLeftChild(sum(begin, (begin + end) / 2));
+        node->setRightChild(sum((begin + end) / 2, end));
+        return node;
+    };
+    // The second sum is the first one again
+    auto* node = new BinaryNode(NODE_SUB, RT_INT);
+    node->setLeftChild(sum(0, leaves));
+    node->setRightChild(sum(0, leaves));
+
+    const size_t stmt_count = icode.getStatementCount();
+    IOperandPtr operand = visitor.accept_expr(node);
+    ASSERT_NE(operand, nullptr);
+    ASSERT_EQ(icode.getStatementCount(), stmt_count + 2 * leaves);
+    const IStatement* difference = icode.getStatement(stmt_count + 2 * leaves - 1);
+    EXPECT_EQ(difference->getOperator(), IOP_SUB);
+    EXPECT_EQ(difference->getOperand1Slot(), difference->getOperand2Slot());
+
+    visitor.emulate_function_end();
+    delete node;
+}
+
+TEST_F(APITest, deep_expression) {
+    size_t id = 1;
+    visitor.emulate_function_start(id++);
+    const size_t x = id++;
+    // x + (x + (... + x)), nested deeper than a recursive visit could go on the native stack
+    const int depth = 100000;
+    Node* node = new SymbolNode(NODE_ID, RT_INT, x);
+    for (int level = 0; level < depth; ++level) {
+        auto* sum = new BinaryNode(NODE_ADD, RT_INT);
+        sum->setLeftChild(new SymbolNode(NODE_ID, RT_INT, x));
+        sum->setRightChild(node);
+        node = sum;
+    }
+
+    const size_t stmt_count = icode.getStatementCount();
+    IOperandPtr operand = visitor.accept_expr(node);
+    ASSERT_NE(operand, nullptr);
+    ASSERT_EQ(icode.getStatementCount(), stmt_count + depth);
+    // Innermost first: each sum adds x to the one before it
+    EXPECT_EQ(icode.getStatement(stmt_count)->getOperand2Slot(), IOperandSlot::symbol(x, RT_INT));
+    for (size_t stmt = stmt_count + 1; stmt < stmt_count + depth; ++stmt)
+        ASSERT_EQ(icode.getStatement(stmt)->getOperand2Slot(), icode.getStatement(stmt - 1)->getResultSlot());
+    EXPECT_EQ(icode.getStatement(stmt_count + depth - 1)->getResultSlot(), IOperandSlot::of(operand.get()));
+
+    visitor.emulate_function_end();
+    delete node;
+}
+
 TEST_F(APITest, functioncall_noargs_void) {
     auto* node = new BinaryNode(NODE_FUNCTIONCALL, RT_VOID);
     const size_t func_id = 1;
@@ -191,11 +293,11 @@ TEST_F(APITest, functioncall_noargs_void) {
     EXPECT_EQ(stmt->getIType(), IOPT_VOID);
     EXPECT_EQ(stmt->getOperator(), IOP_FUNCCALL);
 
-    std::shared_ptr<IOperand> arg1 = stmt->getOperand1();
-    ASSERT_NE(arg1, nullptr);
-    EXPECT_EQ(arg1->getReturnType(), RT_VOID);
-    ASSERT_EQ(arg1->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg1.get())->getId(), func_id);
+    const IOperandSlot arg1 = stmt->getOperand1Slot();
+    ASSERT_FALSE(arg1.empty());
+    EXPECT_EQ(arg1.rt, RT_VOID);
+    ASSERT_EQ(arg1.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg1.getId(), func_id);
 
     delete node;
 }
@@ -223,23 +325,23 @@ TEST_F(APITest, rarray_int) {
     EXPECT_EQ(stmt->getIType(), IOPT_DOUBLE);
     EXPECT_EQ(stmt->getOperator(), IOP_RARRAY);
 
-    std::shared_ptr<IOperand> arg1 = stmt->getOperand1();
-    ASSERT_NE(arg1, nullptr);
-    EXPECT_EQ(arg1->getReturnType(), RT_INT_ARRAY);
-    ASSERT_EQ(arg1->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg1.get())->getId(), array_id);
+    const IOperandSlot arg1 = stmt->getOperand1Slot();
+    ASSERT_FALSE(arg1.empty());
+    EXPECT_EQ(arg1.rt, RT_INT_ARRAY);
+    ASSERT_EQ(arg1.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg1.getId(), array_id);
 
-    std::shared_ptr<IOperand> arg2 = stmt->getOperand2();
-    ASSERT_NE(arg2, nullptr);
-    EXPECT_EQ(arg2->getReturnType(), RT_INT);
-    ASSERT_EQ(arg2->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg2.get())->getId(), index_id);
+    const IOperandSlot arg2 = stmt->getOperand2Slot();
+    ASSERT_FALSE(arg2.empty());
+    EXPECT_EQ(arg2.rt, RT_INT);
+    ASSERT_EQ(arg2.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg2.getId(), index_id);
 
-    std::shared_ptr<IOperand> res = stmt->getResult();
-    ASSERT_NE(res, nullptr);
-    EXPECT_EQ(res->getReturnType(), RT_INT);
-    ASSERT_EQ(res->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(res.get())->getId(), tmp_id);
+    const IOperandSlot res = stmt->getResultSlot();
+    ASSERT_FALSE(res.empty());
+    EXPECT_EQ(res.rt, RT_INT);
+    ASSERT_EQ(res.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(res.getId(), tmp_id);
 
     visitor.emulate_function_end();
     delete node;
@@ -268,17 +370,17 @@ TEST_F(APITest, assignment_int) {
     EXPECT_EQ(stmt->getIType(), IOPT_DOUBLE);
     ASSERT_EQ(stmt->getOperator(), IOP_ASSIGN);
 
-    std::shared_ptr<IOperand> arg1 = stmt->getOperand1();
-    ASSERT_NE(arg1, nullptr);
-    EXPECT_EQ(arg1->getReturnType(), RT_INT);
-    ASSERT_EQ(arg1->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(arg1.get())->getId(), id_right);
+    const IOperandSlot arg1 = stmt->getOperand1Slot();
+    ASSERT_FALSE(arg1.empty());
+    EXPECT_EQ(arg1.rt, RT_INT);
+    ASSERT_EQ(arg1.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(arg1.getId(), id_right);
 
-    std::shared_ptr<IOperand> res = stmt->getResult();
-    ASSERT_NE(res, nullptr);
-    EXPECT_EQ(res->getReturnType(), RT_INT);
-    ASSERT_EQ(res->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(res.get())->getId(), id_left);
+    const IOperandSlot res = stmt->getResultSlot();
+    ASSERT_FALSE(res.empty());
+    EXPECT_EQ(res.rt, RT_INT);
+    ASSERT_EQ(res.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(res.getId(), id_left);
 
     delete left;
     delete right;
@@ -295,7 +397,7 @@ TEST_F(APITest, return_empty) {
     ASSERT_NE(stmt, nullptr);
     EXPECT_EQ(stmt->getIType(), IOPT_VOID);
     EXPECT_EQ(stmt->getOperator(), IOP_RETURN);
-    EXPECT_EQ(stmt->getOperand1(), nullptr);
+    EXPECT_TRUE(stmt->getOperand1Slot().empty());
 
     delete node;
 }
@@ -313,18 +415,18 @@ TEST_F(APITest, return_symbol_int) {
     EXPECT_EQ(stmt->getIType(), IOPT_VOID);
     EXPECT_EQ(stmt->getOperator(), IOP_RETURN);
 
-    std::shared_ptr<IOperand> op1 = stmt->getOperand1();
-    ASSERT_NE(op1, nullptr);
-    EXPECT_EQ(op1->getReturnType(), RT_INT);
-    ASSERT_EQ(op1->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(op1.get())->getId(), id);
+    const IOperandSlot op1 = stmt->getOperand1Slot();
+    ASSERT_FALSE(op1.empty());
+    EXPECT_EQ(op1.rt, RT_INT);
+    ASSERT_EQ(op1.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(op1.getId(), id);
 
     delete node;
 }
 
 TEST_F(APITest, function) {
     Node* root = new Node(NODE_EMPTY, RT_VOID);
-    size_t func_id = table.addFunction(new Symbol("main", 1, RT_INT, ST_FUNCTION));
+    size_t func_id = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
 
     size_t stmt_count = icode.getStatementCount();
     visitor.visit_function(func_id, root);
@@ -335,13 +437,240 @@ TEST_F(APITest, function) {
     EXPECT_EQ(stmt->getIType(), IOPT_VOID);
     EXPECT_EQ(stmt->getOperator(), IOP_FUNC);
 
-    std::shared_ptr<IOperand> op1 = stmt->getOperand1();
-    ASSERT_NE(op1, nullptr);
-    EXPECT_EQ(op1->getReturnType(), RT_INT);
-    ASSERT_EQ(op1->getOperandType(), OT_SYMBOL);
-    EXPECT_EQ(dynamic_cast<SymbolIOperand*>(op1.get())->getId(), func_id);
+    const IOperandSlot op1 = stmt->getOperand1Slot();
+    ASSERT_FALSE(op1.empty());
+    EXPECT_EQ(op1.rt, RT_INT);
+    ASSERT_EQ(op1.getOperandType(), OT_SYMBOL);
+    EXPECT_EQ(op1.getId(), func_id);
 
     delete root;
 }
 
 
+
+TEST_F(APITest, statement_by_value) {
+    icode.appendStatement(IStatement(IOPT_BYTE, IOP_ADD, IOperandSlot::symbol(3, RT_INT8), IOperandSlot::immediate(static_cast<int8_t>(-5), RT_INT8), IOperandSlot::symbol(4, RT_INT8)));
+    icode.appendStatement(new IStatement(IOP_RETURN));
+    ASSERT_EQ(icode.getStatementCount(), 2u);
+
+    IStatement* stmt = icode.getStatement(0);
+    EXPECT_EQ(stmt->getIType(), IOPT_BYTE);
+    EXPECT_EQ(stmt->getOperator(), IOP_ADD);
+    EXPECT_EQ(stmt->getOperand1Slot(), IOperandSlot::symbol(3, RT_INT8));
+    EXPECT_EQ(stmt->getOperand2Slot().getImmediate(), -5);
+
+    // The deprecated operand objects of older code convert to the same slots. They are copies, so they cannot be written to.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    static_assert(std::is_const<std::remove_reference<decltype(*stmt->getOperand2())>::type>::value, "operand copies should be const");
+    std::shared_ptr<const IOperand> op2 = stmt->getOperand2();
+    ASSERT_NE(op2, nullptr);
+    EXPECT_EQ(op2->getReturnType(), RT_INT8);
+    ASSERT_EQ(op2->getOperandType(), OT_IMM);
+    EXPECT_EQ(dynamic_cast<const ImmediateIOperand<int8_t>*>(op2.get())->getValue(), -5);
+    EXPECT_EQ(IOperandSlot::of(op2.get()), stmt->getOperand2Slot());
+    EXPECT_EQ(IOperandSlot::of(stmt->getResult().get()), stmt->getResultSlot());
+
+    std::ostringstream slot, object;
+    stmt->getOperand2Slot().doStream(slot, nullptr);
+    op2->doStream(object);
+    EXPECT_EQ(slot.str(), object.str());
+
+    stmt = icode.getStatement(1);
+    EXPECT_EQ(stmt->getOperator(), IOP_RETURN);
+    EXPECT_EQ(stmt->getOperand1(), nullptr);
+#pragma GCC diagnostic pop
+    EXPECT_TRUE(stmt->getResultSlot().empty());
+}
+
+TEST_F(APITest, operand_kind) {
+    const IOperandSlot slots[] = {
+        IOperandSlot::symbol(7, RT_INT),
+        IOperandSlot::immediate(static_cast<int8_t>(-3), RT_INT8),
+        IOperandSlot::immediate(static_cast<uint8_t>(200), RT_UINT8),
+        IOperandSlot::immediate(-70000, RT_INT),
+        IOperandSlot::immediate(4000000000u, RT_UINT),
+    };
+    // Operand objects carry the kind of their slot, so they convert back without a cast per type.
+    for (const IOperandSlot& slot : slots) {
+        const std::unique_ptr<IOperand> operand = slot.makeOperand();
+        ASSERT_NE(operand, nullptr);
+        EXPECT_EQ(operand->getKind(), slot.kind);
+        EXPECT_EQ(IOperandSlot::of(operand.get()), slot);
+    }
+    EXPECT_EQ(IOperandSlot().makeOperand(), nullptr);
+    EXPECT_TRUE(IOperandSlot::of(nullptr).empty());
+}
+
+TEST_F(APITest, edit) {
+    const IOperator ops[] = {IOP_FUNC, IOP_LABEL, IOP_ADD, IOP_GOTO, IOP_RETURN};
+    for (IOperator op : ops)
+        icode.appendStatement(IStatement(op));
+
+    IntermediateCode::Edit edit(icode);
+    edit.remove(1);
+    edit.remove(3);
+    edit.insertBefore(0, IStatement(IOP_PARAM));
+    edit.insertAfter(4, IStatement(IOP_NOT));
+    edit.insertBefore(3, IStatement(IOP_SUB));
+    edit.insertAfter(2, IStatement(IOP_MUL));
+    edit.insertBefore(5, IStatement(IOP_ASSIGN));
+    ASSERT_EQ(icode.getStatementCount(), 5u); // Nothing changes before the commit
+
+    const std::vector<size_t> lines = edit.commit();
+    const IOperator expected[] = {IOP_PARAM, IOP_FUNC, IOP_ADD, IOP_MUL, IOP_SUB, IOP_RETURN, IOP_NOT, IOP_ASSIGN};
+    ASSERT_EQ(icode.getStatementCount(), 8u);
+    for (unsigned x = 0; x < 8; ++x)
+        EXPECT_EQ(icode.getStatement(x)->getOperator(), expected[x]) << "at line " << x;
+    EXPECT_EQ(lines, std::vector<size_t>({1, IntermediateCode::REMOVED, 2, IntermediateCode::REMOVED, 5}));
+
+    ICInfo info;
+    info.leaders = {0, 1, 4};
+    info.labels[7] = 1;
+    info.labels[8] = 2;
+    info.add_call(9, 3);
+    info.add_call(9, 4);
+    info.funcs[0] = 10;
+    info.remap(lines);
+    EXPECT_EQ(info.leaders, std::vector<size_t>({1, 5}));
+    EXPECT_EQ(info.labels, (std::unordered_map<size_t, size_t>{{8, 2}}));
+    EXPECT_EQ(info.calls[9], std::vector<size_t>({5}));
+    EXPECT_EQ(info.funcs, (std::unordered_map<size_t, size_t>{{1, 10}}));
+
+    EXPECT_EQ(edit.commit().size(), 8u); // The next edit starts empty
+    EXPECT_EQ(icode.getStatementCount(), 8u);
+}
+
+TEST_F(APITest, constant_pool) {
+    const IOperandSlot one = IOperandSlot::immediate(1, RT_INT);
+    const IOperandSlot i = IOperandSlot::symbol(3, RT_INT);
+    for (int x = 0; x < 3; ++x)
+        icode.appendStatement(IStatement(IOPT_WORD, IOP_ADD, i, one, i));
+    icode.appendStatement(IStatement(IOPT_BYTE, IOP_ADD, i, IOperandSlot::immediate(static_cast<int8_t>(1), RT_INT8), i));
+
+    const ConstantPool& pool = icode.getConstants();
+    ASSERT_EQ(pool.size(), 2u); // Same value, other type: other constant
+    const size_t id = pool.find(one);
+    ASSERT_NE(id, ConstantPool::NONE);
+    EXPECT_EQ(pool.get(id), one);
+    EXPECT_EQ(pool.find(i), ConstantPool::NONE);
+
+    // All uses share one operand object
+    const std::shared_ptr<const IOperand> first = icode.getOperand(icode.getStatement(0)->getOperand2Slot());
+    EXPECT_EQ(first, icode.getOperand(icode.getStatement(2)->getOperand2Slot()));
+    EXPECT_NE(first, icode.getOperand(icode.getStatement(3)->getOperand2Slot()));
+    ASSERT_EQ(first->getOperandType(), OT_IMM);
+    EXPECT_EQ(dynamic_cast<const ImmediateIOperand<int>*>(first.get())->getValue(), 1);
+    EXPECT_NE(icode.getOperand(i), nullptr);
+
+    // Statements added after the pool was asked for are interned on the next request, edits included
+    const IOperandSlot two = IOperandSlot::immediate(2, RT_INT), three = IOperandSlot::immediate(3, RT_INT);
+    icode.appendStatement(IStatement(IOPT_WORD, IOP_ADD, i, two, i));
+    IntermediateCode::Edit edit(icode);
+    edit.insertBefore(1, IStatement(IOPT_WORD, IOP_SUB, i, three, i));
+    edit.commit();
+    EXPECT_EQ(pool.size(), 2u);
+    EXPECT_EQ(icode.getConstants().size(), 4u);
+    EXPECT_NE(pool.find(two), ConstantPool::NONE);
+    EXPECT_NE(pool.find(three), ConstantPool::NONE);
+    EXPECT_EQ(icode.getOperand(one), first);
+
+    icode.clear();
+    EXPECT_EQ(icode.getConstants().size(), 0u);
+}
+
+TEST_F(APITest, save_and_map) {
+    table.addSymbol(Symbol("g", 1, RT_INT, ST_VARIABLE), 0);
+    const size_t main = table.addFunction(Symbol("main", 2, RT_INT, ST_FUNCTION));
+    const size_t p = table.addSymbol(Symbol("p", 2, RT_INT, ST_PARAMETER), main);
+    const size_t t = table.addTempvar(RT_INT, "t", main);
+    const size_t array = table.addSymbol(Symbol("a", 3, RT_INT_ARRAY, ST_VARIABLE, 10), main);
+    icode.setProgramName("program");
+    icode.appendStatement(IStatement(IOPT_VOID, IOP_FUNC, IOperandSlot::symbol(main, RT_INT), IOperandSlot(), IOperandSlot()));
+    icode.appendStatement(IStatement(IOPT_WORD, IOP_ADD, IOperandSlot::symbol(p, RT_INT), IOperandSlot::immediate(2, RT_INT), IOperandSlot::symbol(t, RT_INT)));
+    icode.appendStatement(IStatement(IOPT_WORD, IOP_LARRAY, IOperandSlot::symbol(t, RT_INT), IOperandSlot::immediate(0, RT_INT), IOperandSlot::symbol(array, RT_INT_ARRAY)));
+    icode.appendStatement(IStatement(IOPT_WORD, IOP_RETURN, IOperandSlot::symbol(t, RT_INT), IOperandSlot(), IOperandSlot()));
+
+    std::ostringstream out;
+    ASSERT_TRUE(intermediate::save(out, icode, table));
+    const std::string file = out.str();
+    std::vector<uint64_t> aligned(file.size() / 8 + 1);
+    std::memcpy(aligned.data(), file.data(), file.size());
+    const auto* data = reinterpret_cast<const char*>(aligned.data());
+
+    const intermediate::MappedCode code(data, file.size(), logger);
+    ASSERT_TRUE(code.valid());
+    EXPECT_EQ(code.getProgramName(), "program");
+    ASSERT_EQ(code.getStatementCount(), 4u);
+    EXPECT_EQ(code.getStatements()[1].getOperand2Slot(), IOperandSlot::immediate(2, RT_INT));
+    ASSERT_EQ(code.getFunctionCount(), 1u);
+    EXPECT_EQ(code.getFunction(0).symbol, main);
+    EXPECT_EQ(code.getFunction(0).begin, 0u);
+    EXPECT_EQ(code.getFunction(0).end, 4u);
+
+    SymbolTable loaded_table;
+    IntermediateCode loaded(logger);
+    ASSERT_TRUE(code.load(loaded_table, loaded));
+    std::ostringstream expected, actual;
+    expected << table;
+    icode.doStream(expected, &table);
+    actual << loaded_table;
+    loaded.doStream(actual, &loaded_table);
+    EXPECT_EQ(actual.str(), expected.str());
+    EXPECT_EQ(loaded_table.getSymbol(array)->getSize(), 10);
+    EXPECT_EQ(loaded.getProgramName(), "program");
+
+    // Through the filesystem, mapped
+    const std::string path = testing::TempDir() + "api_save_and_map.ic";
+    ASSERT_TRUE(intermediate::save(path, icode, table, logger));
+    const intermediate::MappedCode mapped(path, logger);
+    ASSERT_TRUE(mapped.valid());
+    ASSERT_EQ(mapped.getStatementCount(), 4u);
+    EXPECT_EQ(mapped.getStatements()[3].getOperator(), IOP_RETURN);
+    std::remove(path.c_str());
+
+    // Damaged files are rejected
+    EXPECT_FALSE(intermediate::MappedCode(data, file.size() - 8, logger).valid());
+    aligned[0] ^= 1;
+    EXPECT_FALSE(intermediate::MappedCode(data, file.size(), logger).valid());
+}
+
+TEST_F(APITest, map_damaged) {
+    const size_t main = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
+    const size_t p = table.addSymbol(Symbol("p", 1, RT_INT, ST_PARAMETER), main);
+    icode.appendStatement(IStatement(IOPT_VOID, IOP_FUNC, IOperandSlot::symbol(main, RT_INT), IOperandSlot(), IOperandSlot()));
+    icode.appendStatement(IStatement(IOPT_WORD, IOP_ADD, IOperandSlot::symbol(p, RT_INT), IOperandSlot::immediate(2, RT_INT), IOperandSlot::symbol(p, RT_INT)));
+    icode.appendStatement(IStatement(IOPT_WORD, IOP_RETURN, IOperandSlot::symbol(p, RT_INT), IOperandSlot(), IOperandSlot()));
+    std::ostringstream out;
+    ASSERT_TRUE(intermediate::save(out, icode, table));
+    const std::string file = out.str();
+
+    // Whether the file is valid after writing `value` at `offset`, in a copy of it
+    auto valid_with = [&](size_t offset, uint64_t value, size_t bytes) {
+        std::vector<uint64_t> aligned(file.size() / 8 + 1);
+        std::memcpy(aligned.data(), file.data(), file.size());
+        std::memcpy(reinterpret_cast<char*>(aligned.data()) + offset, &value, bytes);
+        return intermediate::MappedCode(reinterpret_cast<const char*>(aligned.data()), file.size(), logger).valid();
+    };
+    // Sections follow the 96-byte header: 3 statements of 32 bytes, 2 symbols of 32 bytes, then 1 function
+    const size_t add = 96 + 32, symbols = 96 + 3 * 32, function = symbols + 2 * 32;
+    ASSERT_TRUE(valid_with(add, p, 8));
+    EXPECT_FALSE(valid_with(add, 3, 8));          // Operand 1 refers to a symbol past the table
+    EXPECT_FALSE(valid_with(add + 24, 0xff, 1));  // Operator
+    EXPECT_FALSE(valid_with(add + 25, 0xff, 1));  // Operator type
+    EXPECT_FALSE(valid_with(add + 27, 0x7f, 1));  // Kind of operand 2
+    EXPECT_FALSE(valid_with(add + 31, 0xff, 1));  // Return type of the result
+    EXPECT_FALSE(valid_with(symbols + 28, 0xff, 1)); // Return type of main
+    EXPECT_FALSE(valid_with(symbols + 32 + 29, 0xff, 1)); // Symbol type of p
+    EXPECT_FALSE(valid_with(function, 0, 8));     // Function symbol
+    EXPECT_FALSE(valid_with(function + 16, 4, 8)); // Function end past the statements
+    EXPECT_FALSE(valid_with(function + 8, 4, 8));  // Function begin after its end
+
+    std::vector<uint64_t> aligned(file.size() / 8 + 1);
+    std::memcpy(aligned.data(), file.data(), file.size());
+    const intermediate::MappedCode code(reinterpret_cast<const char*>(aligned.data()), file.size(), logger);
+    ASSERT_TRUE(code.valid());
+    ASSERT_EQ(code.getFunctionCount(), 1u);
+    EXPECT_EQ(code.getFunction(0).end, 3u);
+    EXPECT_EQ(code.getFunction(1).symbol, 0u); // Out of bounds: empty
+}
@@ -0,0 +1,141 @@
+#include "../support/fixture.h"
+#include <defuse.h>
+#include <intermediatecode.h>
+#include <string>
+#include <vector>
+
+class DefUseTest: public IntermediateCorrectTest {
+protected:
+    DefUseTest() : icode(logger) {}
+
+    void emit(IOperator op, const IOperandSlot& operand1, const IOperandSlot& operand2, const IOperandSlot& result) {
+        icode.appendStatement(IStatement(IOPT_WORD, op, operand1, operand2, result));
+    }
+
+    size_t symbol(const std::string& name, SymbolType st, size_t func) {
+        return table.addSymbol(Symbol(name, 1, RT_INT, st), func);
+    }
+
+    static IOperandSlot sym(size_t id) {
+        return IOperandSlot::symbol(id, RT_INT);
+    }
+
+    static IOperandSlot imm(int value) {
+        return IOperandSlot::immediate(value, RT_INT);
+    }
+
+    static std::vector<size_t> list(DefUse::Ids ids) {
+        return std::vector<size_t>(ids.begin(), ids.end());
+    }
+
+    IntermediateCode icode;
+};
+
+/**
+ * Tests for the def-use chains of DefUse
+ */
+
+TEST_F(DefUseTest, chains) {
+    const size_t g = symbol("g", ST_VARIABLE, 0);
+    const size_t f = table.addFunction(Symbol("f", 1, RT_INT, ST_FUNCTION));
+    const size_t p = symbol("p", ST_PARAMETER, f);
+    const size_t a = symbol("a", ST_VARIABLE, f);
+    const size_t t = table.addTempvar(RT_INT, "t", f);
+    const size_t label = table.addLabel(RT_VOID, "L", f);
+    const size_t main = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
+    const size_t b = symbol("b", ST_VARIABLE, main);
+
+    emit(IOP_FUNC, sym(f), IOperandSlot(), IOperandSlot());   // 0: defines p (definition 0)
+    emit(IOP_ASSIGN, imm(1), IOperandSlot(), sym(a));         // 1: definition 1
+    emit(IOP_JE, sym(p), imm(0), sym(label));                 // 2
+    emit(IOP_ASSIGN, imm(2), IOperandSlot(), sym(a));         // 3: definition 2
+    emit(IOP_LABEL, sym(label), IOperandSlot(), IOperandSlot()); // 4
+    emit(IOP_ADD, sym(a), sym(p), sym(t));                    // 5: definition 3
+    emit(IOP_ASSIGN, sym(t), IOperandSlot(), sym(g));         // 6: globals are not tracked
+    emit(IOP_ASSIGN, sym(t), IOperandSlot(), sym(a));         // 7: definition 4
+    emit(IOP_JNZ, sym(t), IOperandSlot(), sym(label));        // 8: loops back to 4
+    emit(IOP_RETURN, sym(a), IOperandSlot(), IOperandSlot()); // 9
+    emit(IOP_FUNC, sym(main), IOperandSlot(), IOperandSlot()); // 10
+    emit(IOP_ASSIGN, imm(3), IOperandSlot(), sym(b));         // 11: definition 5
+    emit(IOP_ADD, sym(b), sym(b), sym(b));                    // 12: definition 6
+    emit(IOP_RETURN, sym(b), IOperandSlot(), IOperandSlot()); // 13
+
+    DefUse chains(table, icode);
+    ASSERT_EQ(chains.getDefinitionCount(), 7u);
+    EXPECT_EQ(chains.getLine(0), 0u);
+    EXPECT_EQ(chains.getSymbol(0), p);
+    EXPECT_EQ(chains.getDefinition(1), 1u);
+    EXPECT_EQ(chains.getDefinition(5), 3u);
+    EXPECT_EQ(chains.getDefinition(6), DefUse::NONE);
+    EXPECT_EQ(chains.getDefinition(2), DefUse::NONE);
+
+    // Use-def
+    EXPECT_EQ(chains.getReachingDefinition(2, DefUse::OPERAND1), 0u);
+    EXPECT_TRUE(chains.getDefinitions(2, DefUse::OPERAND2).empty());
+    EXPECT_EQ(list(chains.getDefinitions(5, DefUse::OPERAND1)), std::vector<size_t>({1, 2, 4}));
+    EXPECT_EQ(chains.getReachingDefinition(5, DefUse::OPERAND1), DefUse::NONE);
+    EXPECT_EQ(chains.getReachingDefinition(5, DefUse::OPERAND2), 0u);
+    EXPECT_EQ(chains.getReachingDefinition(8, DefUse::OPERAND1), 3u);
+    EXPECT_EQ(chains.getReachingDefinition(9, DefUse::OPERAND1), 4u);
+    EXPECT_EQ(chains.getReachingDefinition(12, DefUse::OPERAND2), 5u);
+    EXPECT_EQ(chains.getReachingDefinition(13, DefUse::OPERAND1), 6u);
+
+    // Def-use
+    EXPECT_EQ(list(chains.getUses(0)), std::vector<size_t>({2, 5}));
+    EXPECT_EQ(list(chains.getUses(2)), std::vector<size_t>({5}));
+    EXPECT_EQ(list(chains.getUses(3)), std::vector<size_t>({6, 7, 8}));
+    EXPECT_EQ(list(chains.getUses(4)), std::vector<size_t>({5, 9}));
+    EXPECT_EQ(list(chains.getUses(5)), std::vector<size_t>({12}));
+    EXPECT_EQ(list(chains.getUses(6)), std::vector<size_t>({13}));
+}
+
+TEST_F(DefUseTest, long_function) {
+    const size_t f = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
+    const size_t x = symbol("x", ST_VARIABLE, f);
+    const size_t y = symbol("y", ST_VARIABLE, f);
+    const size_t label = table.addLabel(RT_VOID, "L", f);
+    const size_t count = 100000;
+
+    emit(IOP_FUNC, sym(f), IOperandSlot(), IOperandSlot());
+    emit(IOP_ASSIGN, imm(0), IOperandSlot(), sym(x));
+    emit(IOP_LABEL, sym(label), IOperandSlot(), IOperandSlot());
+    for (size_t line = 0; line < count; ++line)
+        emit(IOP_ADD, sym(x), imm(1), sym(line % 2 ? x : y));
+    emit(IOP_JNZ, sym(x), IOperandSlot(), sym(label));
+    emit(IOP_RETURN, sym(y), IOperandSlot(), IOperandSlot());
+
+    DefUse chains(table, icode);
+    ASSERT_EQ(chains.getDefinitionCount(), count + 1);
+    // Before the first definition in the loop, x comes from before the loop or from its last iteration
+    EXPECT_EQ(list(chains.getDefinitions(3, DefUse::OPERAND1)), std::vector<size_t>({0, count}));
+    EXPECT_EQ(list(chains.getDefinitions(4, DefUse::OPERAND1)), std::vector<size_t>({0, count}));
+    EXPECT_EQ(chains.getReachingDefinition(5, DefUse::OPERAND1), 2u);
+    EXPECT_EQ(chains.getReachingDefinition(count + 3, DefUse::OPERAND1), count);
+    EXPECT_EQ(chains.getReachingDefinition(count + 4, DefUse::OPERAND1), count - 1);
+    EXPECT_EQ(list(chains.getUses(0)), std::vector<size_t>({3, 4}));
+}
+
+TEST_F(DefUseTest, many_blocks) {
+    const size_t f = table.addFunction(Symbol("main", 1, RT_INT, ST_FUNCTION));
+    const size_t x = symbol("x", ST_VARIABLE, f);
+    const size_t y = symbol("y", ST_VARIABLE, f);
+    const size_t count = 5000;
+
+    // Each block reads y, defined once before all of them, and redefines x
+    emit(IOP_FUNC, sym(f), IOperandSlot(), IOperandSlot());
+    emit(IOP_ASSIGN, imm(0), IOperandSlot(), sym(y));
+    emit(IOP_ASSIGN, imm(0), IOperandSlot(), sym(x));
+    for (size_t block = 0; block < count; ++block) {
+        const size_t label = table.addLabel(RT_VOID, "L" + std::to_string(block), f);
+        emit(IOP_LABEL, sym(label), IOperandSlot(), IOperandSlot());
+        emit(IOP_ADD, sym(y), sym(x), sym(x));
+    }
+    emit(IOP_RETURN, sym(x), IOperandSlot(), IOperandSlot());
+
+    DefUse chains(table, icode);
+    ASSERT_EQ(chains.getDefinitionCount(), count + 2);
+    EXPECT_EQ(chains.getUses(0).size(), count);
+    EXPECT_EQ(chains.getReachingDefinition(2 * count + 2, DefUse::OPERAND1), 0u);
+    EXPECT_EQ(chains.getReachingDefinition(2 * count + 2, DefUse::OPERAND2), count);
+    EXPECT_EQ(chains.getReachingDefinition(2 * count + 3, DefUse::OPERAND1), count + 1);
+}
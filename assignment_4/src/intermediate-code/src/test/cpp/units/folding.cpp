@@ -0,0 +1,232 @@
+#include "../support/fixture.h"
+#include "../../../src/main/cpp/intermediatecode/generator/folding/constantfolder.h"
+#include <node.h>
+#include <syntaxtree.h>
+
+#include <sstream>
+
+class FoldingTest: public IntermediateCorrectTest {
+protected:
+    ConstantFolder folder;
+
+    template<typename T>
+    static BinaryNode* binary(NodeType nodeType, ReturnType rt, T lhs, T rhs) {
+        auto* node = new BinaryNode(nodeType, rt);
+        node->setLeftChild(SyntaxTree::createNumNode<T>(lhs, rt));
+        node->setRightChild(SyntaxTree::createNumNode<T>(rhs, rt));
+        return node;
+    }
+
+    template<typename T>
+    static testing::AssertionResult is_constant(const Node* node, ReturnType rt, T expected) {
+        const auto* constant = node_cast<const ConstantNode<T>>(node);
+        if (!constant)
+            return testing::AssertionFailure() << "Expected a constant node, found " << *node;
+        if (constant->getReturnType() != rt)
+            return testing::AssertionFailure() << "Constant has return type " << util::to_string(constant->getReturnType()) << ", expected " << util::to_string(rt);
+        if (constant->getValue() != expected)
+            return testing::AssertionFailure() << "Constant has value " << std::to_string(constant->getValue()) << ", expected " << std::to_string(expected);
+        return testing::AssertionSuccess();
+    }
+};
+
+/**
+ * Tests for constant folding in ICGenerator::preprocess
+ */
+
+TEST_F(FoldingTest, int8_wraparound) {
+    Node* node = folder.fold_expr(binary<int8_t>(NODE_ADD, RT_INT8, 100, 100));
+    EXPECT_TRUE(is_constant<int8_t>(node, RT_INT8, -56));
+    delete node;
+}
+
+TEST_F(FoldingTest, uint8_wraparound) {
+    Node* node = folder.fold_expr(binary<uint8_t>(NODE_SUB, RT_UINT8, 0, 1));
+    EXPECT_TRUE(is_constant<uint8_t>(node, RT_UINT8, 255));
+    delete node;
+}
+
+TEST_F(FoldingTest, unsigned_wraparound) {
+    Node* node = folder.fold_expr(binary<unsigned>(NODE_MUL, RT_UINT, 65536, 65536));
+    EXPECT_TRUE(is_constant<unsigned>(node, RT_UINT, 0));
+    delete node;
+}
+
+TEST_F(FoldingTest, int_mod) {
+    Node* node = folder.fold_expr(binary<int>(NODE_MOD, RT_INT, -7, 3));
+    EXPECT_TRUE(is_constant<int>(node, RT_INT, -1));
+    delete node;
+}
+
+TEST_F(FoldingTest, coercion) {
+    auto* node = new UnaryNode(NODE_COERCION, RT_UINT);
+    node->setChild(SyntaxTree::createNumNode<int8_t>(-1, RT_INT8));
+    Node* folded = folder.fold_expr(node);
+    EXPECT_TRUE(is_constant<unsigned>(folded, RT_UINT, 4294967295u));
+    delete folded;
+}
+
+TEST_F(FoldingTest, nested) {
+    // (int) (int8) 3 * 4 + 1
+    auto* coercion = new UnaryNode(NODE_COERCION, RT_INT);
+    coercion->setChild(binary<int8_t>(NODE_MUL, RT_INT8, 3, 4));
+    auto* node = new BinaryNode(NODE_ADD, RT_INT);
+    node->setLeftChild(coercion);
+    node->setRightChild(SyntaxTree::createNumNode<int>(1, RT_INT));
+    Node* folded = folder.fold_expr(node);
+    EXPECT_TRUE(is_constant<int>(folded, RT_INT, 13));
+    delete folded;
+}
+
+TEST_F(FoldingTest, division_by_zero_kept) {
+    Node* node = folder.fold_expr(binary<int>(NODE_IDIV, RT_INT, 1, 0));
+    EXPECT_EQ(node->getNodeType(), NODE_IDIV);
+    delete node;
+}
+
+TEST_F(FoldingTest, identity_mul_one) {
+    auto* node = new BinaryNode(NODE_MUL, RT_INT);
+    auto* var = new SymbolNode(NODE_ID, RT_INT, 1);
+    node->setLeftChild(var);
+    node->setRightChild(SyntaxTree::createNumNode<int>(1, RT_INT));
+    Node* folded = folder.fold_expr(node);
+    EXPECT_EQ(folded, var);
+    delete folded;
+}
+
+TEST_F(FoldingTest, identity_add_zero) {
+    auto* node = new BinaryNode(NODE_ADD, RT_INT);
+    auto* var = new SymbolNode(NODE_ID, RT_INT, 1);
+    node->setLeftChild(SyntaxTree::createNumNode<int>(0, RT_INT));
+    node->setRightChild(var);
+    Node* folded = folder.fold_expr(node);
+    EXPECT_EQ(folded, var);
+    delete folded;
+}
+
+TEST_F(FoldingTest, mul_zero_pure) {
+    auto* node = new BinaryNode(NODE_MUL, RT_INT);
+    node->setLeftChild(new SymbolNode(NODE_ID, RT_INT, 1));
+    node->setRightChild(SyntaxTree::createNumNode<int>(0, RT_INT));
+    Node* folded = folder.fold_expr(node);
+    EXPECT_TRUE(is_constant<int>(folded, RT_INT, 0));
+    delete folded;
+}
+
+TEST_F(FoldingTest, mul_zero_side_effects) {
+    auto* call = new BinaryNode(NODE_FUNCTIONCALL, RT_INT);
+    call->setLeftChild(new SymbolNode(NODE_ID, RT_INT, 1));
+    call->setRightChild(SyntaxTree::createLeaf());
+    auto* node = new BinaryNode(NODE_MUL, RT_INT);
+    node->setLeftChild(call);
+    node->setRightChild(SyntaxTree::createNumNode<int>(0, RT_INT));
+    Node* folded = folder.fold_expr(node);
+    EXPECT_EQ(folded, node);
+    delete folded;
+}
+
+TEST_F(FoldingTest, if_constant_condition) {
+    auto* cond = binary<int>(NODE_REL_LT, RT_INT, 1, 2);
+    cond->setReturnType(RT_BOOL);
+    auto* body = SyntaxTree::createListNode(NODE_STATEMENT_LIST);
+    body->addChild(SyntaxTree::createLeaf());
+    auto* ifNode = new BinaryNode(NODE_IF, RT_VOID);
+    ifNode->setLeftChild(cond);
+    ifNode->setRightChild(body);
+    auto* root = SyntaxTree::createListNode(NODE_STATEMENT_LIST);
+    root->addChild(ifNode);
+
+    folder.fold(root);
+    ASSERT_EQ(root->size(), 1u);
+    EXPECT_EQ(root->getChild(0), body);
+    delete root;
+}
+
+TEST_F(FoldingTest, shared_subexpressions) {
+    Arena arena;
+    Arena::Scope scope(arena);
+    SyntaxTree::HashConsing consing;
+    Node* sum = SyntaxTree::createParentNode(NODE_ADD, RT_INT, SyntaxTree::createIdNode(1, RT_INT), SyntaxTree::createNumNode<int>(0, RT_INT));
+    ASSERT_EQ(SyntaxTree::createParentNode(NODE_ADD, RT_INT, SyntaxTree::createIdNode(1, RT_INT), SyntaxTree::createNumNode<int>(0, RT_INT)), sum);
+    EXPECT_NE(SyntaxTree::createParentNode(NODE_ADD, RT_INT, SyntaxTree::createIdNode(2, RT_INT), SyntaxTree::createNumNode<int>(0, RT_INT)), sum);
+
+    // x + 0 folds to x on both sides, without breaking up the shared node
+    auto* product = node_as<BinaryNode>(SyntaxTree::createParentNode(NODE_MUL, RT_INT, sum, sum));
+    Node* folded = folder.fold_expr(product);
+    ASSERT_EQ(folded, product);
+    EXPECT_EQ(product->getLeftChild()->getNodeType(), NODE_ID);
+    EXPECT_EQ(product->getLeftChild(), product->getRightChild());
+    EXPECT_EQ(node_as<BinaryNode>(sum)->getLeftChild(), product->getLeftChild());
+}
+
+TEST_F(FoldingTest, fingerprints_follow_folding) {
+    // x * (1 + 2) folds in place to x * 3, which must fingerprint like a tree built that way
+    Node* product = SyntaxTree::createParentNode(NODE_MUL, RT_INT, SyntaxTree::createIdNode(1, RT_INT), binary<int>(NODE_ADD, RT_INT, 1, 2));
+    auto* list = SyntaxTree::createListNode(NODE_EXPRLIST);
+    list->addChild(product);
+    ASSERT_EQ(folder.fold_expr(list), list);
+    Node* expected = SyntaxTree::createParentNode(NODE_MUL, RT_INT, SyntaxTree::createIdNode(1, RT_INT), SyntaxTree::createNumNode<int>(3, RT_INT));
+    auto* expected_list = SyntaxTree::createListNode(NODE_EXPRLIST);
+    expected_list->addChild(expected);
+    EXPECT_EQ(product->getFingerprint(), expected->getFingerprint());
+    EXPECT_EQ(list->getFingerprint(), expected_list->getFingerprint());
+    EXPECT_TRUE(*list == *expected_list);
+    delete list;
+    delete expected_list;
+}
+
+TEST_F(FoldingTest, stale_fingerprints_compare) {
+    // -x twice, where one x gets its return type after it was set on its parent: the parent fingerprints differ,
+    // but the trees are equal.
+    auto* lhs = new UnaryNode(NODE_SIGNMINUS, RT_INT);
+    lhs->setChild(SyntaxTree::createIdNode(1, RT_INT));
+    auto* rhs = new UnaryNode(NODE_SIGNMINUS, RT_INT);
+    Node* id = SyntaxTree::createIdNode(1, RT_UNKNOWN);
+    rhs->setChild(id);
+    id->setReturnType(RT_INT);
+    ASSERT_NE(lhs->getFingerprint(), rhs->getFingerprint());
+    EXPECT_TRUE(lhs->equal_to(*rhs, nullptr, nullptr));
+    EXPECT_TRUE(lhs->similar_to(*rhs, nullptr, nullptr));
+    std::ostringstream stream;
+    EXPECT_TRUE(lhs->similar_to_debug(*rhs, nullptr, nullptr, stream, 0, 4));
+    delete lhs;
+    delete rhs;
+}
+
+TEST_F(FoldingTest, deep_nesting) {
+    // 1 + 1 + ... + 1, nested deeper than a recursive walk could go on the native stack
+    const int depth = 200000;
+    Node* node = SyntaxTree::createNumNode<int>(1, RT_INT);
+    for (int x = 0; x < depth; ++x)
+        node = SyntaxTree::createParentNode(NODE_ADD, RT_INT, node, SyntaxTree::createNumNode<int>(1, RT_INT));
+    Node* copy = SyntaxTree::createNumNode<int>(1, RT_INT);
+    for (int x = 0; x < depth; ++x)
+        copy = SyntaxTree::createParentNode(NODE_ADD, RT_INT, copy, SyntaxTree::createNumNode<int>(1, RT_INT));
+    EXPECT_TRUE(*node == *copy);
+    delete copy;
+
+    EXPECT_TRUE(ConstantFolder::is_pure(node));
+    Node* folded = folder.fold_expr(node);
+    EXPECT_TRUE(is_constant<int>(folded, RT_INT, depth + 1));
+    delete folded;
+}
+
+TEST_F(FoldingTest, deep_conditions) {
+    // 1 < 2 && (1 < 2 && (...)): boolean operands are evaluated, not folded, so they nest as deep as the expression
+    const int depth = 200000;
+    auto* condition = binary<int>(NODE_REL_LT, RT_INT, 1, 2);
+    condition->setReturnType(RT_BOOL);
+    Node* node = condition;
+    for (int x = 0; x < depth; ++x) {
+        auto* operand = binary<int>(NODE_REL_LT, RT_INT, 1, 2);
+        operand->setReturnType(RT_BOOL);
+        node = SyntaxTree::createParentNode(NODE_AND, RT_BOOL, operand, node);
+    }
+    int64_t value = -1;
+    EXPECT_TRUE(folder.evaluate(node, value));
+    EXPECT_EQ(value, 1);
+
+    std::ostringstream printed;
+    EXPECT_TRUE(node->similar_to_debug(*node, nullptr, nullptr, printed, 0, 0));
+    delete node;
+}
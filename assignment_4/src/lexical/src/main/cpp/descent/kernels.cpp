@@ -0,0 +1,192 @@
+#include "kernels.h"
+
+#include <cassert>
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define COCO_DESCENT_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using lexical::descent::Kernels;
+
+    inline bool is_whitespace(char c) {
+        return c == ' ' || c == '\t' || c == '\n';
+    }
+
+    inline bool is_identifier_char(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    const char* scalar_skip_whitespace(const char* cur, const char* end, int& lines) {
+        for (; cur != end && is_whitespace(*cur); ++cur)
+            lines += *cur == '\n';
+        return cur;
+    }
+
+    const char* scalar_comment_end(const char* cur, const char* end) {
+        for (; cur != end; ++cur) {
+            if (*cur == '*' && cur + 1 != end && cur[1] == '/')
+                return cur;
+        }
+        return end;
+    }
+
+    const char* scalar_identifier_end(const char* cur, const char* end) {
+        while (cur != end && is_identifier_char(*cur))
+            ++cur;
+        return cur;
+    }
+
+    const Kernels SCALAR = {"scalar", scalar_skip_whitespace, scalar_comment_end, scalar_identifier_end};
+
+#ifdef COCO_DESCENT_X86
+    // The vector kernels below work the same way for 16 (SSE2) and 32 (AVX2) bytes:
+    // they compare a whole block into a bitmask (bit i for byte i) and find the first interesting byte with a bit scan.
+    // The remainder of the input that does not fill a block is left to the scalar kernels.
+
+    // Mask of the bits below bit `n`.
+    inline uint32_t below(unsigned n) {
+        return n >= 32 ? ~0u : (1u << n) - 1;
+    }
+
+    inline uint32_t sse2_whitespace(__m128i block, uint32_t& newlines) {
+        const __m128i newline = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+        newlines = static_cast<uint32_t>(_mm_movemask_epi8(newline));
+        const __m128i space = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\t')));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(space, newline)));
+    }
+
+    // Bytes in ['lo', 'hi']. Signed compares are fine: bytes >= 0x80 compare as negative and are never in an ASCII range.
+    inline __m128i sse2_in_range(__m128i block, char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(lo - 1))), _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(hi + 1)), block));
+    }
+
+    const char* sse2_skip_whitespace(const char* cur, const char* end, int& lines) {
+        for (; end - cur >= 16; cur += 16) {
+            uint32_t newlines;
+            const uint32_t whitespace = sse2_whitespace(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur)), newlines);
+            if (whitespace != 0xFFFFu) {
+                const unsigned n = __builtin_ctz(~whitespace);
+                lines += __builtin_popcount(newlines & below(n));
+                return cur + n;
+            }
+            lines += __builtin_popcount(newlines);
+        }
+        return scalar_skip_whitespace(cur, end, lines);
+    }
+
+    const char* sse2_comment_end(const char* cur, const char* end) {
+        // Compares the block and the block shifted by one byte, so the `/` may lie just past the block.
+        for (; end - cur >= 17; cur += 16) {
+            const __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur)), _mm_set1_epi8('*'));
+            const __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + 1)), _mm_set1_epi8('/'));
+            const auto found = static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(star, slash)));
+            if (found)
+                return cur + __builtin_ctz(found);
+        }
+        return scalar_comment_end(cur, end);
+    }
+
+    const char* sse2_identifier_end(const char* cur, const char* end) {
+        for (; end - cur >= 16; cur += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur));
+            const __m128i letter = sse2_in_range(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 'z'); // 0x20 lower-cases letters
+            const __m128i digit = sse2_in_range(block, '0', '9');
+            const __m128i underscore = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+            const auto identifier = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore)));
+            if (identifier != 0xFFFFu)
+                return cur + __builtin_ctz(~identifier);
+        }
+        return scalar_identifier_end(cur, end);
+    }
+
+    const Kernels SSE2 = {"sse2", sse2_skip_whitespace, sse2_comment_end, sse2_identifier_end};
+
+    __attribute__((target("avx2"))) inline uint32_t avx2_whitespace(__m256i block, uint32_t& newlines) {
+        const __m256i newline = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'));
+        newlines = static_cast<uint32_t>(_mm256_movemask_epi8(newline));
+        const __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(space, newline)));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_in_range(__m256i block, char lo, char hi) {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8(static_cast<char>(lo - 1))), _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), block));
+    }
+
+    __attribute__((target("avx2"))) const char* avx2_skip_whitespace(const char* cur, const char* end, int& lines) {
+        for (; end - cur >= 32; cur += 32) {
+            uint32_t newlines;
+            const uint32_t whitespace = avx2_whitespace(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur)), newlines);
+            if (whitespace != ~0u) {
+                const unsigned n = __builtin_ctz(~whitespace);
+                lines += __builtin_popcount(newlines & below(n));
+                return cur + n;
+            }
+            lines += __builtin_popcount(newlines);
+        }
+        return sse2_skip_whitespace(cur, end, lines);
+    }
+
+    __attribute__((target("avx2"))) const char* avx2_comment_end(const char* cur, const char* end) {
+        for (; end - cur >= 33; cur += 32) {
+            const __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur)), _mm256_set1_epi8('*'));
+            const __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur + 1)), _mm256_set1_epi8('/'));
+            const auto found = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(star, slash)));
+            if (found)
+                return cur + __builtin_ctz(found);
+        }
+        return sse2_comment_end(cur, end);
+    }
+
+    __attribute__((target("avx2"))) const char* avx2_identifier_end(const char* cur, const char* end) {
+        for (; end - cur >= 32; cur += 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cur));
+            const __m256i letter = avx2_in_range(_mm256_or_si256(block, _mm256_set1_epi8(0x20)), 'a', 'z');
+            const __m256i digit = avx2_in_range(block, '0', '9');
+            const __m256i underscore = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('_'));
+            const auto identifier = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), underscore)));
+            if (identifier != ~0u)
+                return cur + __builtin_ctz(~identifier);
+        }
+        return sse2_identifier_end(cur, end);
+    }
+
+    const Kernels AVX2 = {"avx2", avx2_skip_whitespace, avx2_comment_end, avx2_identifier_end};
+#endif
+}
+
+bool lexical::descent::supported(KernelSet set) {
+    switch (set) {
+        case KERNELS_SCALAR:
+            return true;
+#ifdef COCO_DESCENT_X86
+        case KERNELS_SSE2:
+            return true; // Part of the x86-64 baseline, and required by this build (__SSE2__).
+        case KERNELS_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const lexical::descent::Kernels& lexical::descent::kernels(KernelSet set) {
+    assert(supported(set));
+    switch (set) {
+#ifdef COCO_DESCENT_X86
+        case KERNELS_SSE2:
+            return SSE2;
+        case KERNELS_AVX2:
+            return AVX2;
+#endif
+        default:
+            return SCALAR;
+    }
+}
+
+const lexical::descent::Kernels& lexical::descent::kernels() {
+    static const Kernels& best = kernels(supported(KERNELS_AVX2) ? KERNELS_AVX2 : supported(KERNELS_SSE2) ? KERNELS_SSE2 : KERNELS_SCALAR);
+    return best;
+}
@@ -0,0 +1,40 @@
+#ifndef COCO_FRAMEWORK_LEXICAL_DESCENT_KERNELS
+#define COCO_FRAMEWORK_LEXICAL_DESCENT_KERNELS
+
+#include <cstddef>
+
+namespace lexical {
+    namespace descent {
+        // Instruction sets the scanner kernels are built for. Later ones are faster, if the CPU supports them.
+        enum KernelSet {
+            KERNELS_SCALAR,
+            KERNELS_SSE2,
+            KERNELS_AVX2,
+        };
+
+        /**
+         * The inner loops of the scanner, which look at many bytes per step where the instruction set allows.
+         * All kernels scan [cur, end) and never read outside of it.
+         */
+        struct Kernels {
+            const char* name;
+            // Skips spaces, tabs and newlines. Adds the number of skipped newlines to `lines`.
+            const char* (*skip_whitespace)(const char* cur, const char* end, int& lines);
+            // Finds the `*` of the first `*/`, or returns `end` if there is none.
+            const char* (*comment_end)(const char* cur, const char* end);
+            // Skips letters, digits and underscores.
+            const char* (*identifier_end)(const char* cur, const char* end);
+        };
+
+        // Whether this build and the running CPU support `set`. KERNELS_SCALAR is always supported.
+        bool supported(KernelSet set);
+
+        // Kernels for `set`. `set` must be supported.
+        const Kernels& kernels(KernelSet set);
+
+        // Kernels for the best instruction set the running CPU supports, selected once on first use.
+        const Kernels& kernels();
+    }
+}
+
+#endif
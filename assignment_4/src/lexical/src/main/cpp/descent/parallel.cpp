@@ -0,0 +1,106 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <interner.h>
+#include <logger.h>
+
+#include "parser.h"
+#include "scanner.h"
+#include "tape.h"
+
+std::vector<lexical::descent::Chunk> lexical::descent::split(const char* begin, const char* end, int& lines) {
+    ParseContext ctx;
+    Scanner scanner(begin, end, ctx);
+    std::vector<Chunk> chunks;
+    Chunk chunk{begin, begin, 1};
+    bool pending = false; // Tokens since the last boundary
+    for (size_t braces = 0;;) {
+        const Token token = scanner.next();
+        if (token == TOK_ENDFILE)
+            break;
+        if (token == TOK_INVALID) {
+            chunk.end = end;
+            chunks.push_back(chunk);
+            lines = ctx.lineno;
+            return chunks;
+        }
+        pending = true;
+        bool boundary = false;
+        if (token == TOK_LBRACE) {
+            ++braces;
+        } else if (token == TOK_RBRACE) {
+            boundary = braces <= 1; // A stray `}` ends a (broken) declaration as well
+            braces = braces > 0 ? braces - 1 : 0;
+        } else if (token == TOK_SEMI) {
+            boundary = braces == 0;
+        }
+        if (boundary) {
+            chunk.end = scanner.text() + scanner.length();
+            chunks.push_back(chunk);
+            chunk = Chunk{chunk.end, chunk.end, ctx.lineno};
+            pending = false;
+        }
+    }
+    // Unterminated last declaration, or an input without any
+    if (pending || chunks.empty()) {
+        chunk.end = end;
+        chunks.push_back(chunk);
+    }
+    lines = ctx.lineno;
+    return chunks;
+}
+
+namespace {
+    /** Result of parsing one chunk, like `yyparse`. */
+    struct ChunkParse {
+        lexical::descent::Tape tape;
+        int result = 0;
+    };
+
+    void parse_chunk(const lexical::descent::Chunk& chunk, bool first, ChunkParse& out) {
+        ParseContext ctx;
+        ctx.lineno = chunk.line;
+        Logger logger(NULL_STREAM, NULL_STREAM, NULL_STREAM); // The tape takes all messages
+        lexical::descent::TapeVisitor vis(logger, out.tape);
+        vis.context = &ctx;
+        out.result = lexical::descent::Parser(chunk.begin, chunk.end, ctx, vis).parse_chunk(first);
+    }
+}
+
+int lexical::descent::parse_parallel(const char* begin, const char* end, BaseVisitor& vis, ParseContext& ctx, unsigned threads) {
+    int lines;
+    const std::vector<Chunk> chunks = split(begin, end, lines);
+    std::vector<ChunkParse> parses(chunks.size());
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<size_t>(threads, chunks.size()));
+    std::atomic<size_t> next{0};
+    Interner& interner = Interner::current(); // Workers intern names where the calling thread looks them up
+    const auto work = [&]() {
+        Interner::Scope scope(interner);
+        for (size_t x; (x = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size();)
+            parse_chunk(chunks[x], x == 0, parses[x]);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned x = 1; x < threads; ++x)
+        workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // The sequential parser stops at the first error, so the calls of later chunks are dropped.
+    ctx.lineno = 1;
+    vis.program_start();
+    for (const ChunkParse& parse : parses) {
+        replay(parse.tape, vis, ctx);
+        if (parse.result != 0)
+            return parse.result;
+    }
+    ctx.lineno = lines;
+    vis.visit_program();
+    return 0;
+}
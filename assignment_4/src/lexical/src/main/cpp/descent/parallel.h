@@ -0,0 +1,38 @@
+#ifndef COCO_FRAMEWORK_LEXICAL_DESCENT_PARALLEL
+#define COCO_FRAMEWORK_LEXICAL_DESCENT_PARALLEL
+
+#include <vector>
+
+#include "basevisitor.h"
+#include "parsecontext.h"
+
+namespace lexical {
+    namespace descent {
+        // A run of source holding (at most) one top-level declaration, with the whitespace before it.
+        struct Chunk {
+            const char* begin;
+            const char* end;
+            int line; // Line at `begin`
+        };
+
+        /**
+         * Splits [begin, end) after every `;` outside of braces and every `}` closing the outermost brace, which is
+         * where top-level declarations end. Anything after an unscannable token is kept in the last chunk.
+         * Trailing whitespace gets no chunk of its own, but an empty input gives one empty chunk.
+         * @param lines Set to the line at the end of the input.
+         */
+        std::vector<Chunk> split(const char* begin, const char* end, int& lines);
+
+        /**
+         * Parses [begin, end) like Parser::parse, with the top-level declarations parsed on `threads` threads
+         * (0 for one per core). Each thread records the visitor calls of its declarations on a tape; the tapes are
+         * replayed onto `vis` on the calling thread, in source order, so `vis` sees the calls of a sequential parse.
+         * Only scanning and parsing run in parallel: the work `vis` does (symbols, trees) stays single-threaded, which
+         * bounds the speedup by the share of the replay (see FrontendTest.DISABLED_throughput).
+         * `vis` must have `ctx` as its context.
+         */
+        int parse_parallel(const char* begin, const char* end, BaseVisitor& vis, ParseContext& ctx, unsigned threads = 0);
+    }
+}
+
+#endif
@@ -0,0 +1,485 @@
+#include "parser.h"
+
+#include <interner.h>
+#include <listtree.h>
+
+namespace {
+    using lexical::descent::Token;
+
+    /** Operator level whose operands are factors. */
+    constexpr uint8_t FACTOR_LEVEL = 3;
+
+    /** Whether `token` can start a statement (`statement` in compiler.y). */
+    inline bool starts_statement(Token token) {
+        using namespace lexical::descent;
+        switch (token) {
+            case TOK_SEMI:
+            case TOK_LBRACE:
+            case TOK_RETURN:
+            case TOK_ID:
+            case TOK_NUM:
+            case TOK_LPAREN:
+            case TOK_PLUS:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /** Whether `token` is a binary operator of `level`, and if so, which one. */
+    inline bool binary_operator(uint8_t level, Token token, NodeType& op) {
+        using namespace lexical::descent;
+        switch (level) {
+            case 0:
+                op = token == TOK_OR ? NODE_OR : NODE_AND;
+                return token == TOK_OR || token == TOK_AND;
+            case 1:
+                op = token == TOK_EQ ? NODE_REL_EQUAL : NODE_REL_NOTEQUAL;
+                return token == TOK_EQ || token == TOK_NEQ;
+            case 2:
+                op = NODE_ADD;
+                return token == TOK_PLUS;
+            default:
+                op = NODE_MUL;
+                return token == TOK_TIMES;
+        }
+    }
+}
+
+int lexical::descent::Parser::parse() {
+    vis.program_start();
+    if (!declaration())
+        return 1;
+    while (peek() != TOK_ENDFILE) {
+        if (peek() != TOK_VOID) {
+            syntax_error({TOK_ENDFILE, TOK_VOID});
+            return 1;
+        }
+        if (!declaration())
+            return 1;
+    }
+    if (!parse_referenced())
+        return 1;
+    vis.visit_program();
+    return 0;
+}
+
+int lexical::descent::Parser::parse_chunk(bool first) {
+    if (!first && peek() != TOK_VOID) {
+        syntax_error({TOK_ENDFILE, TOK_VOID});
+        return 1;
+    }
+    if (!declaration())
+        return 1;
+    if (peek() != TOK_ENDFILE) {
+        syntax_error({TOK_ENDFILE, TOK_VOID});
+        return 1;
+    }
+    return 0;
+}
+
+lexical::descent::Token lexical::descent::Parser::peek() {
+    if (!has_lookahead) {
+        lookahead = scanner.next();
+        has_lookahead = true;
+    }
+    return lookahead;
+}
+
+void lexical::descent::Parser::consume() {
+    has_lookahead = false;
+}
+
+bool lexical::descent::Parser::expect(Token token) {
+    if (peek() != token)
+        return syntax_error({token});
+    consume();
+    return true;
+}
+
+const std::string& lexical::descent::Parser::lexeme() {
+    return Interner::current().str(lexeme_atom());
+}
+
+Atom lexical::descent::Parser::lexeme_atom() {
+    return Interner::current().intern(scanner.text(), scanner.length());
+}
+
+std::string lexical::descent::Parser::number() {
+    return std::string(scanner.text(), scanner.length());
+}
+
+bool lexical::descent::Parser::syntax_error(std::initializer_list<Token> expected) {
+    std::string message = "syntax error, unexpected ";
+    message += token_name(peek());
+    const char* separator = ", expecting ";
+    for (Token token : expected) {
+        message += separator;
+        message += token_name(token);
+        separator = " or ";
+    }
+    vis.syntax_error(message);
+    return false;
+}
+
+bool lexical::descent::Parser::declaration() {
+    if (!expect(TOK_VOID))
+        return false;
+    const ReturnType rt = RT_VOID;
+    if (!expect(TOK_ID))
+        return false;
+    const std::string& name = lexeme();
+    if (peek() == TOK_LPAREN)
+        return fun_declaration(rt, name);
+    vis.visit_var_decl(name);
+    return var_identifiers(rt);
+}
+
+bool lexical::descent::Parser::var_identifiers(ReturnType rt) {
+    while (peek() == TOK_COMMA) {
+        consume();
+        if (!expect(TOK_ID))
+            return false;
+        vis.visit_var_decl(lexeme());
+    }
+    if (peek() != TOK_SEMI)
+        return syntax_error({TOK_SEMI, TOK_COMMA});
+    consume();
+    vis.register_declarations(rt);
+    return true;
+}
+
+bool lexical::descent::Parser::var_declaration() {
+    if (!expect(TOK_VOID) || !expect(TOK_ID))
+        return false;
+    vis.visit_var_decl(lexeme());
+    return var_identifiers(RT_VOID);
+}
+
+bool lexical::descent::Parser::fun_declaration(ReturnType rt, const std::string& name) {
+    consume(); // LPAREN
+    vis.visit_func_start(rt, name);
+    if (!expect(TOK_VOID) || !expect(TOK_RPAREN))
+        return false;
+    if (lazy && name != "main")
+        return defer_body(name);
+    Node* body;
+    if (!compound_stmt(body))
+        return false;
+    vis.visit_func_end(name, body);
+    return true;
+}
+
+bool lexical::descent::Parser::compound_stmt(Node*& out) {
+    return run(RULE_COMPOUND, out);
+}
+
+struct lexical::descent::Parser::Frame {
+    explicit Frame(Rule rule, uint8_t level = 0) : rule(rule), level(level) {}
+
+    Rule rule;
+    // Where to continue once the rule called last returns its node
+    uint8_t step = 0;
+    // Operator level of RULE_OPERATORS, from 0 (`||` and `&&`) to FACTOR_LEVEL (`*`)
+    uint8_t level;
+    NodeType op = NODE_EMPTY;
+    // Left operand, assigned variable or arguments; for RULE_OPERATORS with `has_first`, the leftmost factor
+    Node* node = nullptr;
+    bool has_first = false;
+    // Identifier of RULE_EXPRESSION and RULE_IDENTIFIER, interned
+    const std::string* name = nullptr;
+    ListTree list;
+};
+
+bool lexical::descent::Parser::run(Rule rule, Node*& out) {
+    std::vector<Frame> stack;
+    stack.emplace_back(rule);
+    // Node returned by the rule that finished last
+    Node* result = nullptr;
+    while (!stack.empty()) {
+        // `frame` dangles once a rule is pushed, so every push is followed by `continue`.
+        Frame& frame = stack.back();
+        switch (frame.rule) {
+            case RULE_COMPOUND:
+                if (frame.step == 0) {
+                    if (!expect(TOK_LBRACE))
+                        return false;
+                    vis.add_local_scope();
+                    frame.step = 1;
+                    stack.emplace_back(RULE_BODY);
+                    continue;
+                }
+                if (!expect(TOK_RBRACE))
+                    return false;
+                vis.leave_current_scope();
+                stack.pop_back();
+                continue;
+
+            case RULE_BODY:
+                if (frame.step == 0) {
+                    if (peek() == TOK_RBRACE) {
+                        result = vis.empty();
+                        stack.pop_back();
+                        continue;
+                    }
+                    while (peek() == TOK_VOID) {
+                        if (!var_declaration())
+                            return false;
+                    }
+                    frame.step = 1;
+                    stack.emplace_back(RULE_STATEMENT);
+                    continue;
+                }
+                vis.visit_statement_list(result, frame.list);
+                if (starts_statement(peek())) {
+                    stack.emplace_back(RULE_STATEMENT);
+                    continue;
+                }
+                result = frame.list.root; // Like compiler.y, even if the visitor left the list empty
+                stack.pop_back();
+                continue;
+
+            case RULE_STATEMENT:
+                if (frame.step == 0) {
+                    switch (peek()) {
+                        case TOK_LBRACE:
+                            frame = Frame(RULE_COMPOUND);
+                            continue;
+                        case TOK_RETURN:
+                            frame = Frame(RULE_RETURN);
+                            continue;
+                        case TOK_SEMI:
+                            consume();
+                            result = vis.empty();
+                            stack.pop_back();
+                            continue;
+                        default:
+                            frame.step = 1;
+                            stack.emplace_back(RULE_EXPRESSION);
+                            continue;
+                    }
+                }
+                if (!expect(TOK_SEMI))
+                    return false;
+                stack.pop_back();
+                continue;
+
+            case RULE_RETURN:
+                if (frame.step == 0) {
+                    consume(); // RETURN
+                    if (peek() == TOK_SEMI) {
+                        consume();
+                        result = vis.visit_return(vis.empty());
+                        stack.pop_back();
+                        continue;
+                    }
+                    frame.step = 1;
+                    stack.emplace_back(RULE_EXPRESSION);
+                    continue;
+                }
+                if (!expect(TOK_SEMI))
+                    return false;
+                result = vis.visit_return(result);
+                stack.pop_back();
+                continue;
+
+            case RULE_EXPRESSION:
+                if (frame.step == 0) {
+                    if (peek() != TOK_ID) {
+                        frame = Frame(RULE_OPERATORS);
+                        continue;
+                    }
+                    // `var ASSIGN expression` and factors starting with an identifier share their first token.
+                    consume();
+                    const std::string* name = &lexeme();
+                    if (peek() == TOK_ASSIGN) {
+                        consume();
+                        frame.node = vis.visit_lvariable(*name);
+                        frame.step = 1;
+                        stack.emplace_back(RULE_EXPRESSION);
+                        continue;
+                    }
+                    frame.step = 2;
+                    stack.emplace_back(RULE_IDENTIFIER);
+                    stack.back().name = name;
+                    continue;
+                }
+                if (frame.step == 1) {
+                    result = vis.visit_assignment(frame.node, result);
+                    stack.pop_back();
+                    continue;
+                }
+                // The operator levels start with the factor parsed already.
+                frame = Frame(RULE_OPERATORS);
+                frame.node = result;
+                frame.has_first = true;
+                continue;
+
+            case RULE_OPERATORS:
+                if (frame.step == 0) {
+                    frame.step = 1;
+                    if (frame.level < FACTOR_LEVEL) {
+                        Frame operand(RULE_OPERATORS, static_cast<uint8_t>(frame.level + 1));
+                        operand.node = frame.node;
+                        operand.has_first = frame.has_first;
+                        stack.push_back(operand);
+                        continue;
+                    }
+                    if (!frame.has_first) {
+                        stack.emplace_back(RULE_FACTOR);
+                        continue;
+                    }
+                    result = frame.node;
+                }
+                if (frame.step == 2)
+                    result = vis.visit_operator(frame.op, frame.node, result);
+                // `result` is the left operand of the next operator of this level, if any.
+                frame.node = result;
+                if (!binary_operator(frame.level, peek(), frame.op)) {
+                    stack.pop_back();
+                    continue;
+                }
+                consume();
+                frame.step = 2;
+                if (frame.level < FACTOR_LEVEL)
+                    stack.emplace_back(RULE_OPERATORS, static_cast<uint8_t>(frame.level + 1));
+                else
+                    stack.emplace_back(RULE_FACTOR);
+                continue;
+
+            case RULE_FACTOR:
+                if (frame.step == 0) {
+                    switch (peek()) {
+                        case TOK_LPAREN:
+                            consume();
+                            frame.step = 1;
+                            stack.emplace_back(RULE_EXPRESSION);
+                            continue;
+                        case TOK_ID: {
+                            consume();
+                            const std::string* name = &lexeme();
+                            frame = Frame(RULE_IDENTIFIER);
+                            frame.name = name;
+                            continue;
+                        }
+                        case TOK_NUM:
+                            consume();
+                            result = vis.visit_number(number());
+                            stack.pop_back();
+                            continue;
+                        case TOK_PLUS:
+                            consume();
+                            frame.step = 2;
+                            stack.emplace_back(RULE_FACTOR);
+                            continue;
+                        default:
+                            return syntax_error({TOK_PLUS, TOK_LPAREN, TOK_ID, TOK_NUM});
+                    }
+                }
+                if (frame.step == 1) {
+                    if (!expect(TOK_RPAREN))
+                        return false;
+                } else {
+                    result = vis.visit_operator(NODE_SIGNPLUS, result);
+                }
+                stack.pop_back();
+                continue;
+
+            case RULE_IDENTIFIER:
+                if (frame.step == 0) {
+                    if (peek() != TOK_LPAREN) {
+                        result = vis.visit_rvariable(*frame.name);
+                        stack.pop_back();
+                        continue;
+                    }
+                    consume();
+                    if (peek() == TOK_RPAREN) {
+                        frame.node = vis.empty();
+                    } else {
+                        frame.step = 1;
+                        stack.emplace_back(RULE_EXPRESSION);
+                        continue;
+                    }
+                } else if (frame.step == 1) {
+                    vis.visit_exprlist(result, frame.list);
+                    if (peek() == TOK_COMMA) {
+                        consume();
+                        stack.emplace_back(RULE_EXPRESSION);
+                        continue;
+                    }
+                    frame.node = frame.list.root;
+                }
+                if (!expect(TOK_RPAREN))
+                    return false;
+                result = vis.visit_funccall(*frame.name, frame.node);
+                if (lazy)
+                    reference(*frame.name);
+                stack.pop_back();
+                continue;
+        }
+    }
+    out = result;
+    return true;
+}
+
+bool lexical::descent::Parser::defer_body(const std::string& name) {
+    if (peek() != TOK_LBRACE)
+        return syntax_error({TOK_LBRACE});
+    const char* begin = scanner.text();
+    const int line = ctx.lineno;
+    for (size_t braces = 0;;) {
+        const Token token = peek();
+        if (token == TOK_ENDFILE || token == TOK_INVALID) {
+            // Unbalanced braces or a bad token: parse the body after all, so the error is reported as usual.
+            scanner.reset(begin, scanner.text() + scanner.length());
+            ctx.lineno = line;
+            has_lookahead = false;
+            Node* body;
+            if (!compound_stmt(body))
+                return false;
+            vis.visit_func_end(name, body);
+            return true;
+        }
+        consume();
+        if (token == TOK_LBRACE)
+            ++braces;
+        else if (token == TOK_RBRACE && --braces == 0)
+            break;
+    }
+
+    SourceSpan body;
+    body.begin = static_cast<size_t>(begin - source);
+    body.end = static_cast<size_t>(scanner.text() + scanner.length() - source);
+    body.line = line;
+    vis.visit_func_deferred(name, body);
+    deferred.emplace(Interner::current().intern(name), Deferred{body, false});
+    return true;
+}
+
+void lexical::descent::Parser::reference(const std::string& name) {
+    auto it = deferred.find(Interner::current().intern(name));
+    if (it == deferred.end() || it->second.referenced)
+        return;
+    it->second.referenced = true;
+    referenced.push_back(it->first);
+}
+
+bool lexical::descent::Parser::parse_referenced() {
+    const char* const end = scanner.text() + scanner.length();
+    // Parsing a body may reference further functions, which are appended while we go.
+    for (size_t x = 0; x < referenced.size(); ++x) {
+        const SourceSpan body = deferred.at(referenced[x]).body;
+        const std::string& name = Interner::current().str(referenced[x]);
+        scanner.reset(source + body.begin, source + body.end);
+        ctx.lineno = body.line;
+        has_lookahead = false;
+        vis.visit_func_resume(name);
+        Node* root;
+        if (!compound_stmt(root))
+            return false;
+        vis.visit_func_end(name, root);
+        vis.visit_func_resume_end(name);
+    }
+    scanner.reset(end, end);
+    return true;
+}
@@ -0,0 +1,104 @@
+#ifndef COCO_FRAMEWORK_LEXICAL_DESCENT_PARSER
+#define COCO_FRAMEWORK_LEXICAL_DESCENT_PARSER
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <interner.h>
+
+#include "basevisitor.h"
+#include "parsecontext.h"
+#include "scanner.h"
+
+namespace lexical {
+    namespace descent {
+        /**
+         * Recursive-descent parser for the grammar of compiler.y, calling the same BaseVisitor functions in the same order.
+         * Like the bison parser, it reads a lookahead token only when it needs one to decide, so `vis.lineno()`
+         * matches between both front ends. Statements and expressions are parsed with a heap-allocated stack of rules
+         * instead of recursion, so they can nest as deep as memory allows; left-recursive rules are loops.
+         *
+         * In lazy mode, the bodies of functions other than `main` are skipped and only their spans are kept.
+         * A skipped body is parsed once a parsed body calls its function, after all declarations.
+         */
+        class Parser {
+            public:
+            Parser(const char* begin, const char* end, ParseContext& ctx, BaseVisitor& vis, bool lazy = false)
+                : scanner(begin, end, ctx), source(begin), ctx(ctx), vis(vis), lazy(lazy) {}
+
+            /**
+             * Parses the whole input.
+             * @return 0 on success, 1 on a syntax error (like `yyparse`).
+             */
+            int parse();
+
+            /**
+             * Parses the input as one top-level declaration, e.g. a Chunk of `split`, without the
+             * `program_start` and `visit_program` calls. Reports errors like `parse` would for the declaration
+             * at this place in the program: `first` tells whether it is the first one.
+             * @return like `parse`.
+             */
+            int parse_chunk(bool first);
+
+            private:
+            // Grammar rules parsed on the rule stack (see `run`)
+            enum Rule : uint8_t {
+                RULE_COMPOUND,      // compound_stmt
+                RULE_BODY,          // local declarations and statement list of a compound_stmt
+                RULE_STATEMENT,
+                RULE_RETURN,        // return_stmt
+                RULE_EXPRESSION,
+                RULE_OPERATORS,     // one level of binary operators, from `||` and `&&` down to `*`
+                RULE_FACTOR,
+                RULE_IDENTIFIER,    // factor starting with an identifier: variable or call
+            };
+            struct Frame;
+
+            Token peek();
+            void consume();
+            bool expect(Token token);
+            // Text of the last consumed identifier, interned
+            const std::string& lexeme();
+            Atom lexeme_atom();
+            // Text of the last consumed number, which is not interned: literals are rarely repeated
+            std::string number();
+            bool syntax_error(std::initializer_list<Token> expected = {});
+
+            bool declaration();
+            bool var_identifiers(ReturnType rt);
+            bool var_declaration();
+            bool fun_declaration(ReturnType rt, const std::string& name);
+            bool compound_stmt(Node*& out);
+            // Parses `rule` and everything nested in it, one Frame per open rule. Each case continues a rule where the
+            // recursive parser would have returned to it.
+            bool run(Rule rule, Node*& out);
+
+            // Lazy mode
+            bool defer_body(const std::string& name);
+            void reference(const std::string& name);
+            bool parse_referenced();
+
+            Scanner scanner;
+            const char* const source;
+            ParseContext& ctx;
+            BaseVisitor& vis;
+            const bool lazy;
+            Token lookahead = TOK_ENDFILE;
+            bool has_lookahead = false;
+
+            struct Deferred {
+                SourceSpan body;
+                bool referenced = false;
+            };
+            // Skipped bodies, by function name
+            std::unordered_map<Atom, Deferred> deferred;
+            // Functions to parse the bodies of, in order of first reference
+            std::vector<Atom> referenced;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "scanner.h"
+
+#include <cstring>
+
+namespace {
+    using lexical::descent::Token;
+
+    inline bool is_digit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    inline bool is_identifier_start(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    struct Keyword {
+        const char* text;
+        size_t length;
+        Token token;
+    };
+
+    constexpr Keyword KEYWORDS[] = {
+        {"else", 4, lexical::descent::TOK_ELSE},
+        {"if", 2, lexical::descent::TOK_IF},
+        {"int", 3, lexical::descent::TOK_INT},
+        {"int8_t", 6, lexical::descent::TOK_INT8},
+        {"unsigned", 8, lexical::descent::TOK_UNSIGNED},
+        {"uint8_t", 7, lexical::descent::TOK_UINT8},
+        {"return", 6, lexical::descent::TOK_RETURN},
+        {"void", 4, lexical::descent::TOK_VOID},
+        {"while", 5, lexical::descent::TOK_WHILE},
+    };
+
+    constexpr size_t KEYWORD_SLOTS = 16;
+
+    // Perfect hash of the keywords: every keyword gets its own slot (checked below). `length` must be at least 1.
+    constexpr size_t keyword_hash(const char* text, size_t length) {
+        return (length + 6 * static_cast<unsigned char>(text[length - 1])) % KEYWORD_SLOTS;
+    }
+
+    constexpr bool keyword_hash_is_perfect() {
+        bool used[KEYWORD_SLOTS] = {};
+        for (const Keyword& keyword : KEYWORDS) {
+            const size_t slot = keyword_hash(keyword.text, keyword.length);
+            if (used[slot])
+                return false;
+            used[slot] = true;
+        }
+        return true;
+    }
+
+    static_assert(keyword_hash_is_perfect(), "keyword_hash must map every keyword to a different slot");
+
+    struct KeywordTable {
+        Keyword slots[KEYWORD_SLOTS];
+    };
+
+    constexpr KeywordTable make_keyword_table() {
+        KeywordTable table = {};
+        for (Keyword& slot : table.slots)
+            slot = {"", 0, lexical::descent::TOK_ID};
+        for (const Keyword& keyword : KEYWORDS)
+            table.slots[keyword_hash(keyword.text, keyword.length)] = keyword;
+        return table;
+    }
+
+    constexpr KeywordTable KEYWORD_TABLE = make_keyword_table();
+
+    // One hash, one length compare and at most one memcmp per identifier.
+    inline Token keyword_or_id(const char* text, size_t length) {
+        const Keyword& candidate = KEYWORD_TABLE.slots[keyword_hash(text, length)];
+        if (candidate.length == length && std::memcmp(text, candidate.text, length) == 0)
+            return candidate.token;
+        return lexical::descent::TOK_ID;
+    }
+}
+
+const char* lexical::descent::token_name(Token token) {
+    static const char* const names[] = {
+        "ENDFILE", "invalid token",
+        "ELSE", "IF", "INT", "INT8", "UNSIGNED", "UINT8", "RETURN", "VOID", "WHILE",
+        "PLUS", "MINUS", "TIMES", "OVER", "MOD", "AND", "OR", "LT", "LTE", "GT", "GTE", "EQ", "NEQ",
+        "ASSIGN", "SEMI", "COMMA", "LPAREN", "RPAREN", "LBRACKET", "RBRACKET", "LBRACE", "RBRACE",
+        "ID", "NUM",
+        "UMINUS", "NOT",
+    };
+    return names[token];
+}
+
+lexical::descent::Token lexical::descent::Scanner::next() {
+    for (;;) {
+        start = cur;
+        if (cur == end)
+            return TOK_ENDFILE;
+        const char c = *cur++;
+        switch (c) {
+            case ' ':
+            case '\t':
+            case '\n':
+                cur = kernels.skip_whitespace(start, end, ctx.lineno);
+                continue;
+            case '+': return TOK_PLUS;
+            case '-': return TOK_MINUS;
+            case '*': return TOK_TIMES;
+            case '%': return TOK_MOD;
+            case ';': return TOK_SEMI;
+            case ',': return TOK_COMMA;
+            case '(': return TOK_LPAREN;
+            case ')': return TOK_RPAREN;
+            case '[': return TOK_LBRACKET;
+            case ']': return TOK_RBRACKET;
+            case '{': return TOK_LBRACE;
+            case '}': return TOK_RBRACE;
+            case '<':
+                if (cur != end && *cur == '=') {
+                    ++cur;
+                    return TOK_LTE;
+                }
+                return TOK_LT;
+            case '>':
+                if (cur != end && *cur == '=') {
+                    ++cur;
+                    return TOK_GTE;
+                }
+                return TOK_GT;
+            case '=':
+                if (cur != end && *cur == '=') {
+                    ++cur;
+                    return TOK_EQ;
+                }
+                return TOK_ASSIGN;
+            case '!':
+                if (cur != end && *cur == '=') {
+                    ++cur;
+                    return TOK_NEQ;
+                }
+                return TOK_NOT;
+            case '|':
+                if (cur != end && *cur == '|') {
+                    ++cur;
+                    return TOK_OR;
+                }
+                return TOK_INVALID;
+            case '&':
+                if (cur != end && *cur == '&') {
+                    ++cur;
+                    return TOK_AND;
+                }
+                return TOK_INVALID;
+            case '/':
+                if (cur == end || *cur != '*')
+                    return TOK_OVER;
+                // Like compiler.l, newlines inside comments do not count towards the line number.
+                cur = kernels.comment_end(cur + 1, end);
+                if (cur == end) // Unclosed comment
+                    return TOK_INVALID;
+                cur += 2;
+                continue;
+            default:
+                if (is_identifier_start(c)) {
+                    cur = kernels.identifier_end(cur, end);
+                    return keyword_or_id(start, length());
+                }
+                if (is_digit(c)) {
+                    while (cur != end && is_digit(*cur))
+                        ++cur;
+                    return TOK_NUM;
+                }
+                return TOK_INVALID;
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef COCO_FRAMEWORK_LEXICAL_DESCENT_SCANNER
+#define COCO_FRAMEWORK_LEXICAL_DESCENT_SCANNER
+
+#include <cstddef>
+#include <cstdint>
+
+#include "kernels.h"
+#include "parsecontext.h"
+
+namespace lexical {
+    namespace descent {
+        // Tokens of the C-minus grammar. Names and order follow the tokens of compiler.y.
+        enum Token : uint8_t {
+            TOK_ENDFILE,
+            TOK_INVALID, // Anything the scanner cannot match, or an unclosed comment.
+            TOK_ELSE, TOK_IF, TOK_INT, TOK_INT8, TOK_UNSIGNED, TOK_UINT8, TOK_RETURN, TOK_VOID, TOK_WHILE,
+            TOK_PLUS, TOK_MINUS, TOK_TIMES, TOK_OVER, TOK_MOD, TOK_AND, TOK_OR, TOK_LT, TOK_LTE, TOK_GT, TOK_GTE, TOK_EQ, TOK_NEQ,
+            TOK_ASSIGN, TOK_SEMI, TOK_COMMA, TOK_LPAREN, TOK_RPAREN, TOK_LBRACKET, TOK_RBRACKET, TOK_LBRACE, TOK_RBRACE,
+            TOK_ID, TOK_NUM,
+            TOK_UMINUS, TOK_NOT,
+        };
+
+        // The name bison uses for `token` in its error messages.
+        const char* token_name(Token token);
+
+        /**
+         * Hand-written scanner with the same token rules as compiler.l.
+         * Scans [begin, end) in place: lexemes point into the input.
+         * Whitespace, comment bodies and identifiers are skipped with `kernels`, by default the fastest the CPU supports.
+         */
+        class Scanner {
+            public:
+            Scanner(const char* begin, const char* end, ParseContext& ctx, const Kernels& kernels = lexical::descent::kernels())
+                : cur(begin), end(end), ctx(ctx), kernels(kernels) {}
+
+            // Scans the next token. Returns TOK_ENDFILE at (and after) the end of the input.
+            Token next();
+
+            // Continues scanning at `begin`, up to `end`.
+            void reset(const char* begin, const char* end) {
+                cur = begin;
+                this->end = end;
+                start = nullptr;
+            }
+
+            // The lexeme of the last scanned token.
+            const char* text() const { return start; }
+            size_t length() const { return static_cast<size_t>(cur - start); }
+
+            private:
+            const char* cur;
+            const char* end;
+            const char* start = nullptr;
+            ParseContext& ctx;
+            const Kernels& kernels;
+        };
+    }
+}
+
+#endif
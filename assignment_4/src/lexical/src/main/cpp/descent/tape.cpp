@@ -0,0 +1,232 @@
+#include "tape.h"
+
+#include <limits>
+
+#include <listtree.h>
+
+namespace {
+    inline uint32_t atom(const std::string& str) {
+        return Interner::current().intern(str);
+    }
+
+    inline const std::string& str(uint32_t atom) {
+        return Interner::current().str(atom);
+    }
+
+    // Node handles are never dereferenced: they only travel through the parser back into the tape.
+    inline uint32_t handle(const Node* node) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(node));
+    }
+
+    inline Node* node(uint32_t handle) {
+        return reinterpret_cast<Node*>(static_cast<uintptr_t>(handle));
+    }
+}
+
+Node* lexical::descent::TapeVisitor::record(EventType type, bool returns_node, uint32_t a, uint32_t b, uint32_t c, uint32_t d) const {
+    Event event{type, lineno(), returns_node ? ++tape.handles : 0, {a, b, c, d}};
+    tape.events.push_back(event);
+    return node(event.result);
+}
+
+uint32_t lexical::descent::TapeVisitor::text(const std::string& str) const {
+    const auto offset = static_cast<uint32_t>(tape.text.size());
+    tape.text += str;
+    return offset;
+}
+
+void lexical::descent::TapeVisitor::record_list(EventType type, Node* node, ListTree& list) const {
+    if (!list.root)
+        list.root = reinterpret_cast<ListNode*>(static_cast<uintptr_t>(++tape.handles));
+    record(type, false, handle(node), handle(list.root));
+}
+
+void lexical::descent::TapeVisitor::add_builtins() {
+    record(EV_ADD_BUILTINS, false);
+}
+
+void lexical::descent::TapeVisitor::program_start() {
+    record(EV_PROGRAM_START, false);
+}
+
+void lexical::descent::TapeVisitor::visit_program() {
+    record(EV_PROGRAM, false);
+}
+
+void lexical::descent::TapeVisitor::visit_func_start(ReturnType rt, const std::string& name) {
+    record(EV_FUNC_START, false, rt, atom(name));
+}
+
+void lexical::descent::TapeVisitor::visit_func_end(const std::string& name, Node* root) {
+    record(EV_FUNC_END, false, atom(name), handle(root));
+}
+
+void lexical::descent::TapeVisitor::visit_func_deferred(const std::string& name, const SourceSpan& body) {
+    tape.spans.push_back(body);
+    record(EV_FUNC_DEFERRED, false, atom(name), static_cast<uint32_t>(tape.spans.size() - 1));
+}
+
+void lexical::descent::TapeVisitor::visit_func_resume(const std::string& name) {
+    record(EV_FUNC_RESUME, false, atom(name));
+}
+
+void lexical::descent::TapeVisitor::visit_func_resume_end(const std::string& name) {
+    record(EV_FUNC_RESUME_END, false, atom(name));
+}
+
+Node* lexical::descent::TapeVisitor::visit_funccall(const std::string& name, Node* exprlist) {
+    return record(EV_FUNCCALL, true, atom(name), handle(exprlist));
+}
+
+void lexical::descent::TapeVisitor::visit_statement_list(Node* stmt, ListTree& stmtlist) const {
+    record_list(EV_STATEMENT_LIST, stmt, stmtlist);
+}
+
+Node* lexical::descent::TapeVisitor::visit_assignment(Node* var, Node* expr) {
+    return record(EV_ASSIGNMENT, true, handle(var), handle(expr));
+}
+
+Node* lexical::descent::TapeVisitor::visit_lvariable(const std::string& name) {
+    return record(EV_LVARIABLE, true, atom(name));
+}
+
+Node* lexical::descent::TapeVisitor::visit_lvariable(size_t id) {
+    const auto wide = static_cast<uint64_t>(id);
+    return record(EV_LVARIABLE_ID, true, static_cast<uint32_t>(wide), static_cast<uint32_t>(wide >> 32));
+}
+
+Node* lexical::descent::TapeVisitor::visit_lvariable(const std::string& name, Node* index) {
+    return record(EV_LVARIABLE_INDEX, true, atom(name), handle(index));
+}
+
+Node* lexical::descent::TapeVisitor::visit_rvariable(const std::string& name) {
+    return record(EV_RVARIABLE, true, atom(name));
+}
+
+Node* lexical::descent::TapeVisitor::visit_rvariable(const std::string& name, Node* index) {
+    return record(EV_RVARIABLE_INDEX, true, atom(name), handle(index));
+}
+
+void lexical::descent::TapeVisitor::register_declarations(ReturnType rt) {
+    record(EV_REGISTER_DECLARATIONS, false, rt);
+}
+
+void lexical::descent::TapeVisitor::visit_var_decl(const std::string& name) {
+    record(EV_VAR_DECL, false, atom(name));
+}
+
+void lexical::descent::TapeVisitor::visit_array_decl(const std::string& name, const std::string& size_string) {
+    record(EV_ARRAY_DECL, false, atom(name), text(size_string), static_cast<uint32_t>(size_string.size()));
+}
+
+// The returned identifiers are only known when replaying. The parsers never use them.
+size_t lexical::descent::TapeVisitor::visit_decl(const std::string& name, SymbolType st, ReturnType rt) {
+    record(EV_DECL, false, atom(name), st, rt);
+    return std::numeric_limits<size_t>::max();
+}
+
+size_t lexical::descent::TapeVisitor::visit_array_decl(const std::string& name, SymbolType st, ReturnType rt, const std::string& size_string) {
+    record(EV_ARRAY_DECL_TYPED, false, atom(name), st | rt << 16, text(size_string), static_cast<uint32_t>(size_string.size()));
+    return std::numeric_limits<size_t>::max();
+}
+
+Node* lexical::descent::TapeVisitor::visit_number(const std::string& number) {
+    return record(EV_NUMBER, true, text(number), static_cast<uint32_t>(number.size()));
+}
+
+Node* lexical::descent::TapeVisitor::visit_if(Node* boolexpr, Node* stmt, Node* opt_else_stmt) {
+    return record(EV_IF, true, handle(boolexpr), handle(stmt), handle(opt_else_stmt));
+}
+
+Node* lexical::descent::TapeVisitor::visit_while(Node* boolexpr, Node* stmt) {
+    return record(EV_WHILE, true, handle(boolexpr), handle(stmt));
+}
+
+Node* lexical::descent::TapeVisitor::visit_return(Node* expr) {
+    return record(EV_RETURN, true, handle(expr));
+}
+
+void lexical::descent::TapeVisitor::visit_exprlist(Node* expr, ListTree& exprlist) const {
+    record_list(EV_EXPRLIST, expr, exprlist);
+}
+
+Node* lexical::descent::TapeVisitor::visit_operator(NodeType op, Node* lhs, Node* rhs) {
+    return record(EV_BINARY_OPERATOR, true, op, handle(lhs), handle(rhs));
+}
+
+Node* lexical::descent::TapeVisitor::visit_operator(NodeType op, Node* arg) {
+    return record(EV_UNARY_OPERATOR, true, op, handle(arg));
+}
+
+Node* lexical::descent::TapeVisitor::empty() const {
+    return record(EV_EMPTY, true);
+}
+
+void lexical::descent::TapeVisitor::add_local_scope() {
+    record(EV_ADD_LOCAL_SCOPE, false);
+}
+
+void lexical::descent::TapeVisitor::leave_current_scope() {
+    record(EV_LEAVE_CURRENT_SCOPE, false);
+}
+
+void lexical::descent::TapeVisitor::syntax_error(const std::string& message) {
+    tape.messages.push_back(message);
+    record(EV_SYNTAX_ERROR, false, static_cast<uint32_t>(tape.messages.size() - 1));
+}
+
+void lexical::descent::replay(const Tape& tape, BaseVisitor& vis, ParseContext& ctx) {
+    // Nodes and lists built by `vis`, by handle.
+    std::vector<Node*> nodes(tape.handles + 1, nullptr);
+    std::vector<ListTree> lists(tape.handles + 1);
+    for (const Event& event : tape.events) {
+        ctx.lineno = event.line;
+        const uint32_t* args = event.args;
+        Node* result = nullptr;
+        switch (event.type) {
+            case EV_ADD_BUILTINS: vis.add_builtins(); break;
+            case EV_PROGRAM_START: vis.program_start(); break;
+            case EV_PROGRAM: vis.visit_program(); break;
+            case EV_FUNC_START: vis.visit_func_start(static_cast<ReturnType>(args[0]), str(args[1])); break;
+            case EV_FUNC_END: vis.visit_func_end(str(args[0]), nodes[args[1]]); break;
+            case EV_FUNC_DEFERRED: vis.visit_func_deferred(str(args[0]), tape.spans[args[1]]); break;
+            case EV_FUNC_RESUME: vis.visit_func_resume(str(args[0])); break;
+            case EV_FUNC_RESUME_END: vis.visit_func_resume_end(str(args[0])); break;
+            case EV_FUNCCALL: result = vis.visit_funccall(str(args[0]), nodes[args[1]]); break;
+            case EV_STATEMENT_LIST:
+                vis.visit_statement_list(nodes[args[0]], lists[args[1]]);
+                nodes[args[1]] = lists[args[1]].root;
+                break;
+            case EV_ASSIGNMENT: result = vis.visit_assignment(nodes[args[0]], nodes[args[1]]); break;
+            case EV_LVARIABLE: result = vis.visit_lvariable(str(args[0])); break;
+            case EV_LVARIABLE_ID: result = vis.visit_lvariable(static_cast<size_t>(args[0] | static_cast<uint64_t>(args[1]) << 32)); break;
+            case EV_LVARIABLE_INDEX: result = vis.visit_lvariable(str(args[0]), nodes[args[1]]); break;
+            case EV_RVARIABLE: result = vis.visit_rvariable(str(args[0])); break;
+            case EV_RVARIABLE_INDEX: result = vis.visit_rvariable(str(args[0]), nodes[args[1]]); break;
+            case EV_REGISTER_DECLARATIONS: vis.register_declarations(static_cast<ReturnType>(args[0])); break;
+            case EV_VAR_DECL: vis.visit_var_decl(str(args[0])); break;
+            case EV_ARRAY_DECL: vis.visit_array_decl(str(args[0]), tape.text.substr(args[1], args[2])); break;
+            case EV_DECL: vis.visit_decl(str(args[0]), static_cast<SymbolType>(args[1]), static_cast<ReturnType>(args[2])); break;
+            case EV_ARRAY_DECL_TYPED:
+                vis.visit_array_decl(str(args[0]), static_cast<SymbolType>(args[1] & 0xffff), static_cast<ReturnType>(args[1] >> 16),
+                                     tape.text.substr(args[2], args[3]));
+                break;
+            case EV_NUMBER: result = vis.visit_number(tape.text.substr(args[0], args[1])); break;
+            case EV_IF: result = vis.visit_if(nodes[args[0]], nodes[args[1]], nodes[args[2]]); break;
+            case EV_WHILE: result = vis.visit_while(nodes[args[0]], nodes[args[1]]); break;
+            case EV_RETURN: result = vis.visit_return(nodes[args[0]]); break;
+            case EV_EXPRLIST:
+                vis.visit_exprlist(nodes[args[0]], lists[args[1]]);
+                nodes[args[1]] = lists[args[1]].root;
+                break;
+            case EV_BINARY_OPERATOR: result = vis.visit_operator(static_cast<NodeType>(args[0]), nodes[args[1]], nodes[args[2]]); break;
+            case EV_UNARY_OPERATOR: result = vis.visit_operator(static_cast<NodeType>(args[0]), nodes[args[1]]); break;
+            case EV_EMPTY: result = vis.empty(); break;
+            case EV_ADD_LOCAL_SCOPE: vis.add_local_scope(); break;
+            case EV_LEAVE_CURRENT_SCOPE: vis.leave_current_scope(); break;
+            case EV_SYNTAX_ERROR: vis.syntax_error(tape.messages[args[0]]); break;
+        }
+        if (event.result)
+            nodes[event.result] = result;
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef COCO_FRAMEWORK_LEXICAL_DESCENT_TAPE
+#define COCO_FRAMEWORK_LEXICAL_DESCENT_TAPE
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <interner.h>
+
+#include "basevisitor.h"
+#include "parsecontext.h"
+
+namespace lexical {
+    namespace descent {
+        // One BaseVisitor function per event type.
+        enum EventType : uint8_t {
+            EV_ADD_BUILTINS,
+            EV_PROGRAM_START,
+            EV_PROGRAM,
+            EV_FUNC_START,          // rt, name
+            EV_FUNC_END,            // name, root
+            EV_FUNC_DEFERRED,       // name, span index
+            EV_FUNC_RESUME,         // name
+            EV_FUNC_RESUME_END,     // name
+            EV_FUNCCALL,            // name, exprlist
+            EV_STATEMENT_LIST,      // stmt, list
+            EV_ASSIGNMENT,          // var, expr
+            EV_LVARIABLE,           // name
+            EV_LVARIABLE_ID,        // id (low, high)
+            EV_LVARIABLE_INDEX,     // name, index
+            EV_RVARIABLE,           // name
+            EV_RVARIABLE_INDEX,     // name, index
+            EV_REGISTER_DECLARATIONS, // rt
+            EV_VAR_DECL,            // name
+            EV_ARRAY_DECL,          // name, size (offset, length)
+            EV_DECL,                // name, st, rt
+            EV_ARRAY_DECL_TYPED,    // name, st | rt << 16, size (offset, length)
+            EV_NUMBER,              // number (offset, length)
+            EV_IF,                  // boolexpr, stmt, opt_else_stmt
+            EV_WHILE,               // boolexpr, stmt
+            EV_RETURN,              // expr
+            EV_EXPRLIST,            // expr, list
+            EV_BINARY_OPERATOR,     // op, lhs, rhs
+            EV_UNARY_OPERATOR,      // op, arg
+            EV_EMPTY,
+            EV_ADD_LOCAL_SCOPE,
+            EV_LEAVE_CURRENT_SCOPE,
+            EV_SYNTAX_ERROR,        // message index
+        };
+
+        /**
+         * A recorded visitor call. Names are atoms, nodes are handles: the n-th node a tape hands out has handle n,
+         * and handle 0 is `nullptr`. List handles name the ListTree the parser passed, and later the list node itself.
+         * Numbers are not interned, but kept in the text of the tape.
+         */
+        struct Event {
+            EventType type;
+            int line;         // `lineno()` at the time of the call
+            uint32_t result;  // Handle of the returned node, if any
+            uint32_t args[4];
+        };
+
+        inline bool operator==(const Event& a, const Event& b) {
+            return a.type == b.type && a.line == b.line && a.result == b.result && std::equal(a.args, a.args + 4, b.args);
+        }
+
+        inline bool operator!=(const Event& a, const Event& b) {
+            return !(a == b);
+        }
+
+        inline std::ostream& operator<<(std::ostream& stream, const Event& event) {
+            return stream << "event " << static_cast<int>(event.type) << " at line " << event.line << " -> " << event.result
+                          << " (" << event.args[0] << ", " << event.args[1] << ", " << event.args[2] << ", " << event.args[3] << ')';
+        }
+
+        // The visitor calls of one parse, in order.
+        struct Tape {
+            std::vector<Event> events;
+            std::vector<SourceSpan> spans;
+            std::vector<std::string> messages;
+            std::string text; // Numbers
+            uint32_t handles = 0;
+        };
+
+        /**
+         * Visitor that records every call on a tape instead of building anything, so the calls can be replayed
+         * onto a real visitor later, e.g. on another thread. Returns node handles in place of nodes.
+         */
+        class TapeVisitor : public BaseVisitor {
+            public:
+            TapeVisitor(Logger& logger, Tape& tape) : BaseVisitor(logger), tape(tape) {}
+
+            void add_builtins() override;
+            void program_start() override;
+            void visit_program() override;
+            void visit_func_start(ReturnType rt, const std::string& name) override;
+            void visit_func_end(const std::string& name, Node* root) override;
+            void visit_func_deferred(const std::string& name, const SourceSpan& body) override;
+            void visit_func_resume(const std::string& name) override;
+            void visit_func_resume_end(const std::string& name) override;
+            Node* visit_funccall(const std::string& name, Node* exprlist) override;
+            void visit_statement_list(Node* stmt, ListTree& stmtlist) const override;
+            Node* visit_assignment(Node* var, Node* expr) override;
+            Node* visit_lvariable(const std::string& name) override;
+            Node* visit_lvariable(size_t id) override;
+            Node* visit_lvariable(const std::string& name, Node* index) override;
+            Node* visit_rvariable(const std::string& name) override;
+            Node* visit_rvariable(const std::string& name, Node* index) override;
+            void register_declarations(ReturnType rt) override;
+            void visit_var_decl(const std::string& name) override;
+            void visit_array_decl(const std::string& name, const std::string& size_string) override;
+            size_t visit_decl(const std::string& name, SymbolType st, ReturnType rt) override;
+            size_t visit_array_decl(const std::string& name, SymbolType st, ReturnType rt, const std::string& size_string) override;
+            Node* visit_number(const std::string& number) override;
+            Node* visit_if(Node* boolexpr, Node* stmt, Node* opt_else_stmt) override;
+            Node* visit_while(Node* boolexpr, Node* stmt) override;
+            Node* visit_return(Node* expr) override;
+            void visit_exprlist(Node* expr, ListTree& exprlist) const override;
+            Node* visit_operator(NodeType op, Node* lhs, Node* rhs) override;
+            Node* visit_operator(NodeType op, Node* arg) override;
+            Node* empty() const override;
+            void add_local_scope() override;
+            void leave_current_scope() override;
+            void syntax_error(const std::string& message) override;
+
+            private:
+            // Appends an event. Returns the handle of a new node if `returns_node`, `nullptr` otherwise.
+            Node* record(EventType type, bool returns_node, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0) const;
+            // Appends `str` to the text of the tape, and returns its offset there.
+            uint32_t text(const std::string& str) const;
+            // Adds the event for appending `node` to `list`, handing out a handle for the list on its first element.
+            void record_list(EventType type, Node* node, ListTree& list) const;
+
+            Tape& tape;
+        };
+
+        /**
+         * Replays `tape` onto `vis`, in order. Sets `ctx.lineno` to the recorded line before every call,
+         * so `vis` must have `ctx` as its context.
+         */
+        void replay(const Tape& tape, BaseVisitor& vis, ParseContext& ctx);
+    }
+}
+
+#endif
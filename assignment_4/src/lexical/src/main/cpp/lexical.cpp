@@ -1,32 +1,215 @@
 #include "lexical.h"
 #include "basevisitor.h"
+#include "parsecontext.h"
+#include "descent/parallel.h"
+#include "descent/parser.h"
 
-int yyparse(BaseVisitor&);
-int yyset_lineno(int);
-int yylex_destroy();
-extern FILE* yyin;
+#include <algorithm>
+#include <vector>
 
-extern int lineno;
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-int lexical::generate(FILE* file, BaseVisitor& vis) {
-    // Explicitly sets lineno to 1 (first line in lex). Subsequent calls start counting lines from 1 this way.
-    yyset_lineno(1);
-    lineno = 1;
-    if (file)
-        yyin = file;
-
-    int parsed = yyparse(vis);
-    yylex_destroy();
+typedef void* yyscan_t;
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+
+int yyparse(yyscan_t, ParseContext&, BaseVisitor&);
+int yylex_init_extra(ParseContext*, yyscan_t*);
+void yyset_in(FILE*, yyscan_t);
+YY_BUFFER_STATE yy_scan_buffer(char*, size_t, yyscan_t);
+void yy_delete_buffer(YY_BUFFER_STATE, yyscan_t);
+int yylex_destroy(yyscan_t);
+
+yypstate* yypstate_new();
+void yypstate_delete(yypstate*);
+bool yypush_scanned(yypstate*, yyscan_t, ParseContext&, BaseVisitor&, int& status);
+
+/** Runs the parser on an initialized `scanner`, with `ctx` as its context. Destroys the scanner afterwards. */
+static int parse(yyscan_t scanner, ParseContext& ctx, BaseVisitor& vis) {
+    const ParseContext* previous = vis.context;
+    vis.context = &ctx;
+    int parsed = yyparse(scanner, ctx, vis);
+    vis.context = previous;
+
+    yylex_destroy(scanner);
     return parsed;
 }
 
-int lexical::generate(const std::string& filename, BaseVisitor& vis) {
+/** Runs the recursive-descent parser on [begin, end), with a fresh context. */
+static int parse_descent(const char* begin, const char* end, BaseVisitor& vis, lexical::Frontend frontend) {
+    ParseContext ctx;
+    const ParseContext* previous = vis.context;
+    vis.context = &ctx;
+    int parsed = frontend == lexical::FRONTEND_DESCENT_PARALLEL
+        ? lexical::descent::parse_parallel(begin, end, vis, ctx)
+        : lexical::descent::Parser(begin, end, ctx, vis, frontend == lexical::FRONTEND_DESCENT_LAZY).parse();
+    vis.context = previous;
+    return parsed;
+}
+
+/**
+ * Runs the bison parser on `base`, scanning it in place. Flex needs the source to end in 2 NUL bytes,
+ * so `size` counts those as well.
+ */
+static int parse_in_place(char* base, size_t size, BaseVisitor& vis) {
+    ParseContext ctx;
+    yyscan_t scanner;
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Could not initialize scanner" << std::endl;
+        return -1;
+    }
+    ctx.source = base;
+    yy_scan_buffer(base, size, scanner);
+    return parse(scanner, ctx, vis);
+}
+
+/** Parses `filename` through stdio. */
+static int generate_buffered(const std::string& filename, BaseVisitor& vis, lexical::Frontend frontend) {
     FILE* file = std::fopen(filename.c_str(), "r");
     if (!file) {
         std::cerr << "Could not open " << filename << std::endl;
         return -1;
     }
-    int parsed = generate(file, vis);
+    int parsed = lexical::generate(file, vis, frontend);
     fclose(file);
     return parsed;
-}
\ No newline at end of file
+}
+
+int lexical::generate(FILE* file, BaseVisitor& vis, Frontend frontend) {
+    if (frontend != FRONTEND_BISON) {
+        std::string source;
+        char buffer[BUFSIZ];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file ? file : stdin)) > 0)
+            source.append(buffer, read);
+        return parse_descent(source.data(), source.data() + source.size(), vis, frontend);
+    }
+
+    // Every parse gets its own scanner and context. Line numbers start counting from 1 this way.
+    ParseContext ctx;
+    yyscan_t scanner;
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Could not initialize scanner" << std::endl;
+        return -1;
+    }
+    yyset_in(file ? file : stdin, scanner);
+    return parse(scanner, ctx, vis);
+}
+
+int lexical::generate(FILE* file, BaseVisitor& vis) {
+    return generate(file, vis, FRONTEND_BISON);
+}
+
+int lexical::generate(const std::string& filename, BaseVisitor& vis, Frontend frontend) {
+#ifdef _WIN32
+    return generate_buffered(filename, vis, frontend);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Could not open " << filename << std::endl;
+        return -1;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { // Pipes, devices etc. cannot be mapped.
+        close(fd);
+        return generate_buffered(filename, vis, frontend);
+    }
+
+    // Flex scans a buffer in place only if it ends in 2 NUL bytes, and temporarily writes into it while scanning.
+    // So, we reserve zeroed memory for the source plus 2 bytes, and map the file privately (copy-on-write) over its front.
+    // The remainder of the last page of the file mapping is zero-filled as well.
+    const auto size = static_cast<size_t>(st.st_size);
+    const size_t mapped_size = size + 2;
+    void* reserved = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        close(fd);
+        return generate_buffered(filename, vis, frontend);
+    }
+    auto* base = static_cast<char*>(reserved);
+    if (size > 0 && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, mapped_size);
+        close(fd);
+        return generate_buffered(filename, vis, frontend);
+    }
+    close(fd);
+    madvise(base, mapped_size, MADV_SEQUENTIAL);
+
+    if (frontend != FRONTEND_BISON) {
+        int parsed = parse_descent(base, base + size, vis, frontend);
+        munmap(base, mapped_size);
+        return parsed;
+    }
+
+    int parsed = parse_in_place(base, mapped_size, vis);
+    munmap(base, mapped_size);
+    return parsed;
+#endif
+}
+
+int lexical::generate(const std::string& filename, BaseVisitor& vis) {
+    return generate(filename, vis, FRONTEND_BISON);
+}
+
+int lexical::generate(const char* source, size_t size, BaseVisitor& vis, Frontend frontend) {
+    if (frontend != FRONTEND_BISON)
+        return parse_descent(source, source + size, vis, frontend);
+
+    // Flex writes into the buffer while scanning, so it gets a copy with the 2 NUL bytes it needs.
+    std::vector<char> buffer(size + 2, '\0');
+    std::copy(source, source + size, buffer.begin());
+    return parse_in_place(buffer.data(), buffer.size(), vis);
+}
+
+lexical::PushParser::PushParser(BaseVisitor& visitor) : vis(visitor) {
+    if (yylex_init_extra(&ctx, &scanner) != 0) {
+        std::cerr << "Could not initialize scanner" << std::endl;
+        scanner = nullptr;
+        done = true;
+        result = -1;
+        return;
+    }
+    parser = yypstate_new();
+}
+
+lexical::PushParser::~PushParser() {
+    if (parser)
+        yypstate_delete(parser);
+    if (scanner)
+        yylex_destroy(scanner);
+}
+
+int lexical::PushParser::feed(const char* chunk, size_t size) {
+    if (done)
+        return result;
+    pending.append(chunk, size);
+    // Whitespace ends any token. Other characters that cannot be in a token are scanned one at a time.
+    const size_t split = pending.find_last_of(" \t\n");
+    if (split != std::string::npos)
+        scan(split + 1, true);
+    return done ? result : 0;
+}
+
+int lexical::PushParser::finish() {
+    if (!done)
+        scan(pending.size(), false);
+    return result;
+}
+
+void lexical::PushParser::scan(size_t size, bool more_input) {
+    buffer.assign(pending.begin(), pending.begin() + size);
+    buffer.push_back('\0');
+    buffer.push_back('\0');
+    pending.erase(0, size);
+
+    ctx.more_input = more_input;
+    const ParseContext* previous = vis.context;
+    vis.context = &ctx;
+    YY_BUFFER_STATE state = yy_scan_buffer(buffer.data(), buffer.size(), scanner);
+    done = yypush_scanned(parser, scanner, ctx, vis, result);
+    yy_delete_buffer(state, scanner);
+    vis.context = previous;
+}
@@ -1,5 +1,18 @@
 #include "basevisitor.h"
 
+void BaseVisitor::syntax_error(const std::string& message) {
+    logger.error(lineno()) << message << '\n';
+}
+
 Node* BaseVisitor::do_nothing(Node* node) {
     return node;
 }
+
+void BaseVisitor::visit_func_deferred(const std::string&, const SourceSpan&) {
+}
+
+void BaseVisitor::visit_func_resume(const std::string&) {
+}
+
+void BaseVisitor::visit_func_resume_end(const std::string&) {
+}
@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <interner.h>
 #include <listtree.h>
 #include <decllist.h>
 #include <node.h>
@@ -21,27 +22,16 @@
 #include "basevisitor.h"
 #include "../cpp/debug/debug.h"
 
-/* Import from comp.l*/
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-int yylex();   /* Lexer function*/
-int yywrap(void);
-#ifdef __cplusplus
-}
-#endif
-
-extern int lineno;        /* Current line number*/
-
 #ifdef DEBUG
 int msglevel = 0; /* higher = more debugging messages*/
 #else
 int msglevel = 0;   /* don't bother sensitive souls*/
 #endif
 
-static void yyerror(BaseVisitor&, const char*);
-static std::string cvt_str(char* s);
+static const std::string& atom_str(Atom atom);
+
+/* The parser stack lives on the heap and grows as needed: allow deep nesting, like a long run of parentheses */
+#define YYMAXDEPTH 10000000
 
 %}
 
@@ -50,6 +40,23 @@ static std::string cvt_str(char* s);
     struct ListTree;
 }
 
+%code requires {
+#include <interner.h>
+#include "parsecontext.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+}
+
+/* Import from comp.l*/
+%code {
+int yylex(YYSTYPE* yylval_param, yyscan_t yyscanner);   /* Lexer function*/
+
+static void yyerror(yyscan_t, ParseContext&, BaseVisitor&, const char*);
+}
+
 /* Start symbol*/
 %start program
 
@@ -64,6 +71,8 @@ static std::string cvt_str(char* s);
 %token ENDFILE 0
 /* unary symbols */
 %token UMINUS NOT
+/* the scanner ran out of input, but more may come (see ParseContext::more_input); never reaches the parser */
+%token MORE_INPUT
 
 /* TODO: uncomment once required */
 /* Precedence directive to resolve
@@ -75,15 +84,20 @@ static std::string cvt_str(char* s);
 
 /* Types to pass between lexer, rules and actions*/
 %union {
-    char* idStr;
-    char* numStr;
+    Atom idStr;
+    LexemeView numStr;
     Node* node;
     ListTree* listTree;
     ReturnType rt;
     NodeType nt;
 }
 
-%parse-param {BaseVisitor& vis}
+/* Reentrant parser: all state lives in the scanner and ParseContext, none in globals */
+%define api.pure full
+/* Besides yyparse, which pulls tokens from the scanner, tokens can be pushed to the parser as they are scanned */
+%define api.push-pull both
+%lex-param {yyscan_t scanner}
+%parse-param {yyscan_t scanner} {ParseContext& ctx} {BaseVisitor& vis}
 
 %%
 
@@ -111,14 +125,14 @@ var_identifier_list : var_identifier_list COMMA var_identifier
         		    | var_identifier
         		    ;
 var_identifier      : identifier
- 			        { vis.visit_var_decl(cvt_str($<idStr>1)); }
+ 			        { vis.visit_var_decl(atom_str($<idStr>1)); }
 type_specifier      : VOID
                         { $<rt>$ = RT_VOID; }
                     ;
 fun_declaration     : type_specifier identifier LPAREN
-                        { vis.visit_func_start($<rt>1, cvt_str(strdup($<idStr>2))); }
+                        { vis.visit_func_start($<rt>1, atom_str($<idStr>2)); }
                         params RPAREN compound_stmt
-                        { vis.visit_func_end(cvt_str($<idStr>2), $<node>7); }
+                        { vis.visit_func_end(atom_str($<idStr>2), $<node>7); }
                     ;
 params              : VOID;
 var_decl_list       : var_decl_list var_declaration | %empty;
@@ -181,7 +195,7 @@ expression          : var ASSIGN expression
                     	{ $<node>$ = $<node>1; }
                     ;
 var                 : identifier
-                        { $<node>$ = vis.visit_lvariable(cvt_str($<idStr>1)); }
+                        { $<node>$ = vis.visit_lvariable(atom_str($<idStr>1)); }
                     ;
 bool_expression     : bool_expression boolop simple_expression
         			{ $<node>$ = vis.visit_operator($<nt>2, $<node>1, $<node>3); }
@@ -221,11 +235,11 @@ mulop               : TIMES
 factor              : LPAREN expression RPAREN
 			         { $<node>$ = $<node>2; }
                     | identifier
-                    	{ $<node>$ = vis.visit_rvariable(cvt_str($<idStr>1)); }
+                    	{ $<node>$ = vis.visit_rvariable(atom_str($<idStr>1)); }
                     | identifier LPAREN args RPAREN
-                    	{ $<node>$ = vis.visit_funccall(cvt_str($<idStr>1), $<node>3); }
+                    	{ $<node>$ = vis.visit_funccall(atom_str($<idStr>1), $<node>3); }
                     | number
-                    	{ $<node>$ = vis.visit_number(cvt_str($<numStr>1)); }
+                    	{ $<node>$ = vis.visit_number(ctx.str($<numStr>1)); }
                     | unary factor
                     	{ $<node>$ = vis.visit_operator($<nt>1, $<node>2); }
                     ;
@@ -251,16 +265,26 @@ unary		         : PLUS
 		              ;
 %%
 
-static void yyerror(BaseVisitor& vis, const char* s) {
-    (&vis)->logger.error(lineno) << s << '\n';
+/*
+ * Pushes the tokens scanned from the current buffer of `scanner` to `parser`, until the parse finishes
+ * (returns true, with the `yyparse` exit code in `status`) or the scanner runs out of input (returns false).
+ */
+bool yypush_scanned(yypstate* parser, yyscan_t scanner, ParseContext& ctx, BaseVisitor& vis, int& status) {
+    for (;;) {
+        YYSTYPE value;
+        int token = yylex(&value, scanner);
+        if (token == MORE_INPUT)
+            return false;
+        status = yypush_parse(parser, token, &value, scanner, ctx, vis);
+        if (status != YYPUSH_MORE)
+            return true;
+    }
 }
 
-static std::string cvt_str(char* s) {
-    std::string str(s);
-    free(s);
-    return str;
+static void yyerror(yyscan_t, ParseContext&, BaseVisitor& vis, const char* s) {
+    vis.syntax_error(s);
 }
 
-int yywrap() {
-    return 1;
+static const std::string& atom_str(Atom atom) {
+    return Interner::current().str(atom);
 }
@@ -8,6 +8,8 @@
 #include <node.h>
 #include <types.h>
 
+#include "parsecontext.h"
+
 class BaseVisitor {
     public:
     explicit BaseVisitor(Logger& logger) : logger(logger){};
@@ -44,6 +46,29 @@ class BaseVisitor {
      */
     virtual void visit_func_end(const std::string& name, Node* root) = 0;
 
+    /**
+     * Visitor function for a function whose body is skipped, instead of parsing the body and calling `visit_func_end`.
+     * Only called by the lazy front end. The function must be left, as if it had ended. Does nothing by default.
+     * @param name Name of the function
+     * @param body Source span of the body, braces included
+     */
+    virtual void visit_func_deferred(const std::string& name, const SourceSpan& body);
+
+    /**
+     * Visitor function to re-enter a deferred function, right before its body is parsed after all.
+     * Only called by the lazy front end. The body ends with `visit_func_end` as usual, followed by `visit_func_resume_end`.
+     * Does nothing by default.
+     * @param name Name of the function
+     */
+    virtual void visit_func_resume(const std::string& name);
+
+    /**
+     * Visitor function to leave a resumed function, right after its `visit_func_end`. Undoes what `visit_func_resume` set up.
+     * Only called by the lazy front end. Does nothing by default.
+     * @param name Name of the function
+     */
+    virtual void visit_func_resume_end(const std::string& name);
+
     /**
      * Visitor function for function calls
      * @param name Name of the function
@@ -55,8 +80,7 @@ class BaseVisitor {
     /**
      * Visitor function for statement lists
      * @param stmt Node* to current statement
-     * @param stmtlist Node* to the rest of the statements
-     * @return created NODE_STATEMENT_LIST node
+     * @param stmtlist the NODE_STATEMENT_LIST built so far; `stmt` is appended to it
      */
     virtual void visit_statement_list(Node* stmt, ListTree& stmtlist) const = 0;
     /**
@@ -176,7 +200,7 @@ class BaseVisitor {
     /**
      * Visitor function to handle expression lists
      * @param expr Node* to the current expression
-     * @param exprlist contains the root of the expression list, and the current position
+     * @param exprlist the NODE_EXPRLIST built so far; `expr` is appended to it
      */
     virtual void visit_exprlist(Node* expr, ListTree& exprlist) const = 0;
 
@@ -214,6 +238,12 @@ class BaseVisitor {
      */
     virtual void leave_current_scope() = 0;
 
+    /**
+     * Reports a syntax error of the parser at the current line. Logs it as an error by default.
+     * @param message Message of the parser, e.g. "syntax error, unexpected SEMI, expecting ID"
+     */
+    virtual void syntax_error(const std::string& message);
+
     /**
      * Use as a debugger function i.c.w. e.g. gdb
      * @param node Node* to debug
@@ -221,8 +251,18 @@ class BaseVisitor {
      */
     virtual Node* do_nothing(Node* node);
 
+    /**
+     * @return the line the parser is currently at, or -1 when no parse is running.
+     */
+    int lineno() const {
+        return context ? context->lineno : -1;
+    }
+
     //A reference to the logger. Required to print errors, warnings and info as needed
     Logger& logger;
+
+    //State of the parse this visitor is used in. Set by `lexical::generate` for the duration of a parse.
+    const ParseContext* context = nullptr;
 };
 
 #endif
@@ -1,12 +1,99 @@
 #ifndef COCO_FRAMEWORK_LEXICAL_ENTRYPOINT
 #define COCO_FRAMEWORK_LEXICAL_ENTRYPOINT
 
+#include <string>
+#include <vector>
+
 #include "basevisitor.h"
+#include "parsecontext.h"
+
+struct yypstate;
 
 namespace lexical {
+    /** Parser implementation to run. Both accept the same grammar and call the visitor in the same order. */
+    enum Frontend {
+        FRONTEND_BISON,   // Flex scanner and bison LALR parser, generated from compiler.l and compiler.y.
+        FRONTEND_DESCENT, // Hand-written scanner and recursive-descent parser.
+        // Recursive-descent parser that skips function bodies, and parses only those reachable from `main`.
+        // Visits deferred functions with `visit_func_deferred` and, once reachable, `visit_func_resume`.
+        // A resumed body sees the declarations before the function only, as in an eager parse.
+        // Bodies are parsed after all declarations, so syntax errors in unreachable bodies go unreported.
+        FRONTEND_DESCENT_LAZY,
+        // Recursive-descent parser that parses top-level declarations on one thread per core.
+        // The visitor is still called on the calling thread, in source order.
+        FRONTEND_DESCENT_PARALLEL,
+    };
+
+    /**
+     * Parses `file` (stdin if `nullptr`), calling `visitor` for every rule.
+     * Scanner and parser are reentrant: concurrent calls are fine, as long as each uses its own visitor.
+     * The descent front end reads the whole stream into memory first.
+     * @return `yyparse` exit code, or -1 if the scanner could not be set up.
+     */
+    int generate(FILE* file, BaseVisitor& visitor, Frontend frontend);
+
+    // Exactly like above `generate` function, with the bison front end.
     int generate(FILE* file, BaseVisitor& visitor);
 
+    /**
+     * Parses the file at `filename`. Regular files are memory-mapped and scanned in place, without copying
+     * the source or its lexemes. Other files (e.g. pipes) are read through stdio.
+     * @return `yyparse` exit code, or -1 if the file could not be opened.
+     */
+    int generate(const std::string& filename, BaseVisitor& vis, Frontend frontend);
+
+    // Exactly like above `generate` function, with the bison front end.
     int generate(const std::string& filename, BaseVisitor& vis);
+
+    /**
+     * Parses the in-memory source [source, source + size), which need not be NUL-terminated.
+     * The descent front ends scan it in place; the bison front end scans a copy, as flex writes into its buffer.
+     * @return `yyparse` exit code, or -1 if the scanner could not be set up.
+     */
+    int generate(const char* source, size_t size, BaseVisitor& vis, Frontend frontend = FRONTEND_BISON);
+
+    /**
+     * Parses source that arrives in chunks, e.g. from a pipe or socket, with the bison parser in push mode.
+     * Every chunk is scanned and parsed as far as its last whitespace when it is fed, so reading the rest of the source
+     * overlaps with parsing. No token spans whitespace (comments continue in the next chunk), so the rest is kept until
+     * the next chunk completes it. Calls the visitor like `generate` does.
+     */
+    class PushParser {
+        public:
+        explicit PushParser(BaseVisitor& visitor);
+        ~PushParser();
+
+        PushParser(const PushParser&) = delete;
+        PushParser& operator=(const PushParser&) = delete;
+
+        /**
+         * Scans and parses the next `size` bytes of source.
+         * @return 0 while the source may go on, or else the `yyparse` exit code: the parse stopped at a syntax error,
+         * and further chunks are ignored. -1 if the scanner could not be set up.
+         */
+        int feed(const char* chunk, size_t size);
+
+        /**
+         * Ends the source, and parses what remains of it.
+         * @return `yyparse` exit code, or -1 if the scanner could not be set up.
+         */
+        int finish();
+
+        private:
+        // Scans and parses the first `size` bytes of `pending`, and drops them.
+        void scan(size_t size, bool more_input);
+
+        BaseVisitor& vis;
+        ParseContext ctx;
+        void* scanner = nullptr;
+        yypstate* parser = nullptr;
+        // Source fed, but not scanned yet
+        std::string pending;
+        // Buffer of the scanner, with the 2 NUL bytes flex needs
+        std::vector<char> buffer;
+        bool done = false;
+        int result = 0;
+    };
 }
 
 #endif
@@ -0,0 +1,61 @@
+#ifndef COCO_FRAMEWORK_LEXICAL_PARSECONTEXT
+#define COCO_FRAMEWORK_LEXICAL_PARSECONTEXT
+
+#include <cstddef>
+#include <string>
+
+/**
+ * A token lexeme, as a view into the text held by the ParseContext it was scanned with.
+ * Kept trivial, so it can be passed around in the bison value union.
+ */
+struct LexemeView {
+    size_t offset;
+    size_t length;
+};
+
+/**
+ * All state of a single scanner/parser run.
+ * The lexer and parser are reentrant: every call to `lexical::generate` creates its own context,
+ * so multiple files can be parsed at the same time (e.g. on different threads) within one process.
+ */
+struct ParseContext {
+    // Current line number in the input, starting at 1.
+    int lineno = 1;
+    // Whether the input goes on after the current scanner buffer, when it is pushed in chunks (see lexical::PushParser).
+    bool more_input = false;
+
+    // Start of the source text when it is scanned in place (e.g. a memory-mapped file), otherwise nullptr.
+    const char* source = nullptr;
+
+    // Lexeme storage when the scanner reuses its buffers (reading a FILE*, or chunks pushed to it).
+    std::string lexemes;
+
+    /**
+     * Creates a lexeme for the `length` characters at `text`. Numbers are kept as lexemes rather than interned,
+     * as most literals occur only once.
+     * When scanning in place, this only records the position of `text` in the source. Otherwise, the text is copied.
+     */
+    LexemeView make_lexeme(const char* text, size_t length) {
+        if (source)
+            return {static_cast<size_t>(text - source), length};
+        LexemeView lexeme{lexemes.size(), length};
+        lexemes.append(text, length);
+        return lexeme;
+    }
+
+    /**
+     * @return the text of `lexeme`.
+     */
+    std::string str(const LexemeView& lexeme) const {
+        return std::string((source ? source : lexemes.data()) + lexeme.offset, lexeme.length);
+    }
+};
+
+// A range of the parsed source, as byte offsets [begin, end), starting at line `line`.
+struct SourceSpan {
+    size_t begin = 0;
+    size_t end = 0;
+    int line = 1;
+};
+
+#endif
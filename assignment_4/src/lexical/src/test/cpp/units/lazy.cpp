@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include "../../../main/cpp/descent/parser.h"
+
+#include <logger.h>
+#include <nothingvisitor.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Tests for the lazy mode of the recursive-descent front end: only bodies reachable from `main` are parsed.
+ */
+
+/** Records the function-level visitor calls, with the line they happen at. */
+class RecordingVisitor : public NothingVisitor {
+    public:
+    explicit RecordingVisitor(Logger& logger) : NothingVisitor(logger) {}
+
+    void visit_func_start(ReturnType, const std::string& name) override {
+        record("start " + name);
+    }
+    void visit_func_end(const std::string& name, Node*) override {
+        record("end " + name);
+    }
+    void visit_func_deferred(const std::string& name, const SourceSpan& body) override {
+        record("deferred " + name);
+        spans.push_back(body);
+    }
+    void visit_func_resume(const std::string& name) override {
+        record("resume " + name + " at " + std::to_string(lineno()));
+    }
+    Node* visit_funccall(const std::string& name, Node*) override {
+        record("call " + name);
+        return nullptr;
+    }
+    void visit_program() override {
+        record("program");
+    }
+
+    std::vector<std::string> events;
+    std::vector<SourceSpan> spans;
+
+    private:
+    void record(const std::string& event) {
+        events.push_back(event);
+    }
+};
+
+class LazyTest : public testing::Test {
+    protected:
+    LazyTest() : logger(messages, messages, messages), vis(logger) {}
+
+    int parse(const std::string& source, bool lazy) {
+        ParseContext ctx;
+        vis.context = &ctx;
+        int parsed = lexical::descent::Parser(source.data(), source.data() + source.size(), ctx, vis, lazy).parse();
+        vis.context = nullptr;
+        return parsed;
+    }
+
+    std::ostringstream messages;
+    Logger logger;
+    RecordingVisitor vis;
+};
+
+TEST_F(LazyTest, reachable_only) {
+    const std::string source =
+        "void a(void) { b(); }\n"
+        "void b(void) {\n}\n"
+        "void dead(void) { dead2(); }\n"
+        "void dead2(void) { }\n"
+        "void main(void) { a(); }\n";
+    ASSERT_EQ(parse(source, true), 0) << messages.str();
+    EXPECT_EQ(vis.events, std::vector<std::string>({
+        "start a", "deferred a", "start b", "deferred b", "start dead", "deferred dead", "start dead2", "deferred dead2",
+        "start main", "call a", "end main",
+        "resume a at 1", "call b", "end a",
+        "resume b at 2", "end b",
+        "program"}));
+
+    ASSERT_EQ(vis.spans.size(), 4u);
+    EXPECT_EQ(source.substr(vis.spans[0].begin, vis.spans[0].end - vis.spans[0].begin), "{ b(); }");
+    EXPECT_EQ(source.substr(vis.spans[1].begin, vis.spans[1].end - vis.spans[1].begin), "{\n}");
+    EXPECT_EQ(vis.spans[2].line, 4);
+}
+
+TEST_F(LazyTest, eager_without_lazy) {
+    ASSERT_EQ(parse("void a(void) { }\nvoid main(void) { a(); }\n", false), 0) << messages.str();
+    EXPECT_EQ(vis.events, std::vector<std::string>({"start a", "end a", "start main", "call a", "end main", "program"}));
+}
+
+TEST_F(LazyTest, unbalanced_body_reports_error) {
+    // The body cannot be skipped, so it is parsed right away to report the error.
+    EXPECT_EQ(parse("void a(void) {\n  { ;\n", true), 1);
+    EXPECT_EQ(logger.n_errors(), 1u);
+    EXPECT_EQ(vis.events, std::vector<std::string>({"start a"}));
+}
+
+TEST_F(LazyTest, error_in_reachable_body) {
+    EXPECT_EQ(parse("void a(void) {\n  b(;\n}\nvoid main(void) { a(); }\n", true), 1);
+    EXPECT_NE(messages.str().find("line 2"), std::string::npos) << messages.str();
+}
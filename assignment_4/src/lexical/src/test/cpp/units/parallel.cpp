@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "../../../main/cpp/descent/parallel.h"
+#include "../../../main/cpp/descent/parser.h"
+#include "../../../main/cpp/descent/tape.h"
+
+#include <logger.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Tests for the parallel mode of the recursive-descent front end: the visitor must see the calls of a sequential parse.
+ */
+
+using namespace lexical::descent;
+
+class ParallelTest : public testing::Test {
+    protected:
+    ParallelTest() : logger(messages, messages, messages) {}
+
+    /** Parses `source` with either front end, recording the visitor calls on `tape`. */
+    int parse(const std::string& source, bool parallel, Tape& tape) {
+        ParseContext ctx;
+        TapeVisitor vis(logger, tape);
+        vis.context = &ctx;
+        if (parallel)
+            return parse_parallel(source.data(), source.data() + source.size(), vis, ctx, 4);
+        return Parser(source.data(), source.data() + source.size(), ctx, vis).parse();
+    }
+
+    void expect_same_parse(const std::string& source) {
+        SCOPED_TRACE(source);
+        Tape sequential, parallel;
+        EXPECT_EQ(parse(source, true, parallel), parse(source, false, sequential));
+        EXPECT_EQ(parallel.events, sequential.events);
+        EXPECT_EQ(parallel.messages, sequential.messages);
+    }
+
+    std::ostringstream messages;
+    Logger logger;
+};
+
+TEST_F(ParallelTest, split) {
+    const std::string source = "void a;\nvoid f(void) { { } ; }\n} void b, c;\n\nvoid g(void) {\n";
+    int lines;
+    const std::vector<Chunk> chunks = split(source.data(), source.data() + source.size(), lines);
+    std::vector<std::string> texts;
+    std::vector<int> starts;
+    for (const Chunk& chunk : chunks) {
+        texts.emplace_back(chunk.begin, chunk.end);
+        starts.push_back(chunk.line);
+    }
+    EXPECT_EQ(texts, std::vector<std::string>({"void a;", "\nvoid f(void) { { } ; }", "\n}", " void b, c;", "\n\nvoid g(void) {\n"}));
+    EXPECT_EQ(starts, std::vector<int>({1, 1, 2, 3, 3}));
+    EXPECT_EQ(lines, 6);
+
+    EXPECT_EQ(split(source.data(), source.data(), lines).size(), 1u);
+    EXPECT_EQ(split(source.data(), source.data() + 8, lines).size(), 1u); // "void a;\n": no chunk for trailing whitespace
+}
+
+TEST_F(ParallelTest, programs) {
+    std::string many;
+    for (int function = 0; function < 100; ++function)
+        many += "void f" + std::to_string(function) + "(void) {\n  void x;\n  x = f" + std::to_string(function) + "(x, 1 + 2) || (3);\n  return;\n}\n";
+    expect_same_parse(many);
+    expect_same_parse("void a, b;\n/* comment */ void main(void) {\n  { ; }\n  a = b = 1;\n  b(a, +a * 2 == 3);\n}\n\n");
+    expect_same_parse("void main(void) { }");
+}
+
+TEST_F(ParallelTest, errors) {
+    expect_same_parse("");
+    expect_same_parse("   \n");
+    expect_same_parse("void a; }\nvoid b;");
+    expect_same_parse("void a; x; void b;");
+    expect_same_parse("void a, b void c;");
+    expect_same_parse("void f(void) ; void g(void) { }");
+    expect_same_parse("void f(void) {\n  a = ;\n}\nvoid g(void) { b(; }");
+    expect_same_parse("void f(void) { {\n");
+    expect_same_parse("void a;\nvoid b; $ void c;");
+    expect_same_parse("void a; /* unclosed");
+    expect_same_parse("void main(void) {\n" + std::string(20000, '(') + "1" + std::string(20000, ')') + ";\n}\n");
+}
@@ -0,0 +1,61 @@
+#include "gtest/gtest.h"
+#include "../../../main/cpp/descent/tape.h"
+
+#include <algorithm>
+#include <lexical.h>
+#include <logger.h>
+#include <sstream>
+#include <string>
+
+/**
+ * Tests for the push mode of the bison parser: source fed in chunks must parse like the whole source at once.
+ */
+
+using namespace lexical::descent;
+
+class PushTest : public testing::Test {
+    protected:
+    PushTest() : logger(messages, messages, messages) {}
+
+    /** Feeds `source` to a push parser in chunks of `chunk_size` bytes, recording the visitor calls on `tape`. */
+    int push(const std::string& source, size_t chunk_size, Tape& tape) {
+        TapeVisitor vis(logger, tape);
+        lexical::PushParser parser(vis);
+        for (size_t x = 0; x < source.size(); x += chunk_size) {
+            if (int result = parser.feed(source.data() + x, std::min(chunk_size, source.size() - x)))
+                return result;
+        }
+        return parser.finish();
+    }
+
+    void expect_same_parse(const std::string& source) {
+        SCOPED_TRACE(source);
+        Tape whole;
+        TapeVisitor vis(logger, whole);
+        const int result = lexical::generate(source.data(), source.size(), vis);
+        ASSERT_FALSE(whole.events.empty());
+        for (size_t chunk_size : {1, 2, 7, 64}) {
+            SCOPED_TRACE(chunk_size);
+            Tape pushed;
+            EXPECT_EQ(push(source, chunk_size, pushed), result);
+            EXPECT_EQ(pushed.events, whole.events);
+            EXPECT_EQ(pushed.messages, whole.messages);
+        }
+    }
+
+    std::ostringstream messages;
+    Logger logger;
+};
+
+TEST_F(PushTest, programs) {
+    expect_same_parse("void a, b;\n/* comment\n over lines */ void main(void) {\n  { ; }\n  a = b = 1;\n  b(a, +a * 2 == 3);\n}\n");
+    expect_same_parse("void main(void) { a = f(a, b) <= 10 || a != b && !c; }");
+    expect_same_parse("");
+}
+
+TEST_F(PushTest, errors) {
+    expect_same_parse("void a; }\nvoid b;");
+    expect_same_parse("void f(void) {\n  a = ;\n}\nvoid g(void) { b(; }");
+    expect_same_parse("void a; /* unclosed");
+    expect_same_parse("void a;\nvoid b; $ void c;");
+}
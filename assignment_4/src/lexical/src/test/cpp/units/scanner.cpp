@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include "../../../main/cpp/descent/scanner.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Tests for the scanner of the recursive-descent front end. Every kernel set must produce the token stream of compiler.l.
+ */
+
+using namespace lexical::descent;
+
+struct Lexeme {
+    Token token;
+    std::string text;
+    int line;
+
+    bool operator==(const Lexeme& other) const {
+        return token == other.token && text == other.text && line == other.line;
+    }
+};
+
+static std::ostream& operator<<(std::ostream& stream, const Lexeme& lexeme) {
+    return stream << token_name(lexeme.token) << " '" << lexeme.text << "' at line " << lexeme.line;
+}
+
+static std::vector<Lexeme> scan(const std::string& source, const Kernels& kernels) {
+    ParseContext ctx;
+    Scanner scanner(source.data(), source.data() + source.size(), ctx, kernels);
+    std::vector<Lexeme> lexemes;
+    for (;;) {
+        const Token token = scanner.next();
+        lexemes.push_back({token, std::string(scanner.text(), scanner.length()), ctx.lineno});
+        if (token == TOK_ENDFILE || token == TOK_INVALID)
+            return lexemes;
+    }
+}
+
+static std::vector<Token> tokens(const std::string& source) {
+    std::vector<Token> result;
+    for (const Lexeme& lexeme : scan(source, kernels(KERNELS_SCALAR)))
+        result.push_back(lexeme.token);
+    return result;
+}
+
+/** Expects every supported kernel set to scan `source` like the scalar kernels. */
+static void expect_same_scan(const std::string& source) {
+    const std::vector<Lexeme> expected = scan(source, kernels(KERNELS_SCALAR));
+    for (KernelSet set : {KERNELS_SSE2, KERNELS_AVX2}) {
+        if (!supported(set))
+            continue;
+        SCOPED_TRACE(kernels(set).name);
+        ASSERT_EQ(scan(source, kernels(set)), expected) << "Source: " << source;
+    }
+}
+
+TEST(ScannerTest, keywords) {
+    EXPECT_EQ(tokens("else if int int8_t unsigned uint8_t return void while"), std::vector<Token>({TOK_ELSE, TOK_IF, TOK_INT, TOK_INT8, TOK_UNSIGNED, TOK_UINT8, TOK_RETURN, TOK_VOID, TOK_WHILE, TOK_ENDFILE}));
+    std::vector<Token> ids(12, TOK_ID);
+    ids.push_back(TOK_ENDFILE);
+    EXPECT_EQ(tokens("els iff in int8 unsigne uint8_t_ Return voids whil _ x w"), ids);
+}
+
+TEST(ScannerTest, operators) {
+    EXPECT_EQ(tokens("+-*/%&&||< <= > >= == != = ! ; , ( ) [ ] { }"), std::vector<Token>({TOK_PLUS, TOK_MINUS, TOK_TIMES, TOK_OVER, TOK_MOD, TOK_AND, TOK_OR, TOK_LT, TOK_LTE, TOK_GT, TOK_GTE, TOK_EQ, TOK_NEQ, TOK_ASSIGN, TOK_NOT, TOK_SEMI, TOK_COMMA, TOK_LPAREN, TOK_RPAREN, TOK_LBRACKET, TOK_RBRACKET, TOK_LBRACE, TOK_RBRACE, TOK_ENDFILE}));
+    EXPECT_EQ(tokens("a & b"), std::vector<Token>({TOK_ID, TOK_INVALID}));
+    EXPECT_EQ(tokens("a | b"), std::vector<Token>({TOK_ID, TOK_INVALID}));
+    EXPECT_EQ(tokens("a $"), std::vector<Token>({TOK_ID, TOK_INVALID}));
+}
+
+TEST(ScannerTest, comments) {
+    // Newlines in comments do not count, like in compiler.l.
+    const std::vector<Lexeme> lexemes = scan("a\n/* x\n*/ b /*/ c */ d/**/e\n/* unclosed\n", kernels(KERNELS_SCALAR));
+    ASSERT_EQ(lexemes.size(), 5u);
+    EXPECT_EQ(lexemes[0], (Lexeme{TOK_ID, "a", 1}));
+    EXPECT_EQ(lexemes[1], (Lexeme{TOK_ID, "b", 2}));
+    EXPECT_EQ(lexemes[2], (Lexeme{TOK_ID, "d", 2}));
+    EXPECT_EQ(lexemes[3], (Lexeme{TOK_ID, "e", 2}));
+    EXPECT_EQ(lexemes[4].token, TOK_INVALID);
+}
+
+TEST(ScannerTest, kernels_long_runs) {
+    // Runs around and across the 16 and 32 byte blocks of the vector kernels.
+    for (size_t length = 0; length < 100; ++length) {
+        expect_same_scan(std::string(length, ' ') + "x");
+        expect_same_scan("x" + std::string(length, '\n') + "y\n");
+        expect_same_scan(std::string(length, 'a') + "_9(" + std::string(length, 'Z'));
+        expect_same_scan("/*" + std::string(length, '*') + "*/ x");
+        expect_same_scan("/*" + std::string(length, '/') + "*/ x /*" + std::string(length, ' '));
+        expect_same_scan(" \t\n" + std::string(length, '\t') + "\xff" + std::string(length, 'q'));
+    }
+}
+
+TEST(ScannerTest, kernels_random) {
+    // Random sources made of the bytes the kernels distinguish. Rarely, a byte next to their ranges ends the token stream.
+    const std::string alphabet = " \t\n*/_azAZ09[{;+=";
+    const std::string invalid = "@`\x80\xff\r";
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<size_t> pick_invalid(0, invalid.size() - 1);
+    std::uniform_int_distribution<size_t> size(0, 200);
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (int round = 0; round < 2000; ++round) {
+        std::string source(size(random), ' ');
+        for (char& c : source)
+            c = percent(random) == 0 ? invalid[pick_invalid(random)] : alphabet[pick(random)];
+        expect_same_scan(source);
+    }
+}
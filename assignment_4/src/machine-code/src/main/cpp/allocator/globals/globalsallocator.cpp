@@ -35,11 +35,10 @@ void GlobalsAllocator::generate_data_segment() const {
 
     out << ".LCX:\n";
     for (auto global : globals) {
-        Symbol* sym = tab.getSymbol(global.first);
-        if (types::isArray(sym->getReturnType())) {
-            auto* arr = dynamic_cast<ArraySymbol*>(sym);
-            size_t element_size = util::get_n_bytes(util::to_iopt(types::arrayTypetoReturnType(arr->getReturnType())));
-            out << "\t.comm v" << global.first << ", " << element_size*arr->getSize() << "\n";
+        const Symbol* sym = tab.getSymbol(global.first);
+        if (sym->isArray()) {
+            size_t element_size = util::get_n_bytes(util::to_iopt(types::arrayTypetoReturnType(sym->getReturnType())));
+            out << "\t.comm v" << global.first << ", " << element_size*sym->getSize() << "\n";
         } else {
             out << "\t.comm v" << global.first << ", " << util::get_n_bytes(global.second) << "\n";
         }
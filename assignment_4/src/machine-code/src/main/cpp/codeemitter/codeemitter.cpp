@@ -18,15 +18,15 @@ void CodeEmitter::emit_epilogue() {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_store(size_t dst, const std::shared_ptr<IOperand>& src) {
+void CodeEmitter::emit_store(size_t dst, const IOperandSlot& src) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_return(const std::shared_ptr<IOperand>& src) {
+void CodeEmitter::emit_return(const IOperandSlot& src) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_uminus(size_t dst, const std::shared_ptr<IOperand> &src) {
+void CodeEmitter::emit_uminus(size_t dst, const IOperandSlot& src) {
     //TODO: implement me
 }
 
@@ -38,19 +38,19 @@ void CodeEmitter::emit_binop(IStatement* stmt) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_div(IOperator op, const std::shared_ptr<IOperand>& lhs, const std::shared_ptr<IOperand>& rhs, size_t dst_div, size_t dst_mod) {
+void CodeEmitter::emit_div(IOperator op, const IOperandSlot& lhs, const IOperandSlot& rhs, size_t dst_div, size_t dst_mod) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_not(size_t dst, const std::shared_ptr<IOperand>& src) {
+void CodeEmitter::emit_not(size_t dst, const IOperandSlot& src) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_cast(size_t dst, const std::shared_ptr<IOperand>& src) {
+void CodeEmitter::emit_cast(size_t dst, const IOperandSlot& src) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_param(const std::shared_ptr<IOperand>& opr) {
+void CodeEmitter::emit_param(const IOperandSlot& opr) {
     //TODO: implement me
 }
 
@@ -62,15 +62,15 @@ void CodeEmitter::emit_func(size_t func) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_set(IOperator op, const std::shared_ptr<IOperand>& op1, const std::shared_ptr<IOperand>& op2, const std::shared_ptr<SymbolIOperand>& result) {
+void CodeEmitter::emit_set(IOperator op, const IOperandSlot& op1, const IOperandSlot& op2, const IOperandSlot& result) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_relop(IOperator op, const std::shared_ptr<IOperand>& op1, const std::shared_ptr<IOperand>& op2, const std::shared_ptr<SymbolIOperand>& label) {
+void CodeEmitter::emit_relop(IOperator op, const IOperandSlot& op1, const IOperandSlot& op2, const IOperandSlot& label) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_jump_cond(IOperator op, const std::shared_ptr<IOperand> &op1, const std::shared_ptr<SymbolIOperand> &label) {
+void CodeEmitter::emit_jump_cond(IOperator op, const IOperandSlot& op1, const IOperandSlot& label) {
     //TODO: implement me
 }
 
@@ -78,11 +78,11 @@ void CodeEmitter::emit_jump(size_t sym) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_rarray_access(const std::shared_ptr<SymbolIOperand> &array_sym, const std::shared_ptr<IOperand> &index, const std::shared_ptr<SymbolIOperand> &dest) {
+void CodeEmitter::emit_rarray_access(const IOperandSlot& array_sym, const IOperandSlot& index, const IOperandSlot& dest) {
     //TODO: implement me
 }
 
-void CodeEmitter::emit_larray_access(const std::shared_ptr<SymbolIOperand>& src, const std::shared_ptr<IOperand>& index, const std::shared_ptr<SymbolIOperand>& array_sym) {
+void CodeEmitter::emit_larray_access(const IOperandSlot& src, const IOperandSlot& index, const IOperandSlot& array_sym) {
     //TODO: implement me
 }
 
@@ -3,7 +3,6 @@
 
 #include "../allocator/globals/globalsallocator.h"
 #include <ioperand.h>
-#include <memory>
 #include <ostream>
 #include <symbol.h>
 #include <unordered_map>
@@ -47,27 +46,27 @@ class CodeEmitter {
      * @param dst the symbol to which the value should be stored
      * @param src the operand which contains the value to store
      */
-    void emit_store(size_t dst, const std::shared_ptr<IOperand>& src);
+    void emit_store(size_t dst, const IOperandSlot& src);
 
     /**
      * Emit instruction to make a function return to its caller
-     * @param src the operand containing the value to return, or nullptr if no value needs to be returned
+     * @param src the operand containing the value to return, or an empty slot if no value needs to be returned
      */
-    void emit_return(const std::shared_ptr<IOperand>& src);
+    void emit_return(const IOperandSlot& src);
 
     /**
      * Emits unary minus instruction
      * @param dst the symbol to which the operation result should be stored
      * @param src the operand to which the operation should be applied
      */
-    void emit_uminus(size_t dst, const std::shared_ptr<IOperand>& src);
+    void emit_uminus(size_t dst, const IOperandSlot& src);
 
     /**
      * Emits logical not instruction
      * @param dst the symbol to which the operation result should be stored
      * @param src the operand to which the operation should be applied
      */
-    void emit_not(size_t dst, const std::shared_ptr<IOperand>& src);
+    void emit_not(size_t dst, const IOperandSlot& src);
 
     /**
      * Emits div instruction
@@ -78,14 +77,14 @@ class CodeEmitter {
      * @param dst_div (optional) the symbol to which the divide operation result should be stored
      * @param dst_mod (optional) the symbol to which the modulo operation result should be stored
      */
-    void emit_div(IOperator op, const std::shared_ptr<IOperand>& lhs, const std::shared_ptr<IOperand>& rhs, size_t dst_div = std::numeric_limits<size_t>::max(), size_t dst_mod = std::numeric_limits<size_t>::max());
+    void emit_div(IOperator op, const IOperandSlot& lhs, const IOperandSlot& rhs, size_t dst_div = std::numeric_limits<size_t>::max(), size_t dst_mod = std::numeric_limits<size_t>::max());
 
     /**
      * Emits cast instructions to cast the `src` to the `dst` type
      * @param dst the symbol to which the operation result should be stored
      * @param src the operand to which the operation should be applied
      */
-    void emit_cast(size_t dst, const std::shared_ptr<IOperand>& src);
+    void emit_cast(size_t dst, const IOperandSlot& src);
 
     /**
      * Emits a label
@@ -104,7 +103,7 @@ class CodeEmitter {
      * Handles a parameter instruction
      * @param opr the operand containing the value for the parameter
      */
-    void emit_param(const std::shared_ptr<IOperand>& opr);
+    void emit_param(const IOperandSlot& opr);
 
     /**
      * Emit function call instructions
@@ -125,9 +124,9 @@ class CodeEmitter {
      * @param op the IOperator to emit
      * @param op1 the left hand side to which the operation should be applied
      * @param op2 the right hand side to which the operation should be applied
-     * @param result the SymbolIOperand which saves the result of the operation
+     * @param result the symbol which saves the result of the operation
      */
-    void emit_set(IOperator op, const std::shared_ptr<IOperand>& op1, const std::shared_ptr<IOperand>& op2, const std::shared_ptr<SymbolIOperand>& result);
+    void emit_set(IOperator op, const IOperandSlot& op1, const IOperandSlot& op2, const IOperandSlot& result);
 
     /**
      * Emits a relational operator instruction
@@ -136,7 +135,7 @@ class CodeEmitter {
      * @param op2 the right hand side to which the operation should be applied
      * @param label the label to jump to if the condition holds
      */
-    void emit_relop(IOperator op, const std::shared_ptr<IOperand>& op1, const std::shared_ptr<IOperand>& op2, const std::shared_ptr<SymbolIOperand>& label);
+    void emit_relop(IOperator op, const IOperandSlot& op1, const IOperandSlot& op2, const IOperandSlot& label);
 
     /**
      * Emits a conditional jump instruction
@@ -144,7 +143,7 @@ class CodeEmitter {
      * @param op1 the operand to test
      * @param label the label to jump to if the condition holds
      */
-    void emit_jump_cond(IOperator op, const std::shared_ptr<IOperand>& op1, const std::shared_ptr<SymbolIOperand>& label);
+    void emit_jump_cond(IOperator op, const IOperandSlot& op1, const IOperandSlot& label);
 
     /**
      * Emits an unconditional jump instruction
@@ -154,19 +153,19 @@ class CodeEmitter {
 
     /**
      * Emits a lvariable array access
-     * @param array_sym the SymbolIOperand containing the identifier of the array
-     * @param index the IOperand containing the index to access
-     * @param dest the SymbolIOperand containing the symbol to which the array value should be saved
+     * @param array_sym the symbol of the array
+     * @param index the operand containing the index to access
+     * @param dest the symbol to which the array value should be saved
      */
-    void emit_rarray_access(const std::shared_ptr<SymbolIOperand>& array_sym, const std::shared_ptr<IOperand>& index, const std::shared_ptr<SymbolIOperand>& dest);
+    void emit_rarray_access(const IOperandSlot& array_sym, const IOperandSlot& index, const IOperandSlot& dest);
 
     /**
      * Emits a rvariable array access
-     * @param src the SymbolIOperand containing the value which should be saved in the array
-     * @param index the IOperand containing the index to which to save the value
-     * @param array_sym the SymbolIOperand containing the identifier of the array
+     * @param src the symbol containing the value which should be saved in the array
+     * @param index the operand containing the index to which to save the value
+     * @param array_sym the symbol of the array
      */
-    void emit_larray_access(const std::shared_ptr<SymbolIOperand>& src, const std::shared_ptr<IOperand>& index, const std::shared_ptr<SymbolIOperand>& array_sym);
+    void emit_larray_access(const IOperandSlot& src, const IOperandSlot& index, const IOperandSlot& array_sym);
 };
 
 #endif
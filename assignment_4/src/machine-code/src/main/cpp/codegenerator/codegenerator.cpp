@@ -9,8 +9,8 @@ void CodeGenerator::generate_header() {
 
 // Generates the declarations for the global variables
 void CodeGenerator::generate_global_decls(SymbolTable& table) {
-    for (auto symbol : table.getGlobals()) {
-        globals.insert(symbol.first, util::to_iopt(symbol.second->getReturnType()));
+    for (size_t id : table.globalIds()) {
+        globals.insert(id, util::to_iopt(table.getSymbol(id)->getReturnType()));
     }
 
     globals.generate_data_segment();
@@ -14,6 +14,8 @@ int main(int argc, char** argv) {
         TCLAP::ValueArg<std::string> outputFilenameArg("o", "output", "Path to destination file.", false, "", "string", cmd);
         TCLAP::SwitchArg noWarningSwitch("w", "no-warn", "Do not print warnings.", cmd, false);
         TCLAP::SwitchArg noPrintSwitch("p", "no-print", "Do not print output.", cmd, false);
+        TCLAP::ValueArg<std::string> saveCodeArg("", "save-ic", "Also save the intermediate code to this file.", false, "", "string", cmd);
+        TCLAP::SwitchArg fromCodeSwitch("", "from-ic", "The source file is intermediate code saved with --save-ic: only generate machine code.", cmd, false);
         cmd.parse(argc, argv);
 
         bool no_warn = noWarningSwitch.getValue();
@@ -22,7 +24,9 @@ int main(int argc, char** argv) {
         const std::string& outputFilePath = outputFilenameArg.getValue();
 
         Logger logger = Logger(std::cerr, no_warn ? NULL_STREAM : std::cerr, std::cerr);
-        machinecode::generate(logger, inputFilePath, outputFilePath, no_print);
+        if (fromCodeSwitch.getValue())
+            return machinecode::generate_from_code(logger, inputFilePath, outputFilePath, no_print) ? 0 : 1;
+        machinecode::generate(logger, inputFilePath, outputFilePath, no_print, saveCodeArg.getValue());
         return 0;
     } catch (TCLAP::ArgException& e) {
         std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
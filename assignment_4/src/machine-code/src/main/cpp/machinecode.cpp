@@ -1,19 +1,73 @@
 #include <fstream>
 #include <iostream>
+#include <ostream>
 #include <string>
-#include <sstream>
 
+#include <arena.h>
 #include <logger.h>
 #include <symboltable.h>
 #include <syntax.h>
 #include <syntaxtree.h>
 
+#include <icfile.h>
 #include <intermediate.h>
 
 #include "codegenerator.h"
 #include "machinecode.h"
 
-void machinecode::generate(SyntaxTree& tree, SymbolTable& table, Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath, bool no_print) {
+namespace {
+    /**
+     * Phase 3: writes the assembly of generated intermediate code to `output`.
+     */
+    void emit_assembly(SymbolTable& table, intermediate::Intermediate& result, std::ostream& output) {
+        CodeGenerator cg = CodeGenerator(output, table);
+        cg.generate_header();
+        cg.generate_global_decls(table);
+        cg.generate_code(table, result.icode, result.graph);
+        cg.generate_trailer();
+    }
+
+    /**
+     * Phases 2 and 3: generates intermediate code for a parsed program into `result`, and writes its assembly to `output`.
+     * Prints the intermediate code and flow graph to stdout, unless `no_print` is set. Saves the intermediate code to
+     * `codeFilePath`, if set.
+     */
+    void emit(SyntaxTree& tree, SymbolTable& table, Logger& logger, intermediate::Intermediate& result, std::ostream& output, bool no_print, const std::string& codeFilePath = "") {
+        // Phase 2: Intermediate code generation
+        intermediate::generate(tree, table, logger, result);
+        if (!no_print) {
+            result.icode.doStream(std::cout, &table);
+            std::cout << result.graph;
+        }
+        if (!codeFilePath.empty())
+            intermediate::save(codeFilePath, result.icode, table, logger);
+
+        // Phase 3: Machine code generation
+        emit_assembly(table, result, output);
+    }
+
+    /**
+     * Calls `write` with the stream to `outputFilePath`, or to stdout if it is empty. Prints nothing if `no_print` is set.
+     */
+    template<typename F>
+    void write_output(const std::string& outputFilePath, bool no_print, F write) {
+        if (outputFilePath.empty()) {
+            std::ostream output(no_print ? NULL_STREAM.rdbuf() : std::cout.rdbuf());
+            write(output);
+            return;
+        }
+
+        // Written to the file as it is generated, without holding all assembly in memory
+        std::ofstream f(outputFilePath);
+        write(f);
+        f << std::endl;
+        f.close();
+        if (!no_print)
+            std::cout << "Output has been stored at: " << outputFilePath << std::endl;
+    }
+}
+
+void machinecode::generate(SyntaxTree& tree, SymbolTable& table, Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath, bool no_print, const std::string& codeFilePath) {
     // Phase 1: Lexical analysis & syntaxtree generation
     // Parse input file, filling our syntaxtree and symboltable
     int parseResult = syntax::generate(inputFilePath, tree, table, logger);
@@ -24,38 +78,64 @@ void machinecode::generate(SyntaxTree& tree, SymbolTable& table, Logger& logger,
         tree.doStream(std::cout, 4, &table);
     }
 
-    // Phase 2: Intermediate code generation
-    intermediate::Intermediate result = intermediate::generate(tree, table, logger);
+    intermediate::Intermediate result(logger);
+    write_output(outputFilePath, no_print, [&](std::ostream& output) {
+        emit(tree, table, logger, result, output, no_print, codeFilePath);
+    });
+}
+
+bool machinecode::generate_from_code(Logger& logger, const std::string& codeFilePath, const std::string& outputFilePath, bool no_print) {
+    // The statements are copied out of the mapping in one go: there is nothing to parse.
+    SymbolTable table;
+    intermediate::Intermediate result(logger);
+    {
+        const intermediate::MappedCode code(codeFilePath, logger);
+        if (!code.load(table, result.icode))
+            return false;
+    }
+    result.graph.build(table, result.icode);
     if (!no_print) {
         result.icode.doStream(std::cout, &table);
         std::cout << result.graph;
     }
 
-    // Phase 3: Machine code generation
-    std::unique_ptr<std::ostream> strrr;
-    if (outputFilePath.empty()) {
-        strrr = no_print ? std::make_unique<std::ostream>(NULL_STREAM.rdbuf()) : std::make_unique<std::ostream>(std::cout.rdbuf()) ;
-    } else {
-        strrr = std::make_unique<std::stringstream>();
-    }
-
-    CodeGenerator cg = CodeGenerator(*strrr, table);
-    cg.generate_header();
-    cg.generate_global_decls(table);
-    cg.generate_code(table, result.icode, result.graph);
-    cg.generate_trailer();
+    write_output(outputFilePath, no_print, [&](std::ostream& output) {
+        emit_assembly(table, result, output);
+    });
+    return true;
+}
 
-    if (!outputFilePath.empty()) {
-        std::ofstream f(outputFilePath);
-        f << strrr->rdbuf() << std::endl;
-        f.close();
-        if (!no_print)
-            std::cout << "Output has been stored at: " << outputFilePath << std::endl;
-    }
+int machinecode::generate(SyntaxTree& tree, SymbolTable& table, Logger& logger, const char* source, size_t size, std::ostream& output) {
+    int parseResult = syntax::generate(source, size, tree, table, logger);
+    intermediate::Intermediate result(logger);
+    emit(tree, table, logger, result, output, true);
+    return parseResult;
 }
 
-void machinecode::generate(Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath, bool no_print) {
+void machinecode::generate(Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath, bool no_print, const std::string& codeFilePath) {
+    // All nodes, symbols and statements of this compilation are allocated from one arena, and released together.
+    Arena arena;
+    Arena::Scope scope(arena);
     SyntaxTree tree;
     SymbolTable table;
-    generate(tree, table, logger, inputFilePath, outputFilePath, no_print);
+    generate(tree, table, logger, inputFilePath, outputFilePath, no_print, codeFilePath);
+}
+
+int machinecode::generate(Logger& logger, const char* source, size_t size, std::ostream& output) {
+    return CompilationContext(logger).compile(source, size, output);
+}
+
+machinecode::CompilationContext::CompilationContext(Logger& logger) : logger(logger), result(logger) {}
+
+int machinecode::CompilationContext::compile(const char* source, size_t size, std::ostream& output) {
+    // Statements and non-arena nodes are destructed before their arena memory is handed out again.
+    result.icode.clear();
+    syntax_tree.clear();
+    symbol_table.clear();
+    memory.reset();
+
+    Arena::Scope scope(memory);
+    int parseResult = syntax::generate(source, size, syntax_tree, symbol_table, logger);
+    emit(syntax_tree, symbol_table, logger, result, output, true);
+    return parseResult;
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #ifndef COCO_FRAMEWORK_MACHINECODE_ENTRYPOINT
 #define COCO_FRAMEWORK_MACHINECODE_ENTRYPOINT
 
+#include <ostream>
 #include <string>
+#include <arena.h>
+#include <intermediate.h>
 #include <logger.h>
 #include <symboltable.h>
 #include <syntaxtree.h>
@@ -12,14 +15,74 @@ namespace machinecode {
      * @param inputFilePath File input.
      * @param outputFilePath File output. If not specified, output is printed to stdout instead.
      * @param no_print If set, does not print anything.
+     * @param codeFilePath If specified, the intermediate code is also saved there, for `generate_from_code`.
      */
-    void generate(SyntaxTree& tree, SymbolTable& table, Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath="", bool no_print=false);
+    void generate(SyntaxTree& tree, SymbolTable& table, Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath="", bool no_print=false, const std::string& codeFilePath="");
 
     /**
      * Exactly like above `generate` function, with default-constructed `SyntaxTree` and `SymbolTable`.
-     * @see #generate(SyntaxTree&, SymbolTable&, Logger&, const std::string&, const std::string&, bool no_print);
+     * @see #generate(SyntaxTree&, SymbolTable&, Logger&, const std::string&, const std::string&, bool, const std::string&);
      */
-    void generate(Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath="", bool no_print=false);
+    void generate(Logger& logger, const std::string& inputFilePath, const std::string& outputFilePath="", bool no_print=false, const std::string& codeFilePath="");
+
+    /**
+     * Executes the machinecode stage alone, on intermediate code saved by `generate`. The file is memory-mapped, not parsed.
+     * @param codeFilePath File with the saved intermediate code.
+     * @param outputFilePath File output. If not specified, output is printed to stdout instead.
+     * @param no_print If set, does not print anything.
+     * @return whether the file could be read. Errors go to `logger`.
+     */
+    bool generate_from_code(Logger& logger, const std::string& codeFilePath, const std::string& outputFilePath="", bool no_print=false);
+
+    /**
+     * Compiles in-memory source, without touching the filesystem, and writes the output assembly to `output` as it is generated.
+     * Prints nothing: diagnostics go to `logger`.
+     * @param source Source of `size` bytes, e.g. `std::string::data()`. Need not be NUL-terminated.
+     * @return exit code of the parser: the assembly is only meaningful if it is 0.
+     */
+    int generate(SyntaxTree& tree, SymbolTable& table, Logger& logger, const char* source, size_t size, std::ostream& output);
+
+    /**
+     * Exactly like above `generate` function, with default-constructed `SyntaxTree` and `SymbolTable`.
+     * @see #generate(SyntaxTree&, SymbolTable&, Logger&, const char*, size_t, std::ostream&);
+     */
+    int generate(Logger& logger, const char* source, size_t size, std::ostream& output);
+
+    /**
+     * Owns the structures of a compilation (arena, syntax tree, symbol table, intermediate code and flow graph), and
+     * clears them between compilations instead of destroying them. Their memory is kept for the next program, so a batch
+     * of small programs compiles without allocating much after the first few.
+     * Not thread-safe: use one context per thread.
+     */
+    class CompilationContext {
+        public:
+        // Diagnostics of all compilations go to `logger`.
+        explicit CompilationContext(Logger& logger);
+
+        CompilationContext(const CompilationContext&) = delete;
+        CompilationContext& operator=(const CompilationContext&) = delete;
+
+        /**
+         * Compiles in-memory source, like `generate(Logger&, const char*, size_t, std::ostream&)`.
+         * The tree, table and code of the previous compilation are dropped first.
+         * @return exit code of the parser: the assembly is only meaningful if it is 0.
+         */
+        int compile(const char* source, size_t size, std::ostream& output);
+
+        // The structures of the last compilation, valid until the next one.
+        const Arena& arena() const { return memory; }
+        const SyntaxTree& tree() const { return syntax_tree; }
+        const SymbolTable& table() const { return symbol_table; }
+        const intermediate::Intermediate& code() const { return result; }
+
+        private:
+        Logger& logger;
+        // Declared first, so it outlives everything allocated in it
+        Arena memory;
+        SyntaxTree syntax_tree;
+        SymbolTable symbol_table;
+        intermediate::Intermediate result;
+    };
 
 }
 
@@ -0,0 +1,52 @@
+#include "../support/fixture.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <machinecode.h>
+
+/**
+ * Tests for `generate_from_code`: the machinecode stage run on a saved intermediate code file must write the same
+ * assembly as a compilation from source.
+ */
+
+class CodeFileTest : public MachineCodeTest {
+protected:
+    CodeFileTest() : MachineCodeTest(std::cerr, std::cerr, std::cerr, std::cout) {}
+
+    static std::string read(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    const std::string dir = testing::TempDir();
+    const std::string source = dir + "codefile.c";
+    const std::string code = dir + "codefile.ic";
+    const std::string direct = dir + "codefile.direct.s";
+    const std::string mapped = dir + "codefile.mapped.s";
+
+    ~CodeFileTest() override {
+        for (const std::string* path : {&source, &code, &direct, &mapped})
+            std::remove(path->c_str());
+    }
+};
+
+TEST_F(CodeFileTest, same_as_direct) {
+    std::ofstream(source) <<
+        "void a, b;\n"
+        "void f(void) {\n    void x;\n    x = a + b * 2;\n    {\n        void y;\n        y = x * x;\n        b = y + x;\n    }\n    return;\n}\n"
+        "void main(void) {\n    a = 1;\n    b = a == 2 && a != 3 || b == 4;\n    f();\n    return;\n}\n";
+
+    machinecode::generate(logger, source, direct, true, code);
+    ASSERT_FALSE(read(code).empty());
+    ASSERT_TRUE(machinecode::generate_from_code(logger, code, mapped, true));
+    EXPECT_EQ(read(mapped), read(direct));
+}
+
+TEST_F(CodeFileTest, rejects_damaged) {
+    std::ofstream(code) << "not intermediate code";
+    EXPECT_FALSE(machinecode::generate_from_code(logger, code, mapped, true));
+}
@@ -0,0 +1,111 @@
+#include "../support/fixture.h"
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <machinecode.h>
+
+/**
+ * Tests for CompilationContext: compiling through one context must give the same output as a fresh compilation,
+ * and once it has seen the programs of a batch, compiling them again must not grow its structures.
+ */
+
+class CompilationContextTest : public MachineCodeTest {
+protected:
+    CompilationContextTest() : MachineCodeTest(std::cerr, std::cerr, std::cerr, std::cout) {}
+
+    // Output of `generate` on `source`, with fresh structures
+    std::string fresh_assembly(const std::string& source) {
+        std::ostringstream output;
+        machinecode::generate(logger, source.data(), source.size(), output);
+        return output.str();
+    }
+
+    // Intermediate code of `source`, compiled by a fresh context
+    std::string fresh_code(const std::string& source) {
+        machinecode::CompilationContext context(logger);
+        std::ostringstream output;
+        context.compile(source.data(), source.size(), output);
+        return code_of(context);
+    }
+
+    static std::string code_of(const machinecode::CompilationContext& context) {
+        std::ostringstream stream;
+        context.code().icode.doStream(stream, &context.table());
+        return stream.str();
+    }
+
+    // Programs of different sizes, so a context sees both growth and shrinkage between compilations
+    const std::vector<std::string> programs = {
+        "void main(void) {\n    return;\n}\n",
+        "void g;\n"
+        "void f(void) {\n    g = 2 * 3;\n}\n"
+        "void main(void) {\n    void a;\n    a = 3;\n    g = a * 2 + a;\n    f();\n    return;\n}\n",
+        "void a, b, c;\n"
+        "void f(void) {\n    void x;\n    x = a + b * c;\n    {\n        void y;\n        y = x * x + a * b;\n        c = y + x;\n    }\n    return;\n}\n"
+        "void g(void) {\n    a = (a + 1) * (b + 2) * (c + 3);\n    b = a == b && b != c || c == 4;\n    f();\n}\n"
+        "void main(void) {\n    a = 1;\n    b = 2;\n    c = a + b + 3 * (a + b);\n    g();\n    f();\n    return;\n}\n",
+    };
+};
+
+TEST_F(CompilationContextTest, same_as_fresh) {
+    machinecode::CompilationContext context(logger);
+    // Each program twice in a row, then all of them again in reverse
+    std::vector<size_t> order;
+    for (size_t x = 0; x < programs.size(); ++x)
+        order.insert(order.end(), {x, x});
+    for (size_t x = programs.size(); x-- > 0;)
+        order.push_back(x);
+
+    for (size_t x : order) {
+        const std::string& source = programs[x];
+        std::ostringstream output;
+        ASSERT_EQ(context.compile(source.data(), source.size(), output), 0) << "program " << x;
+        EXPECT_EQ(output.str(), fresh_assembly(source)) << "program " << x;
+        EXPECT_EQ(code_of(context), fresh_code(source)) << "program " << x;
+    }
+}
+
+TEST_F(CompilationContextTest, stops_growing) {
+    machinecode::CompilationContext context(logger);
+    // The first round sizes the structures for the largest program.
+    for (const std::string& source : programs) {
+        std::ostringstream output;
+        ASSERT_EQ(context.compile(source.data(), source.size(), output), 0);
+    }
+    const size_t reserved = context.arena().bytes_reserved();
+    const size_t symbols = context.table().capacity();
+    const size_t statements = context.code().icode.capacity();
+    EXPECT_GT(reserved, 0u);
+
+    // Checked after each program, not each round: the small ones must not give back what the large ones need.
+    for (int round = 0; round < 5; ++round) {
+        for (size_t x = 0; x < programs.size(); ++x) {
+            std::ostringstream output;
+            ASSERT_EQ(context.compile(programs[x].data(), programs[x].size(), output), 0);
+            EXPECT_EQ(context.arena().bytes_reserved(), reserved) << "round " << round << ", program " << x;
+            EXPECT_EQ(context.table().capacity(), symbols) << "round " << round << ", program " << x;
+            EXPECT_EQ(context.code().icode.capacity(), statements) << "round " << round << ", program " << x;
+        }
+    }
+}
+
+TEST_F(CompilationContextTest, table_keeps_capacity) {
+    // What the context relies on: a cleared table holds as many symbols as before, whatever the next program has.
+    auto fill = [this](size_t count) {
+        table.clear();
+        const size_t func = table.addFunction(Symbol("main", 1, RT_VOID, ST_FUNCTION));
+        for (size_t x = 1; x < count; ++x)
+            table.addSymbol(Symbol("v" + std::to_string(x), 1, RT_VOID, ST_VARIABLE), func);
+    };
+    fill(100);
+    const size_t symbols = table.capacity();
+    EXPECT_GE(symbols, 100u);
+    for (size_t count : {3, 100, 1, 50}) {
+        fill(count);
+        EXPECT_EQ(table.capacity(), symbols) << count << " symbols";
+        EXPECT_EQ(table.getSymbol(count)->getName(), count == 1 ? "main" : "v" + std::to_string(count - 1));
+    }
+}
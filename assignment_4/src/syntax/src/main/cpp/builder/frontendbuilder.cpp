@@ -1,17 +1,12 @@
 #include "frontendbuilder.h"
 #include <iostream>
 
-FrontendBuilder::~FrontendBuilder() {
-    for (auto& scope: scope_stack)
-        delete scope;
-}
-
 void FrontendBuilder::enterNewScope() {
-    //TODO: implement me
+    scopes.enter();
 }
 
 void FrontendBuilder::exitCurrentScope() {
-    //TODO: implement me
+    scopes.exit();
 }
 
 size_t FrontendBuilder::addSymbol(Symbol* symbol) {
@@ -28,9 +23,39 @@ void FrontendBuilder::leaveFunction() {
     //TODO: implement me
 }
 
+void FrontendBuilder::deferFunction(const SourceSpan& body) {
+    const size_t id = current_function;
+    leaveFunction();
+    deferred.emplace(id, DeferredBody{body, scopes.mark()});
+}
+
+bool FrontendBuilder::resumeFunction(const std::string& name) {
+    size_t id = getId(name);
+    auto it = deferred.find(id);
+    if (it == deferred.end())
+        return false;
+    current_function = id;
+    // Like entering the function at its declaration: only what was declared before it is visible,
+    // and its parameters are visible in the outermost scope of the body.
+    scopes.rewind(it->second.scope_mark);
+    deferred.erase(it);
+    scopes.enter();
+    for (size_t parameter: table.getParameters(id))
+        scopes.addSymbol(table.getSymbol(parameter)->getNameAtom(), parameter);
+    return true;
+}
+
+void FrontendBuilder::endResumedFunction() {
+    scopes.restore();
+}
+
+const SourceSpan* FrontendBuilder::getDeferredBody(size_t id) const {
+    auto it = deferred.find(id);
+    return it == deferred.end() ? nullptr : &it->second.body;
+}
+
 size_t FrontendBuilder::getId(const std::string& name) {
-    //TODO: implement me
-    return std::numeric_limits<size_t>::max();
+    return scopes.getSymbolId(name);
 }
 
 Symbol* FrontendBuilder::getSymbol(size_t id) {
@@ -18,11 +18,21 @@ int main(int argc, char** argv) {
         TCLAP::SwitchArg noWarningSwitch("w", "no-warn", "Do not print warnings.", cmd, false);
         TCLAP::SwitchArg noErrorSwitch("e", "no-error", "Do not print errors.", cmd, false);
         TCLAP::SwitchArg noPrintSwitch("p", "no-print", "Do not print output.", cmd, false);
+        TCLAP::SwitchArg descentSwitch("d", "descent", "Parse with the recursive-descent front end instead of bison.", cmd, false);
+        TCLAP::SwitchArg lazySwitch("l", "lazy", "Parse only function bodies reachable from main (implies --descent).", cmd, false);
+        TCLAP::SwitchArg parallelSwitch("j", "parallel", "Parse top-level declarations on all cores (implies --descent).", cmd, false);
         cmd.parse(argc, argv);
 
         bool no_warn = noWarningSwitch.getValue();
         bool no_error = noErrorSwitch.getValue();
         bool no_print = noPrintSwitch.getValue();
+        lexical::Frontend frontend = lexical::FRONTEND_BISON;
+        if (parallelSwitch.getValue())
+            frontend = lexical::FRONTEND_DESCENT_PARALLEL;
+        else if (lazySwitch.getValue())
+            frontend = lexical::FRONTEND_DESCENT_LAZY;
+        else if (descentSwitch.getValue())
+            frontend = lexical::FRONTEND_DESCENT;
         const std::string& inputFilePath = inputFilenameArg.getValue();
 
         // Phase 1: Lexical analysis & syntaxtree generation
@@ -31,7 +41,7 @@ int main(int argc, char** argv) {
         SyntaxTree tree;
 
         // Parse input file, filling our syntaxtree and symboltable
-        int parseResult = syntax::generate(inputFilePath, tree, table, logger);
+        int parseResult = syntax::generate(inputFilePath, tree, table, logger, frontend);
 
         if (!no_print) {
             std::cout << "Parse result: " << parseResult << std::endl;
@@ -3,11 +3,24 @@
 #include <lexical.h>
 
 int syntax::generate(FILE* file, SyntaxTree& tree, SymbolTable& table, Logger& logger) {
+    return generate(file, tree, table, logger, lexical::FRONTEND_BISON);
+}
+
+int syntax::generate(FILE* file, SyntaxTree& tree, SymbolTable& table, Logger& logger, lexical::Frontend frontend) {
     SyntaxVisitor vis(logger, table, tree);
-    return lexical::generate(file, vis);
+    return lexical::generate(file, vis, frontend);
 }
 
 int syntax::generate(const std::string& filename, SyntaxTree& tree, SymbolTable& table, Logger& logger) {
+    return generate(filename, tree, table, logger, lexical::FRONTEND_BISON);
+}
+
+int syntax::generate(const std::string& filename, SyntaxTree& tree, SymbolTable& table, Logger& logger, lexical::Frontend frontend) {
+    SyntaxVisitor vis(logger, table, tree);
+    return lexical::generate(filename, vis, frontend);
+}
+
+int syntax::generate(const char* source, size_t size, SyntaxTree& tree, SymbolTable& table, Logger& logger, lexical::Frontend frontend) {
     SyntaxVisitor vis(logger, table, tree);
-    return lexical::generate(filename, vis);
+    return lexical::generate(source, size, vis, frontend);
 }
\ No newline at end of file
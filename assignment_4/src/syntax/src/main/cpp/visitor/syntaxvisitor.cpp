@@ -10,8 +10,6 @@
 
 #include <to_string.h>
 
-extern int lineno;
-
 void SyntaxVisitor::add_builtins() {
     auto* sym = new Symbol();
     sym->setName("readinteger");
@@ -65,13 +63,28 @@ void SyntaxVisitor::visit_func_end(const std::string& name, Node* root) {
     //TODO: implement me
 }
 
+void SyntaxVisitor::visit_func_deferred(const std::string&, const SourceSpan& body) {
+    builder.deferFunction(body);
+}
+
+void SyntaxVisitor::visit_func_resume(const std::string& name) {
+    if (!builder.resumeFunction(name))
+        logger.error(lineno()) << "cannot resume function " << name << ", its body was not deferred" << '\n';
+}
+
+void SyntaxVisitor::visit_func_resume_end(const std::string&) {
+    builder.endResumedFunction();
+}
+
 Node* SyntaxVisitor::visit_funccall(const std::string& name, Node* exprlist) {
     //TODO: implement me
     return nullptr;
 }
 
 void SyntaxVisitor::visit_statement_list(Node* stmt, ListTree& stmtlist) const {
-    //TODO: implement me
+    if (stmtlist.root == nullptr)
+        stmtlist.root = SyntaxTree::createListNode(NODE_STATEMENT_LIST);
+    stmtlist.root->addChild(stmt);
 }
 
 Node* SyntaxVisitor::visit_assignment(Node* var, Node* expr) {
@@ -135,7 +148,9 @@ Node* SyntaxVisitor::visit_return(Node* expr) {
 }
 
 void SyntaxVisitor::visit_exprlist(Node* expr, ListTree& exprlist) const {
-    //TODO: implement me
+    if (exprlist.root == nullptr)
+        exprlist.root = SyntaxTree::createListNode(NODE_EXPRLIST);
+    exprlist.root->addChild(expr);
 }
 
 Node* SyntaxVisitor::visit_operator(NodeType op, Node* lhs, Node* rhs) {
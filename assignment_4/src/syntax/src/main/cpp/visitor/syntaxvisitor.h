@@ -44,6 +44,25 @@ class SyntaxVisitor : public BaseVisitor {
      */
     void visit_func_end(const std::string& name, Node* root) override;
 
+    /**
+     * Visitor function for a function whose body is skipped by the lazy front end
+     * @param name Name of the function
+     * @param body Source span of the body
+     */
+    void visit_func_deferred(const std::string& name, const SourceSpan& body) override;
+
+    /**
+     * Visitor function to re-enter a deferred function before its body is parsed
+     * @param name Name of the function
+     */
+    void visit_func_resume(const std::string& name) override;
+
+    /**
+     * Visitor function to leave a resumed function after its body is parsed
+     * @param name Name of the function
+     */
+    void visit_func_resume_end(const std::string& name) override;
+
     /**
      * Visitor function for function calls
      * @param name Name of the function
@@ -55,8 +74,7 @@ class SyntaxVisitor : public BaseVisitor {
     /**
      * Visitor function for statement lists
      * @param stmt Node* to current statement
-     * @param stmtlist Node* to the rest of the statements
-     * @return created NODE_STATEMENT_LIST node
+     * @param stmtlist the NODE_STATEMENT_LIST built so far; `stmt` is appended to it
      */
     void visit_statement_list(Node* stmt, ListTree& stmtlist) const override;
 
@@ -176,7 +194,7 @@ class SyntaxVisitor : public BaseVisitor {
     /**
      * Visitor function to handle expression lists
      * @param expr Node* to the current expression
-     * @param exprlist contains the root of the expression list, and the current position
+     * @param exprlist the NODE_EXPRLIST built so far; `expr` is appended to it
      */
     void visit_exprlist(Node* expr, ListTree& exprlist) const override;
 
@@ -11,14 +11,17 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #ifndef COCO_FRAMEWORK_SYNTAX_FRONTENDBUILDER
 #define COCO_FRAMEWORK_SYNTAX_FRONTENDBUILDER
 
+#include <unordered_map>
+
 #include "node.h"
+#include "parsecontext.h"
+#include "scope.h"
 #include "symbol.h"
 #include "symboltable.h"
 #include "syntaxtree.h"
 class FrontendBuilder {
     public:
     explicit FrontendBuilder(SymbolTable& table, SyntaxTree& tree) : table(table), tree(tree){};
-    ~FrontendBuilder();
 
     // creates a new scope and sets this as the current scope
     void enterNewScope();
@@ -41,6 +44,25 @@ class FrontendBuilder {
     // leaves the current function
     void leaveFunction();
 
+    // records `body` as the unparsed body of the current function, and leaves the function
+    void deferFunction(const SourceSpan& body);
+
+    /**
+     * re-enters deferred function `name`, with a new scope holding its parameters, to parse its body after all.
+     * Names resolve as they did where the function was deferred: later declarations are hidden until `endResumedFunction`.
+     * @return `true` on success, `false` if `name` has no deferred body
+     */
+    bool resumeFunction(const std::string& name);
+
+    // leaves a function re-entered with `resumeFunction`: closes the scopes still open in it, and shows the later declarations again
+    void endResumedFunction();
+
+    /**
+     * @param id Function identifier.
+     * @return the source span of the unparsed body of function `id`, or `nullptr` if its body was parsed (or never deferred).
+     */
+    const SourceSpan* getDeferredBody(size_t id) const;
+
     // find id of symbol identified by name
     size_t getId(const std::string& name);
 
@@ -75,10 +97,18 @@ class FrontendBuilder {
     SymbolTable& table;
     SyntaxTree& tree;
 
-    // Stack to keep track of current scope
-    std::vector<Scope*> scope_stack = {new Scope()};
+    // Open scopes, to resolve names to the innermost declaration
+    ScopeStack scopes;
     // Identifier of the current function
     size_t current_function = 0;
+    struct DeferredBody {
+        SourceSpan body;
+        // Declarations visible where the function was deferred (see ScopeStack::mark)
+        size_t scope_mark;
+    };
+
+    // Bodies of functions that are not parsed (yet), by function identifier
+    std::unordered_map<size_t, DeferredBody> deferred;
 };
 
 #endif
@@ -11,6 +11,7 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #ifndef COCO_FRAMEWORK_SYNTAX_ENTRYPOINT
 #define COCO_FRAMEWORK_SYNTAX_ENTRYPOINT
 
+#include <lexical.h>
 #include <logger.h>
 #include <symboltable.h>
 #include <syntaxtree.h>
@@ -21,11 +22,29 @@ namespace syntax {
      */
     int generate(FILE* file, SyntaxTree&, SymbolTable&, Logger&);
 
+    /**
+     * Exactly like above `generate` function, with the recursive-descent parser if `frontend` says so.
+     * @see #generate(FILE*, SyntaxTree&, SymbolTable&, Logger&);
+     */
+    int generate(FILE* file, SyntaxTree&, SymbolTable&, Logger&, lexical::Frontend frontend);
+
     /**
      * @param filename File to be read in.
      * @return `yyparse` exit code.
      */
     int generate(const std::string& filename, SyntaxTree& tree, SymbolTable& table, Logger& logger);
+
+    /**
+     * Exactly like above `generate` function, with the recursive-descent parser if `frontend` says so.
+     * @see #generate(const std::string&, SyntaxTree&, SymbolTable&, Logger&);
+     */
+    int generate(const std::string& filename, SyntaxTree& tree, SymbolTable& table, Logger& logger, lexical::Frontend frontend);
+
+    /**
+     * @param source In-memory source of `size` bytes, e.g. `std::string::data()`. Need not be NUL-terminated.
+     * @return `yyparse` exit code.
+     */
+    int generate(const char* source, size_t size, SyntaxTree& tree, SymbolTable& table, Logger& logger, lexical::Frontend frontend = lexical::FRONTEND_BISON);
 }
 
 #endif
@@ -23,6 +23,7 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #include <hacks/template_hacks.h>
 #include <logger.h>
 #include <node.h>
+#include <nodevisitor.h>
 #include <symboltable.h>
 #include <syntaxtree.h>
 #include <types.h>
@@ -57,12 +58,11 @@ namespace test {
             return std::numeric_limits<size_t>::max();
         }
 
-        inline BinaryNode* get_root(const SyntaxTree& tree, const SymbolTable& table, const std::string& func_name) {
+        inline Node* get_root(const SyntaxTree& tree, const SymbolTable& table, const std::string& func_name) {
             size_t id = get(table, func_name);
             if (id == std::numeric_limits<size_t>::max())
                 return nullptr;
-            Node* root = tree.getRoot(id);
-            return dynamic_cast<BinaryNode*>(root);
+            return tree.getRoot(id);
         }
 
         inline testing::AssertionResult root_empty(const SyntaxTree& tree, const SymbolTable& table, const std::string& func_name) {
@@ -143,10 +143,41 @@ namespace test {
                 Node* source;
                 SymbolTable* tableRef;
                 size_t functionRef = 0;
+                size_t listIndex = 0; // if `source` is a ListNode, the index of the element this handle fills.
 
                 TreeHandle() : source(nullptr), tableRef(nullptr) {}
                 TreeHandle(SymbolTable* table, size_t function) : source(nullptr), tableRef(table), functionRef(function) {}
-                TreeHandle(Node* source, SymbolTable* table, size_t function) : source(source), tableRef(table), functionRef(function) {}
+                TreeHandle(Node* source, SymbolTable* table, size_t function, size_t listIndex = 0) : source(source), tableRef(table), functionRef(function), listIndex(listIndex) {}
+
+                /**
+                 * Attaches `node` to `source`, filling the left child of a binary node before the right one.
+                 * For a ListNode, the first node added to a handle becomes its element. Adding a list of the same type after that
+                 * continues the list (just like the right child of the old binary lists did), and NODE_EMPTY terminates it.
+                 * @return TreeHandle for `node`, the handle for the next list element on continuation, or a handle with nullptr source on failure.
+                 */
+                inline TreeHandle attach(Node* node) const {
+                    if (auto* unaryNode = node_cast<UnaryNode>(source)) {
+                        unaryNode->setChild(node);
+                        return {node, tableRef, functionRef};
+                    } else if (auto* binaryNode = node_cast<BinaryNode>(source)) {
+                        (!binaryNode->getLeftChild() ? binaryNode->setLeftChild(node) : binaryNode->setRightChild(node));
+                        return {node, tableRef, functionRef};
+                    } else if (auto* listNode = node_cast<ListNode>(source)) {
+                        if (listNode->size() > listIndex) {
+                            if (node->getNodeType() == listNode->getNodeType() && node->getKind() == NK_LIST) {
+                                delete node;
+                                return {listNode, tableRef, functionRef, listIndex + 1};
+                            } else if (node->getNodeType() == NODE_EMPTY) {
+                                delete node;
+                                return {};
+                            }
+                        }
+                        listNode->addChild(node);
+                        return {node, tableRef, functionRef};
+                    }
+                    delete node;
+                    return {};
+                }
 
                 /**
                  * Adds a unary node to the tree.
@@ -155,40 +186,21 @@ namespace test {
                  * @return TreeHandle for added node on success, Treehandle with nullptr source on failure.
                  */
                 inline TreeHandle add_unary(NodeType nodeType, ReturnType returnType) const {
-                    if (auto* unaryNode = dynamic_cast<UnaryNode*>(source)) {
-                        unaryNode->setChild(new UnaryNode(nodeType, returnType));
-                        return {unaryNode->getChild(), tableRef, functionRef};
-                    } else if (auto* binaryNode = dynamic_cast<BinaryNode*>(source)) {
-                        auto* returnNode = new UnaryNode(nodeType, returnType);
-                        (!binaryNode->getLeftChild() ? binaryNode->setLeftChild(returnNode) : binaryNode->setRightChild(returnNode));
-                        return {returnNode, tableRef, functionRef};
-                    }
-                    return {};
+                    return attach(new UnaryNode(nodeType, returnType));
                 }
 
                 /**
-                 * Adds a binary node to the tree.
+                 * Adds a binary node to the tree. NODE_STATEMENT_LIST and NODE_EXPRLIST create a ListNode instead.
                  * @see test::build::FunctionTreeBuilder::TreeHandle::add_unary(Nodetype, ReturnType).
                  */
                 inline TreeHandle add_binary(NodeType nodeType, ReturnType returnType) const {
-                    if (auto* unaryNode = dynamic_cast<UnaryNode*>(source)) {
-                        unaryNode->setChild(new BinaryNode(nodeType, returnType));
-                        return {unaryNode->getChild(), tableRef, functionRef};
-                    } else if (auto* binaryNode = dynamic_cast<BinaryNode*>(source)) {
-                        auto* returnNode = new BinaryNode(nodeType, returnType);
-                        (!binaryNode->getLeftChild() ? binaryNode->setLeftChild(returnNode) : binaryNode->setRightChild(returnNode));
-                        return {returnNode, tableRef, functionRef};
-                    }
-                    return {};
+                    if (nodeType == NODE_STATEMENT_LIST || nodeType == NODE_EXPRLIST)
+                        return attach(new ListNode(nodeType, returnType));
+                    return attach(new BinaryNode(nodeType, returnType));
                 }
 
                 inline void add_empty() const {
-                    if (auto* unaryNode = dynamic_cast<UnaryNode*>(source)) {
-                        unaryNode->setChild(new Node(NODE_EMPTY, RT_VOID));
-                    } else if (auto* binaryNode = dynamic_cast<BinaryNode*>(source)) {
-                        auto* returnNode = new Node(NODE_EMPTY, RT_VOID);
-                        (!binaryNode->getLeftChild() ? binaryNode->setLeftChild(returnNode) : binaryNode->setRightChild(returnNode));
-                    }
+                    attach(new Node(NODE_EMPTY, RT_VOID));
                 }
 
                 /**
@@ -198,7 +210,7 @@ namespace test {
                  * @see test::build::FunctionTreeBuilder::TreeHandle::add_unary(NodeType, ReturnType).
                  */
                 inline size_t add_symbol(NodeType nodeType, ReturnType returnType, Symbol* sym) const {
-                    auto symId = tableRef->addSymbol(sym, functionRef);
+                    auto symId = tableRef->addSymbol(std::unique_ptr<Symbol>(sym), functionRef);
                     return add_symbol(nodeType, returnType, symId);
                 }
 
@@ -209,15 +221,9 @@ namespace test {
                  * @see test::build::FunctionTreeBuilder::TreeHandle::add_symbol(NodeType, ReturnType, Symbol*)
                  */
                 inline size_t add_symbol(NodeType nodeType, ReturnType returnType, const size_t id) const {
-                    if (auto* unaryNode = dynamic_cast<UnaryNode*>(source)) {
-                        unaryNode->setChild(new SymbolNode(nodeType, returnType, id));
-                        return id;
-                    } else if (auto* binaryNode = dynamic_cast<BinaryNode*>(source)) {
-                        auto* returnNode = new SymbolNode(nodeType, returnType, id);
-                        (!binaryNode->getLeftChild() ? binaryNode->setLeftChild(returnNode) : binaryNode->setRightChild(returnNode));
-                        return id;
-                    }
-                    return std::numeric_limits<size_t>::max();
+                    if (!attach(new SymbolNode(nodeType, returnType, id)).source)
+                        return std::numeric_limits<size_t>::max();
+                    return id;
                 }
 
                 /**
@@ -228,15 +234,7 @@ namespace test {
                  */
                 template<typename T>
                 inline TreeHandle add_const(NodeType nodeType, ReturnType returnType, T value) {
-                    if (auto* unaryNode = dynamic_cast<UnaryNode*>(source)) {
-                        unaryNode->setChild(new ConstantNode<T>(nodeType, returnType, value));
-                        return {unaryNode->getChild(), tableRef, functionRef};
-                    } else if (auto* binaryNode = dynamic_cast<BinaryNode*>(source)) {
-                        auto* returnNode = new ConstantNode<T>(nodeType, returnType, value);
-                        (binaryNode->getLeftChild() ? binaryNode->setRightChild(returnNode) : binaryNode->setLeftChild(returnNode));
-                        return {returnNode, tableRef, functionRef};
-                    }
-                    return {};
+                    return attach(new ConstantNode<T>(nodeType, returnType, value));
                 }
             };
 
@@ -248,26 +246,17 @@ namespace test {
 
             FunctionTreeBuilder(const std::string &name, ReturnType functionType, int line) : FunctionTreeBuilder(std::make_shared<SymbolTable>(), name, functionType, line) {}
             FunctionTreeBuilder(const std::shared_ptr<SymbolTable> &table, const std::string &name, ReturnType functionType, int line)
-                    : table(table), root(nullptr), curStmt(nullptr), funcId(table->addFunction(new Symbol(name, line, functionType, ST_FUNCTION))) {
-                table->addFunction(new Symbol("writeinteger", -1, RT_VOID, ST_FUNCTION), {}, {new Symbol("i", -1, RT_INT, ST_PARAMETER)});
-                table->addFunction(new Symbol("readinteger", -1, RT_INT, ST_FUNCTION));
+                    : table(table), root(std::make_unique<ListNode>(NODE_STATEMENT_LIST, RT_VOID)), funcId(table->addFunction(Symbol(name, line, functionType, ST_FUNCTION))) {
+                table->addSymbol(Symbol("i", -1, RT_INT, ST_PARAMETER), table->addFunction(Symbol("writeinteger", -1, RT_VOID, ST_FUNCTION)));
+                table->addFunction(Symbol("readinteger", -1, RT_INT, ST_FUNCTION));
             }
 
             inline Function build() {
-                curStmt->setRightChild(new Node(NODE_EMPTY, RT_VOID));
                 return Function(std::move(table), std::move(root));
             }
 
             inline TreeHandle add_statement() {
-                if (!root) {
-                    root = std::make_unique<BinaryNode>(NODE_STATEMENT_LIST, RT_VOID);
-                    curStmt = (BinaryNode*) root.get();
-                } else {
-                    auto* newNode = new BinaryNode(NODE_STATEMENT_LIST, RT_VOID);
-                    curStmt->setRightChild(newNode);
-                    curStmt = newNode;
-                }
-                return {curStmt, table.get(), funcId};
+                return {root.get(), table.get(), funcId, root->size()};
             }
 
             inline const std::shared_ptr<SymbolTable>& getTable() const {
@@ -295,8 +284,7 @@ namespace test {
 
             protected:
             std::shared_ptr<SymbolTable> table;
-            std::unique_ptr<Node> root;
-            BinaryNode* curStmt; // points to the last valid statement in the statement list.
+            std::unique_ptr<ListNode> root;
             const size_t funcId;
         };
     }
@@ -313,19 +301,31 @@ namespace test {
             return testing::AssertionFailure() << "Provided node has incorrect nodetype '" << util::to_string(node->getReturnType()) << "' (expected '" << util::to_string(type) << "')";
         }
 
+        // Counts the nodes with return type RT_ERROR. Does not descend into error nodes.
+        struct ErrorCounter : NodeVisitor<ErrorCounter, size_t, const Node> {
+            inline size_t visit_node(const Node* node) {
+                return node->getReturnType() == RT_ERROR ? 1 : 0;
+            }
+
+            inline size_t visit_unary(const UnaryNode* node) {
+                return node->getReturnType() == RT_ERROR ? 1 : dispatch(node->getChild());
+            }
+
+            inline size_t visit_binary(const BinaryNode* node) {
+                return node->getReturnType() == RT_ERROR ? 1 : dispatch(node->getLeftChild()) + dispatch(node->getRightChild());
+            }
+
+            inline size_t visit_list(const ListNode* node) {
+                if (node->getReturnType() == RT_ERROR)
+                    return 1;
+                return std::accumulate(node->getChildren().begin(), node->getChildren().end(), (size_t) 0, [this](size_t sum, const Node* child) {
+                    return sum + dispatch(child);
+                });
+            }
+        };
+
         inline size_t node_num_errors(const Node* node) {
-            if (node == nullptr)
-                return 0;
-            if (node->getReturnType() == RT_ERROR)
-                return 1;
-
-            const auto* binary = dynamic_cast<const BinaryNode*>(node);
-            if (binary != nullptr)
-                return node_num_errors(binary->getLeftChild()) + node_num_errors(binary->getRightChild());
-            const auto* unary = dynamic_cast<const UnaryNode*>(node);
-            if (unary != nullptr)
-                return node_num_errors(unary->getChild());
-            return 0;
+            return ErrorCounter().dispatch(node);
         }
 
         inline size_t tree_num_errors(const SyntaxTree& tree, const SymbolTable& table) {
@@ -339,7 +339,7 @@ namespace test {
         inline testing::AssertionResult const_node(const Node* const node, T expected_value) {
             if (node->getNodeType() != NODE_NUM)
                 return testing::AssertionFailure() << "Provided node has incorrect type '" << util::to_string(node->getNodeType()) << "' (expected '" << util::to_string(NODE_NUM) << "')";
-            const auto* const constnode = dynamic_cast<const ConstantNode<T>* const>(node);
+            const auto* const constnode = node_cast<const ConstantNode<T>>(node);
             if (!constnode) { // We had a casting failure. Is this node a ConstantNode? Did the testcase provide the (exact, no promoting) right type T?
                 return testing::AssertionFailure() << "Could not cast node with type " << util::to_string(node->getReturnType()) << " to ConstantNode of type " << hack::get_name<T>();
             }
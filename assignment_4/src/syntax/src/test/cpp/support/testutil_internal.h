@@ -41,33 +41,24 @@ namespace test {
         namespace variable {
             // Fetches local variables and parameters. Anything 'function-local'.
             inline const Symbol* local_get(const SymbolTable& table, const std::string& func_name, const std::string& var_name) {
-                std::vector<Symbol*> symbols;
-                if (!table.getVariables(test::internal::function::get_id(table, func_name), symbols))
-                    return nullptr;
-                for (const auto* var: symbols)
-                    if (var->getName() == var_name)
-                        return var;
+                for (size_t id: table.getVariables(test::internal::function::get_id(table, func_name)))
+                    if (table.getSymbol(id)->getName() == var_name)
+                        return table.getSymbol(id);
                 return nullptr;
             }
 
             inline const Symbol* parameter_get(const SymbolTable& table, const std::string& func_name, const std::string& var_name) {
-                std::vector<Symbol*> symbols;
-                if (!table.getParameters(test::internal::function::get_id(table, func_name), symbols))
-                    return nullptr;
-                for (const auto* var: symbols)
-                    if (var->getName() == var_name)
-                        return var;
+                for (size_t id: table.getParameters(test::internal::function::get_id(table, func_name)))
+                    if (table.getSymbol(id)->getName() == var_name)
+                        return table.getSymbol(id);
                 return nullptr;
             }
 
             inline const Symbol* global_get(const SymbolTable& table, const std::string& var_name) {
-                auto globals = table.getGlobals();
-                auto found = std::find_if(globals.begin(), globals.end(), [&var_name](const std::pair<size_t, Symbol*>& global) {
-                    return var_name == global.second->getName();
-                });
-                if (found == globals.end())
-                    return nullptr;
-                return found->second;
+                for (size_t id: table.globalIds())
+                    if (table.getSymbol(id)->getName() == var_name)
+                        return table.getSymbol(id);
+                return nullptr;
             }
         }
     }
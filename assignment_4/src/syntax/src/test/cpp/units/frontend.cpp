@@ -0,0 +1,156 @@
+#include "../support/globals.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <ghc/filesystem.h>
+#include <lexical.h>
+#include <logger.h>
+#include <sstream>
+#include <symboltable.h>
+#include <syntax.h>
+#include <syntaxtree.h>
+#include <thread>
+
+/**
+ * Tests to check that the recursive-descent front end builds the same program as the bison front end.
+ * Every C-minus test program is parsed with both (sequentially and in parallel), comparing exit codes, diagnostics counts, symbol tables and syntax trees.
+ */
+
+static ghc::filesystem::path get_project_root() {
+    return ghc::filesystem::absolute(my_argv[0]).parent_path().parent_path().parent_path().parent_path().parent_path().parent_path();
+}
+
+/** Everything a parse produces, printed. */
+struct ParseOutput {
+    int result;
+    uint64_t errors, warnings;
+    std::string table, tree;
+};
+
+/** Parses the file at `path`, or its contents from memory if `in_memory` is set. */
+static ParseOutput parse(const ghc::filesystem::path& path, lexical::Frontend frontend, bool in_memory = false) {
+    std::ostringstream messages;
+    Logger logger(messages, messages, messages);
+    SymbolTable table;
+    SyntaxTree tree;
+    ParseOutput output{};
+    if (in_memory) {
+        std::ifstream file(path.string(), std::ios::binary);
+        const std::string source{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        output.result = syntax::generate(source.data(), source.size(), tree, table, logger, frontend);
+    } else {
+        output.result = syntax::generate(path.string(), tree, table, logger, frontend);
+    }
+    output.errors = logger.n_errors();
+    output.warnings = logger.n_warnings();
+
+    std::ostringstream stream;
+    stream << table;
+    output.table = stream.str();
+    stream.str("");
+    tree.doStream(stream, 4, &table);
+    output.tree = stream.str();
+    return output;
+}
+
+/** Parses `path` `runs` times and returns the average time per parse in milliseconds. */
+static double time_parse(const ghc::filesystem::path& path, lexical::Frontend frontend, int runs) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < runs; ++run) {
+        Logger logger(NULL_STREAM, NULL_STREAM, NULL_STREAM);
+        SymbolTable table;
+        SyntaxTree tree;
+        syntax::generate(path.string(), tree, table, logger, frontend);
+    }
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / runs;
+}
+
+static void expect_same_parse(const ghc::filesystem::path& directory) {
+    ASSERT_TRUE(ghc::filesystem::exists(directory)) << directory;
+    for (const auto& entry : ghc::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".c")
+            continue;
+        SCOPED_TRACE(entry.path().string());
+        const ParseOutput bison = parse(entry.path(), lexical::FRONTEND_BISON);
+        for (lexical::Frontend frontend : {lexical::FRONTEND_DESCENT, lexical::FRONTEND_DESCENT_PARALLEL}) {
+            SCOPED_TRACE(frontend);
+            const ParseOutput descent = parse(entry.path(), frontend);
+            EXPECT_EQ(bison.result, descent.result);
+            EXPECT_EQ(bison.errors, descent.errors);
+            EXPECT_EQ(bison.warnings, descent.warnings);
+            EXPECT_EQ(bison.table, descent.table);
+            EXPECT_EQ(bison.tree, descent.tree);
+        }
+    }
+}
+
+TEST(FrontendTest, general_programs) {
+    expect_same_parse(get_project_root() / "test" / "c-minus");
+}
+
+TEST(FrontendTest, syntax_programs) {
+    expect_same_parse(get_project_root() / "src" / "syntax" / "src" / "test" / "c-minus");
+}
+
+TEST(FrontendTest, in_memory_source) {
+    const auto directory = get_project_root() / "test" / "c-minus";
+    ASSERT_TRUE(ghc::filesystem::exists(directory)) << directory;
+    for (const auto& entry : ghc::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".c")
+            continue;
+        SCOPED_TRACE(entry.path().string());
+        for (lexical::Frontend frontend : {lexical::FRONTEND_BISON, lexical::FRONTEND_DESCENT}) {
+            SCOPED_TRACE(frontend);
+            const ParseOutput file = parse(entry.path(), frontend);
+            const ParseOutput memory = parse(entry.path(), frontend, true);
+            EXPECT_EQ(file.result, memory.result);
+            EXPECT_EQ(file.errors, memory.errors);
+            EXPECT_EQ(file.table, memory.table);
+            EXPECT_EQ(file.tree, memory.tree);
+        }
+    }
+}
+
+TEST(FrontendTest, deep_nesting) {
+    // Far deeper than a parser recursing on the native stack could go: both front ends keep their stacks on the heap.
+    const auto path = ghc::filesystem::temp_directory_path() / "coco_frontend_nesting.c";
+    {
+        std::ofstream source(path.string());
+        source << "void main(void) {\n" << std::string(50000, '(') << '1' << std::string(50000, ')') << ";\n"
+               << std::string(20000, '{') << ';' << std::string(20000, '}') << "\n}\n";
+    }
+    const ParseOutput bison = parse(path, lexical::FRONTEND_BISON);
+    const ParseOutput descent = parse(path, lexical::FRONTEND_DESCENT);
+    ghc::filesystem::remove(path);
+    EXPECT_EQ(bison.result, 0);
+    EXPECT_EQ(descent.result, 0);
+    EXPECT_EQ(bison.errors, descent.errors);
+}
+
+// Throughput benchmark, run with --gtest_also_run_disabled_tests --gtest_filter=FrontendTest.DISABLED_throughput
+TEST(FrontendTest, DISABLED_throughput) {
+    const auto path = ghc::filesystem::temp_directory_path() / "coco_frontend_throughput.c";
+    {
+        std::ofstream source(path.string());
+        for (int function = 0; function < 2000; ++function) {
+            source << "void f" << function << "(void) {\n    void a, b;\n";
+            for (int statement = 0; statement < 50; ++statement)
+                source << "    a = (a + b) * +b == a || b != (a + " << statement << ") && f" << function << "(a, b * " << statement << ");\n";
+            source << "    return;\n}\n";
+        }
+    }
+    const auto bytes = ghc::filesystem::file_size(path);
+    constexpr int runs = 5;
+    const double bison = time_parse(path, lexical::FRONTEND_BISON, runs);
+    const double descent = time_parse(path, lexical::FRONTEND_DESCENT, runs);
+    const double parallel = time_parse(path, lexical::FRONTEND_DESCENT_PARALLEL, runs);
+    ghc::filesystem::remove(path);
+    std::cout << "bison:    " << bison << " ms/parse, " << bytes / bison / 1000.0 << " MB/s" << std::endl;
+    std::cout << "descent:  " << descent << " ms/parse, " << bytes / descent / 1000.0 << " MB/s" << std::endl;
+    std::cout << "parallel: " << parallel << " ms/parse, " << bytes / parallel / 1000.0 << " MB/s, "
+              << std::thread::hardware_concurrency() << " threads" << std::endl;
+}
@@ -91,7 +91,7 @@ TEST_F(NodeTest, if) {
 
     test::build::FunctionTreeBuilder builder("main", RT_INT, 3);
     // Stage 0: Variables
-    auto superglobal_var_id = builder.getTable()->addSymbol(new Symbol("superglobal", 1, RT_INT, ST_VARIABLE), 0 /* means that this var is a global var */);
+    auto superglobal_var_id = builder.getTable()->addSymbol(Symbol("superglobal", 1, RT_INT, ST_VARIABLE), 0 /* means that this var is a global var */);
 
     // Stage 1: The if-statement
     auto if_stmt = builder.add_statement().add_binary(NODE_IF, RT_VOID);
@@ -132,7 +132,7 @@ TEST_F(NodeTest, if_targets) {
 
     test::build::FunctionTreeBuilder builder("main", RT_INT, 3);
     // Stage 0: The variables
-    auto superglobal_var_id = builder.getTable()->addSymbol(new Symbol("superglobal", 1, RT_INT, ST_VARIABLE), 0 /* means that this var is a global var */);
+    auto superglobal_var_id = builder.getTable()->addSymbol(Symbol("superglobal", 1, RT_INT, ST_VARIABLE), 0 /* means that this var is a global var */);
 
     // Stage 1: The if-statement
     auto if_stmt = builder.add_statement().add_binary(NODE_IF, RT_VOID);
@@ -217,7 +217,7 @@ TEST_F(NodeTest, array) {
 
     test::build::FunctionTreeBuilder builder("main", RT_INT, 3);
     // Stage 0: The variables
-    auto superarray_var_id = builder.getTable()->addSymbol(new ArraySymbol("superarray", 1, RT_INT_ARRAY, ST_VARIABLE, /* array size */ 42), 0 /* means that this var is a global var */);
+    auto superarray_var_id = builder.getTable()->addSymbol(ArraySymbol("superarray", 1, RT_INT_ARRAY, ST_VARIABLE, /* array size */ 42), 0 /* means that this var is a global var */);
 
     // Stage 1: The assignment-statement
     auto assignment_stmt = builder.add_statement().add_binary(NODE_ASSIGNMENT, RT_VOID);
@@ -245,7 +245,7 @@ TEST_F(NodeTest, return) {
 
     test::build::FunctionTreeBuilder builder_t1("t1", RT_VOID, 3);
     // Stage 0: The variables
-    auto superglobal_var_id = builder_t1.getTable()->addSymbol(new Symbol("superglobal", 1, RT_INT, ST_VARIABLE), 0 /* means that this var is a global var */);
+    auto superglobal_var_id = builder_t1.getTable()->addSymbol(Symbol("superglobal", 1, RT_INT, ST_VARIABLE), 0 /* means that this var is a global var */);
     // Stage 1: the return statement
     builder_t1.add_statement().add_unary(NODE_RETURN, RT_VOID).add_empty();
 
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <scope.h>
+
+/**
+ * Tests for the scope stack the front end resolves names with.
+ * A function body parsed lazily, after all declarations, must only see the names declared before the function.
+ */
+
+static constexpr size_t UNDECLARED = std::numeric_limits<size_t>::max();
+
+static Atom atom(const char* name) {
+    return Interner::current().intern(name);
+}
+
+TEST(ScopeTest, shadowing) {
+    ScopeStack scopes;
+    ASSERT_TRUE(scopes.addSymbol(atom("x"), 1));
+    EXPECT_FALSE(scopes.addSymbol(atom("x"), 2));
+    scopes.enter();
+    ASSERT_TRUE(scopes.addSymbol(atom("x"), 3));
+    EXPECT_EQ(scopes.getSymbolId("x"), 3u);
+    scopes.exit();
+    EXPECT_EQ(scopes.getSymbolId("x"), 1u);
+    EXPECT_EQ(scopes.depth(), 0u);
+}
+
+TEST(ScopeTest, deferred_body_skips_later_globals) {
+    ScopeStack scopes;
+    // Global `h`, function `f` with its body deferred, then global `g` and a function with a local `h`
+    ASSERT_TRUE(scopes.addSymbol(atom("h"), 1));
+    ASSERT_TRUE(scopes.addSymbol(atom("f"), 2));
+    const size_t mark = scopes.mark();
+    ASSERT_TRUE(scopes.addSymbol(atom("g"), 3));
+    scopes.enter();
+    ASSERT_TRUE(scopes.addSymbol(atom("h"), 4));
+    scopes.exit();
+
+    scopes.rewind(mark);
+    EXPECT_EQ(scopes.getSymbolId("g"), UNDECLARED);
+    EXPECT_EQ(scopes.getSymbolId("f"), 2u);
+    EXPECT_EQ(scopes.getSymbolId("h"), 1u);
+    scopes.enter();
+    ASSERT_TRUE(scopes.addSymbol(atom("p"), 5));
+    // A local may reuse the name of a hidden global.
+    ASSERT_TRUE(scopes.addSymbol(atom("g"), 6));
+    EXPECT_EQ(scopes.getSymbolId("g"), 6u);
+    scopes.restore();
+
+    EXPECT_EQ(scopes.depth(), 0u);
+    EXPECT_EQ(scopes.getSymbolId("p"), UNDECLARED);
+    EXPECT_EQ(scopes.getSymbolId("g"), 3u);
+    EXPECT_FALSE(scopes.addSymbol(atom("g"), 7));
+}
+
+TEST(ScopeTest, resumes_one_after_another) {
+    ScopeStack scopes;
+    ASSERT_TRUE(scopes.addSymbol(atom("a"), 1));
+    const size_t a = scopes.mark();
+    ASSERT_TRUE(scopes.addSymbol(atom("b"), 2));
+    const size_t b = scopes.mark();
+    ASSERT_TRUE(scopes.addSymbol(atom("c"), 3));
+
+    scopes.rewind(a);
+    scopes.enter();
+    ASSERT_TRUE(scopes.addSymbol(atom("x"), 4));
+    EXPECT_EQ(scopes.getSymbolId("b"), UNDECLARED);
+    scopes.restore();
+
+    scopes.rewind(b);
+    scopes.enter();
+    // The parameter of the previous body does not leak into this one.
+    EXPECT_EQ(scopes.getSymbolId("x"), UNDECLARED);
+    EXPECT_EQ(scopes.getSymbolId("b"), 2u);
+    EXPECT_EQ(scopes.getSymbolId("c"), UNDECLARED);
+    scopes.restore();
+
+    EXPECT_EQ(scopes.getSymbolId("a"), 1u);
+    EXPECT_EQ(scopes.getSymbolId("b"), 2u);
+    EXPECT_EQ(scopes.getSymbolId("c"), 3u);
+}
@@ -1,34 +1,325 @@
 #include "node.h"
+#include <algorithm>
 #include <iostream>
+#include <unordered_set>
+#include <utility>
+
+constexpr NodeKind Node::KIND;
+constexpr NodeKind UnaryNode::KIND;
+constexpr NodeKind BinaryNode::KIND;
+constexpr NodeKind ListNode::KIND;
+constexpr NodeKind SymbolNode::KIND;
+
+namespace {
+    // FNV-1a over 64-bit words.
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+    inline uint64_t mix(uint64_t hash, uint64_t word) {
+        return (hash ^ word) * FNV_PRIME;
+    }
+
+    inline uint64_t fingerprint_of(const Node* node) {
+        return node ? node->getFingerprint() : 0;
+    }
+
+    // Weight of the child at `index` in ListNode::children_hash: FNV_PRIME^(index + 1), modulo 2^64.
+    uint64_t list_weight(size_t index) {
+        uint64_t weight = 1, base = FNV_PRIME;
+        for (size_t exponent = index + 1; exponent; exponent >>= 1, base *= base)
+            if (exponent & 1)
+                weight *= base;
+        return weight;
+    }
+
+    template<typename T>
+    inline uint64_t constant_value(const Node* node) {
+        return static_cast<uint64_t>(static_cast<int64_t>(static_cast<const ConstantNode<T>*>(node)->getValue()));
+    }
+
+    // Calls `f` on each child of `node` in order, including missing (nullptr) children.
+    template<typename F>
+    void for_each_child(const Node* node, F f) {
+        switch (node->getKind()) {
+            case NK_UNARY:
+                f(static_cast<const UnaryNode*>(node)->getChild());
+                break;
+            case NK_BINARY:
+                f(static_cast<const BinaryNode*>(node)->getLeftChild());
+                f(static_cast<const BinaryNode*>(node)->getRightChild());
+                break;
+            case NK_LIST:
+                for (const Node* child: static_cast<const ListNode*>(node)->getChildren())
+                    f(child);
+                break;
+            default:
+                break;
+        }
+    }
+}
 
 NodeType Node::getNodeType() const { return nodeType; }
 
 void Node::setNodeType(NodeType type) {
     nodeType = type;
+    changed();
 }
 
 ReturnType Node::getReturnType() const { return returnType; }
 
 void Node::setReturnType(ReturnType type) {
     returnType = type;
+    changed();
+}
+
+uint64_t Node::getFingerprint() const { return fingerprint; }
+
+void Node::changed() {
+    uint64_t hash = mix(mix(14695981039346656037ULL, nodeType), returnType);
+    switch (kind) {
+        case NK_UNARY:
+            hash = mix(hash, fingerprint_of(static_cast<const UnaryNode*>(this)->child));
+            break;
+        case NK_BINARY:
+            hash = mix(hash, fingerprint_of(static_cast<const BinaryNode*>(this)->leftChild));
+            hash = mix(hash, fingerprint_of(static_cast<const BinaryNode*>(this)->rightChild));
+            break;
+        case NK_LIST:
+            hash = mix(hash, static_cast<const ListNode*>(this)->children_hash);
+            break;
+        case NK_CONST_INT8:
+            hash = mix(hash, constant_value<int8_t>(this));
+            break;
+        case NK_CONST_UINT8:
+            hash = mix(hash, constant_value<uint8_t>(this));
+            break;
+        case NK_CONST_INT:
+            hash = mix(hash, constant_value<int>(this));
+            break;
+        case NK_CONST_UNSIGNED:
+            hash = mix(hash, constant_value<unsigned>(this));
+            break;
+        default: // Plain nodes and symbols
+            break;
+    }
+    fingerprint = hash;
+}
+
+void Node::rehash_tree(Node* root) {
+    // Postorder with a heap-allocated work stack, like doStreamTree. Shared nodes are rehashed once.
+    struct Frame {
+        Node* node;
+        bool expanded;
+    };
+    std::vector<Frame> stack;
+    std::unordered_set<const Node*> done;
+    if (root)
+        stack.push_back({root, false});
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        Node* node = frame.node;
+        if (!frame.expanded && !done.insert(node).second) {
+            stack.pop_back();
+            continue;
+        }
+        if (frame.expanded) {
+            stack.pop_back();
+            if (node->kind == NK_LIST) {
+                auto* list = static_cast<ListNode*>(node);
+                list->children_hash = 0;
+                for (size_t x = 0; x < list->children.size(); ++x) {
+                    list->child_hashes[x] = fingerprint_of(list->children[x]);
+                    list->children_hash += list->child_hashes[x] * list_weight(x);
+                }
+            }
+            node->changed();
+            continue;
+        }
+        frame.expanded = true;
+        for_each_child(node, [&stack](const Node* child) {
+            if (child)
+                stack.push_back({const_cast<Node*>(child), false});
+        });
+    }
+}
+
+bool Node::equal_to(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const {
+    return compare_tree(other, ltable, rtable, &Node::equals);
+}
+
+bool Node::similar_to(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const {
+    return compare_tree(other, ltable, rtable, &Node::similar);
+}
+
+bool Node::compare_tree(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable,
+                        bool (Node::*compare)(const Node&, const SymbolTable*, const SymbolTable*) const) const {
+    std::vector<std::pair<const Node*, const Node*>> stack{{this, &other}};
+    std::vector<const Node*> lchildren, rchildren;
+    while (!stack.empty()) {
+        const Node* lhs = stack.back().first;
+        const Node* rhs = stack.back().second;
+        stack.pop_back();
+        if (!lhs || !rhs) {
+            if (lhs != rhs)
+                return false;
+            continue;
+        }
+        if (lhs == rhs && ltable == rtable) // Shared subtree (see SyntaxTree::HashConsing)
+            continue;
+        if (!(lhs->*compare)(*rhs, ltable, rtable))
+            return false;
+        // `compare` checked that `rhs` has the class, and so at least the children, of `lhs`.
+        lchildren.clear();
+        rchildren.clear();
+        for_each_child(lhs, [&](const Node* child) { lchildren.push_back(child); });
+        for_each_child(rhs, [&](const Node* child) { rchildren.push_back(child); });
+        for (size_t x = lchildren.size(); x-- > 0;) // In reverse, to compare in order
+            stack.emplace_back(lchildren[x], rchildren[x]);
+    }
+    return true;
+}
+
+bool Node::similar_to_debug(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable, std::ostream& stream, int indent, int indent_add) const {
+    struct Item {
+        const Node* lhs;
+        const Node* rhs;
+        int indent;
+    };
+    // Depth first, children in order, like doStreamTree: the tree is printed as far as the first difference.
+    std::vector<Item> stack{{this, &other, indent}};
+    std::vector<const Node*> lchildren, rchildren;
+    while (!stack.empty()) {
+        const Item item = stack.back();
+        stack.pop_back();
+        if (!item.lhs || !item.rhs) {
+            if (item.lhs == item.rhs)
+                continue;
+            stream << std::left << std::setw(item.indent) << "" << (item.lhs ? "(not null)" : "(null)")
+                   << " [" << (item.rhs ? "not null" : "null") << "]\n";
+            return false;
+        }
+        if (!item.lhs->similar_debug(*item.rhs, ltable, rtable, stream, item.indent, indent_add))
+            return false;
+        // `similar_debug` checked that `rhs` has the class, and so at least the children, of `lhs`.
+        lchildren.clear();
+        rchildren.clear();
+        for_each_child(item.lhs, [&](const Node* child) { lchildren.push_back(child); });
+        for_each_child(item.rhs, [&](const Node* child) { rchildren.push_back(child); });
+        for (size_t x = lchildren.size(); x-- > 0;)
+            stack.push_back({lchildren[x], rchildren[x], item.indent + indent_add});
+    }
+    return true;
+}
+
+std::ostream& Node::doStreamTree(std::ostream& stream, const Node* root, int indent, int indent_add, const SymbolTable* table) {
+    struct Item {
+        const Node* node;
+        int indent;
+    };
+    std::vector<Item> stack{{root, indent}};
+    std::vector<const Node*> children;
+    while (!stack.empty()) {
+        const Item item = stack.back();
+        stack.pop_back();
+        if (!item.node) {
+            stream << std::setw(item.indent) << "(null)\n";
+            continue;
+        }
+        switch (item.node->getKind()) {
+            case NK_UNARY:
+            case NK_BINARY:
+            case NK_LIST:
+                item.node->Node::doStream(stream, item.indent, indent_add, table);
+                stream << '\n';
+                children.clear();
+                for_each_child(item.node, [&](const Node* child) { children.push_back(child); });
+                for (size_t x = children.size(); x-- > 0;)
+                    stack.push_back({children[x], item.indent + indent_add});
+                break;
+            default:
+                item.node->doStream(stream, item.indent, indent_add, table);
+                break;
+        }
+    }
+    return stream;
+}
+
+void Node::deleteChildren(Node* node) {
+    std::vector<Node*> stack;
+    const auto detach = [&stack](Node* parent) {
+        switch (parent->kind) {
+            case NK_UNARY: {
+                auto* unary = static_cast<UnaryNode*>(parent);
+                stack.push_back(unary->child);
+                unary->child = nullptr;
+                break;
+            }
+            case NK_BINARY: {
+                auto* binary = static_cast<BinaryNode*>(parent);
+                stack.push_back(binary->leftChild);
+                stack.push_back(binary->rightChild);
+                binary->leftChild = binary->rightChild = nullptr;
+                break;
+            }
+            case NK_LIST: {
+                auto* list = static_cast<ListNode*>(parent);
+                stack.insert(stack.end(), list->children.begin(), list->children.end());
+                list->children.clear();
+                break;
+            }
+            default:
+                break;
+        }
+    };
+    detach(node);
+    while (!stack.empty()) {
+        Node* child = stack.back();
+        stack.pop_back();
+        if (!child)
+            continue;
+        detach(child);
+        delete child; // Has no children left, so its destructor does not recurse
+    }
 }
 
 Node* UnaryNode::getChild() const { return child; }
 
 void UnaryNode::setChild(Node* childNode) {
     child = childNode;
+    changed();
 }
 
 Node* BinaryNode::getLeftChild() const { return leftChild; }
 
 void BinaryNode::setLeftChild(Node* childNode) {
     leftChild = childNode;
+    changed();
 }
 
 Node* BinaryNode::getRightChild() const { return rightChild; }
 
 void BinaryNode::setRightChild(Node* childNode) {
     rightChild = childNode;
+    changed();
+}
+
+const ListNode::Children& ListNode::getChildren() const { return children; }
+
+size_t ListNode::size() const { return children.size(); }
+
+Node* ListNode::getChild(size_t index) const { return children[index]; }
+
+void ListNode::addChild(Node* node) {
+    child_hashes.push_back(fingerprint_of(node));
+    children_hash += child_hashes.back() * list_weight(children.size());
+    children.push_back(node);
+    changed();
+}
+
+void ListNode::setChild(size_t index, Node* node) {
+    const uint64_t hash = fingerprint_of(node);
+    children_hash += (hash - child_hashes[index]) * list_weight(index);
+    child_hashes[index] = hash;
+    children[index] = node;
+    changed();
 }
 
 size_t SymbolNode::getSymbolId() const { return sym_id; }
@@ -52,13 +343,14 @@ std::ostream& SymbolNode::doStream(std::ostream& stream, int indent, int indent_
 }
 
 bool SymbolNode::equals(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const {
-    if (const auto* symbolNode = dynamic_cast<const SymbolNode*>(&other))
-        return this->Node::equals(other, ltable, rtable) && (!ltable || !rtable || ltable->getSymbol(sym_id)->equal_to(*(rtable->getSymbol(symbolNode->sym_id))));
+    if (const auto* symbolNode = node_cast<const SymbolNode>(&other))
+        // Within one table, a symbol is its id: two symbols may look alike, but still be different variables.
+        return this->Node::equals(other, ltable, rtable) && (!ltable || !rtable || (ltable == rtable ? sym_id == symbolNode->sym_id : ltable->getSymbol(sym_id)->equal_to(*(rtable->getSymbol(symbolNode->sym_id)))));
     return false;
 }
 
 bool SymbolNode::similar(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const {
-    if (const auto* symbolNode = dynamic_cast<const SymbolNode*>(&other))
+    if (const auto* symbolNode = node_cast<const SymbolNode>(&other))
         return this->Node::similar(other, ltable, rtable) && (!ltable || !rtable || ltable->getSymbol(sym_id)->similar_to(*(rtable->getSymbol(symbolNode->sym_id))));
     return false;
 }
@@ -68,7 +360,7 @@ inline bool SymbolNode::similar_debug(const Node& other, const SymbolTable* ltab
 
     if (!this->similar(other, ltable, rtable)) {
         stream << " [";
-        if (const auto* symbolNode = dynamic_cast<const SymbolNode*>(&other))
+        if (const auto* symbolNode = node_cast<const SymbolNode>(&other))
             doStreamInternal(stream, 0, 0, rtable, symbolNode, /*newlines=*/false);
         else
             other.Node::doStream(stream, 0, 0, rtable);
@@ -92,6 +384,10 @@ namespace util {
     std::string to_string<const BinaryNode&>(const BinaryNode& object) {
         return "[BinaryNode] " + util::to_string(object.getReturnType()) + " " + util::to_string(object.getNodeType());
     }
+    template<>
+    std::string to_string<const ListNode&>(const ListNode& object) {
+        return "[ListNode] " + util::to_string(object.getReturnType()) + " " + util::to_string(object.getNodeType()) + " children: " + std::to_string(object.size());
+    }
     template<typename T, const ConstantNode<T>&>
     std::string to_string(const ConstantNode<T>& object) {
         return "[ConstantNode] " + util::to_string(object.getReturnType()) + " " + util::to_string(object.getNodeType()) + " val: " + object.getValue();
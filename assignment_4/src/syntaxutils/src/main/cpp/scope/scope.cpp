@@ -2,15 +2,103 @@
 #include <limits>
 #include <iostream>
 
-bool Scope::addSymbol(const std::string& name, size_t sym_id) {
+bool Scope::addSymbol(Atom name, size_t sym_id) {
     return symbols.insert({name, sym_id}).second;
 }
 
-size_t Scope::getSymbolId(const std::string& sym_name) {
+bool Scope::addSymbol(const std::string& name, size_t sym_id) {
+    return addSymbol(Interner::current().intern(name), sym_id);
+}
+
+size_t Scope::getSymbolId(Atom sym_name) {
     auto item = symbols.find(sym_name);
     if (item == symbols.end())
         return std::numeric_limits<size_t>::max();
     return (*item).second;
 }
 
+size_t Scope::getSymbolId(const std::string& sym_name) {
+    // Names that were never interned cannot be in any scope.
+    Atom atom = Interner::current().find(sym_name);
+    if (atom == Interner::NONE)
+        return std::numeric_limits<size_t>::max();
+    return getSymbolId(atom);
+}
+
 size_t Scope::getNumberOfSymbols() const { return symbols.size(); }
+
+
+void ScopeStack::enter() {
+    ++current_depth;
+}
+
+void ScopeStack::exit() {
+    if (current_depth == 0)
+        return;
+    while (!log.empty() && log.back().depth == current_depth)
+        pop();
+    --current_depth;
+}
+
+void ScopeStack::pop() {
+    const Declaration& declaration = log.back();
+    if (declaration.shadowed == NONE)
+        visible.erase(declaration.name);
+    else
+        visible[declaration.name] = declaration.shadowed;
+    log.pop_back();
+}
+
+size_t ScopeStack::depth() const { return current_depth; }
+
+bool ScopeStack::addSymbol(Atom name, size_t sym_id) {
+    const auto index = static_cast<uint32_t>(log.size());
+    auto inserted = visible.insert({name, index});
+    uint32_t shadowed = NONE;
+    if (!inserted.second) {
+        if (log[inserted.first->second].depth == current_depth)
+            return false;
+        shadowed = inserted.first->second;
+        inserted.first->second = index;
+    }
+    log.push_back({name, current_depth, shadowed, sym_id});
+    return true;
+}
+
+size_t ScopeStack::getSymbolId(Atom sym_name) const {
+    auto item = visible.find(sym_name);
+    if (item == visible.end())
+        return std::numeric_limits<size_t>::max();
+    return log[item->second].sym_id;
+}
+
+size_t ScopeStack::getSymbolId(const std::string& sym_name) const {
+    Atom atom = Interner::current().find(sym_name);
+    if (atom == Interner::NONE)
+        return std::numeric_limits<size_t>::max();
+    return getSymbolId(atom);
+}
+
+size_t ScopeStack::mark() const { return log.size(); }
+
+void ScopeStack::rewind(size_t mark) {
+    hidden.clear();
+    while (log.size() > mark) {
+        hidden.push_back(log.back());
+        pop();
+    }
+    rewound_depth = current_depth;
+}
+
+void ScopeStack::restore() {
+    while (current_depth > rewound_depth)
+        exit();
+    for (; !hidden.empty(); hidden.pop_back()) {
+        Declaration declaration = hidden.back();
+        const auto index = static_cast<uint32_t>(log.size());
+        auto inserted = visible.insert({declaration.name, index});
+        declaration.shadowed = inserted.second ? NONE : inserted.first->second;
+        inserted.first->second = index;
+        log.push_back(declaration);
+    }
+}
@@ -3,9 +3,15 @@
 #include "symbol.h"
 
 const std::string& Symbol::getName() const {
-    return name;
+    return Interner::current().str(name);
 }
 void Symbol::setName(const std::string& newName) {
+    Symbol::name = Interner::current().intern(newName);
+}
+Atom Symbol::getNameAtom() const {
+    return name;
+}
+void Symbol::setName(Atom newName) {
     Symbol::name = newName;
 }
 int Symbol::getLine() const {
@@ -27,10 +33,18 @@ void Symbol::setSymbolType(SymbolType newSymbolType) {
     Symbol::symbolType = newSymbolType;
 }
 
-ssize_t ArraySymbol::getSize() const {
+bool Symbol::isArray() const {
+    return types::isArray(returnType);
+}
+
+ssize_t Symbol::getSize() const {
     return size;
 }
 
-void ArraySymbol::setSize(ssize_t new_value) {
+void Symbol::setSize(ssize_t new_value) {
     size = new_value;
 }
+
+ssize_t ArraySymbol::getSize() const {
+    return Symbol::getSize();
+}
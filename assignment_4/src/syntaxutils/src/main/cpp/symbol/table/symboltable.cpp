@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "scope.h"
@@ -6,84 +8,157 @@
 
 #include "symboltable.h"
 
-SymbolTable::~SymbolTable() {
-    for (auto& symbol: symbols)
-        delete symbol.second.symbol;
+namespace {
+    // Frees a symbol passed by pointer, once the table has copied it. Symbols in an arena are freed in bulk by their arena.
+    void release(Symbol* symbol) {
+        if (!ArenaAllocated::in_arena(symbol))
+            delete symbol;
+    }
+}
+
+SymbolTable::~SymbolTable() = default;
+
+size_t SymbolTable::addSymbol(const Symbol& symbol, size_t function) {
+    if (function != 0 && !this->function(function))
+        return std::numeric_limits<size_t>::max();
+    const auto id = static_cast<uint32_t>(symbols.size());
+    SymbolInfo info;
+    info.func_id = static_cast<uint32_t>(function);
+    symbols.push_back(info);
+    store(symbol);
+    if (function == 0) {
+        append(globals, id);
+    } else {
+        FunctionInfo& func = functions[symbols[function].function];
+        append(symbol.getSymbolType() == ST_PARAMETER ? func.parameters : func.variables, id);
+    }
+    return id;
+}
+
+size_t SymbolTable::addSymbol(std::unique_ptr<Symbol> symbol, size_t function) {
+    return addSymbol(*symbol, function);
 }
 
 size_t SymbolTable::addSymbol(Symbol* symbol, size_t function) {
-    // TODO: implement me
-    return std::numeric_limits<size_t>::max();
+    const size_t id = addSymbol(*symbol, function);
+    if (id != std::numeric_limits<size_t>::max())
+        release(symbol);
+    return id;
+}
+
+size_t SymbolTable::addFunction(const Symbol& symbol) {
+    const auto id = static_cast<uint32_t>(symbols.size());
+    SymbolInfo info;
+    info.function = static_cast<uint32_t>(functions.size());
+    symbols.push_back(info);
+    store(symbol);
+    FunctionInfo func;
+    func.id = id;
+    functions.push_back(func);
+    return id;
+}
+
+size_t SymbolTable::addFunction(std::unique_ptr<Symbol> symbol) {
+    return addFunction(*symbol);
 }
 
 size_t SymbolTable::addFunction(Symbol* symbol, const std::vector<Symbol*> &variables, const std::vector<Symbol*> &parameters) {
-    // TODO: implement me
-    return std::numeric_limits<size_t>::max();
+    const size_t id = addFunction(*symbol);
+    release(symbol);
+    for (Symbol* parameter: parameters)
+        if (addSymbol(*parameter, id) != std::numeric_limits<size_t>::max())
+            release(parameter);
+    for (Symbol* variable: variables)
+        if (addSymbol(*variable, id) != std::numeric_limits<size_t>::max())
+            release(variable);
+    return id;
 }
 
 Symbol* SymbolTable::getSymbol(size_t id) const {
-    auto item = symbols.find(id);
-    if (item == symbols.end())
+    if (id == 0 || id >= symbols.size())
         return nullptr;
-    return item->second.symbol;
+    return &values[id];
+}
+
+SymbolTable::Ids SymbolTable::globalIds() const {
+    return view(globals);
 }
 
-std::unordered_map<size_t, Symbol*>  SymbolTable::getGlobals() const {
-    //TODO: implement me
-    std::unordered_map<size_t, Symbol*> globals;
-    return globals;
+std::unordered_map<size_t, Symbol*> SymbolTable::getGlobals() const {
+    std::unordered_map<size_t, Symbol*> map;
+    for (const size_t id: globalIds())
+        map.emplace(id, getSymbol(id));
+    return map;
 }
 
 bool SymbolTable::isGlobal(size_t id) const {
-    auto it = symbols.find(id);
-    if (it == symbols.end())
+    if (id == 0 || id >= symbols.size())
         return false;
-    return it->second.func_id == 0;
+    return symbols[id].func_id == 0;
+}
+
+SymbolTable::Ids SymbolTable::getVariables(size_t func_id) const {
+    const FunctionInfo* func = function(func_id);
+    return func ? view(func->variables) : Ids();
+}
+
+SymbolTable::Ids SymbolTable::getParameters(size_t func_id) const {
+    const FunctionInfo* func = function(func_id);
+    return func ? view(func->parameters) : Ids();
 }
 
 bool SymbolTable::getVariables(size_t func_id, std::vector<size_t>& variables) const {
-    auto item = functions.find(func_id);
-    if (item == functions.end())
+    if (!function(func_id))
         return false;
-    variables = item->second.variables;
+    const Ids ids = getVariables(func_id);
+    variables.assign(ids.begin(), ids.end());
     return true;
 }
 
 bool SymbolTable::getVariables(size_t func_id, std::vector<Symbol*>& variables) const {
-    std::vector<size_t> ids;
-    if (!getVariables(func_id, ids))
+    if (!function(func_id))
         return false;
-
-    for (size_t id: ids) {
-        auto element = symbols.find(id);
-        if (element == symbols.end())
-            return false;
-        variables.push_back(element->second.symbol);
-    }
+    for (size_t id: getVariables(func_id))
+        variables.push_back(&values[id]);
     return true;
 }
 
 bool SymbolTable::getParameters(size_t func_id, std::vector<size_t>& parameters) const {
-    auto item = functions.find(func_id);
-    if (item == functions.end())
+    if (!function(func_id))
         return false;
-    parameters = item->second.parameters;
+    const Ids ids = getParameters(func_id);
+    parameters.assign(ids.begin(), ids.end());
     return true;
 }
 
 bool SymbolTable::getParameters(size_t func_id, std::vector<Symbol*>& parameters) const {
-    std::vector<size_t> ids;
-    if (!getParameters(func_id, ids))
+    if (!function(func_id))
         return false;
-    for (size_t id: ids) {
-        auto element = symbols.find(id);
-        if (element == symbols.end())
-            return false;
-        parameters.push_back(element->second.symbol);
-    }
+    for (size_t id: getParameters(func_id))
+        parameters.push_back(&values[id]);
     return true;
 }
 
+void SymbolTable::clear() {
+    symbols.resize(1);
+    // `values` keeps its symbols, to be overwritten by those of the next program: the deque keeps its blocks.
+    functions.clear();
+    globals = Members();
+    members.clear();
+}
+
+size_t SymbolTable::capacity() const {
+    return std::min(symbols.capacity(), values.size());
+}
+
+void SymbolTable::store(const Symbol& symbol) {
+    const size_t id = symbols.size() - 1;
+    if (id < values.size())
+        values[id] = symbol;
+    else
+        values.push_back(symbol);
+}
+
 size_t SymbolTable::addTempvar(ReturnType rt, const std::string& name, size_t func_id) {
     return addSymbol(ST_TEMPVAR, rt, name, func_id);
 }
@@ -93,13 +168,40 @@ size_t SymbolTable::addLabel(ReturnType rt, const std::string& name, size_t func
 }
 
 size_t SymbolTable::addSymbol(SymbolType st, ReturnType rt, const std::string& name, size_t func_id) {
-    //TODO: implement me
-    return std::numeric_limits<size_t>::max();
+    return addSymbol(Symbol(name, -1, rt, st), func_id);
 }
+
 std::vector<size_t> SymbolTable::getFunctions() const {
     std::vector<size_t> keys;
-    for (auto& func: functions) {
-        keys.push_back(func.first);
+    keys.reserve(functions.size());
+    for (const auto& func: functions) {
+        keys.push_back(func.id);
     }
     return keys;
-}
\ No newline at end of file
+}
+
+void SymbolTable::append(Members& list, uint32_t id) {
+    if (list.size == list.capacity) {
+        if (list.begin + list.size == members.size()) {
+            // Last list in storage: grow in place.
+            members.push_back(id);
+            ++list.size;
+            list.capacity = list.size;
+            return;
+        }
+        // Move to the end, with room to grow.
+        const auto begin = static_cast<uint32_t>(members.size());
+        const uint32_t capacity = std::max<uint32_t>(4, 2 * list.size);
+        members.resize(members.size() + capacity);
+        std::copy(members.begin() + list.begin, members.begin() + list.begin + list.size, members.begin() + begin);
+        list.begin = begin;
+        list.capacity = capacity;
+    }
+    members[list.begin + list.size++] = id;
+}
+
+const SymbolTable::FunctionInfo* SymbolTable::function(size_t func_id) const {
+    if (func_id >= symbols.size() || symbols[func_id].function == NO_FUNCTION)
+        return nullptr;
+    return &functions[symbols[func_id].function];
+}
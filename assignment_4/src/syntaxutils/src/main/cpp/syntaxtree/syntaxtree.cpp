@@ -2,10 +2,92 @@
 #include <to_string.h>
 #include "syntaxtree.h"
 
+namespace {
+    thread_local SyntaxTree::HashConsing* current_consing = nullptr;
+
+    // Whether expressions of this type have no side effects of their own (unlike function calls and assignments).
+    bool shareable(NodeType nodeType) {
+        switch (nodeType) {
+            case NODE_RARRAY:
+            case NODE_REL_EQUAL:
+            case NODE_REL_LT:
+            case NODE_REL_GT:
+            case NODE_REL_LTE:
+            case NODE_REL_GTE:
+            case NODE_REL_NOTEQUAL:
+            case NODE_ADD:
+            case NODE_SUB:
+            case NODE_OR:
+            case NODE_MUL:
+            case NODE_DIV:
+            case NODE_IDIV:
+            case NODE_MOD:
+            case NODE_AND:
+            case NODE_NUM:
+            case NODE_ID:
+            case NODE_NOT:
+            case NODE_SIGNPLUS:
+            case NODE_SIGNMINUS:
+            case NODE_COERCION:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+SyntaxTree::HashConsing::HashConsing() : previous(current_consing) {
+    current_consing = this;
+}
+
+SyntaxTree::HashConsing::~HashConsing() {
+    current_consing = previous;
+}
+
+bool SyntaxTree::HashConsing::Shape::operator==(const Shape& other) const {
+    return kind == other.kind && nodeType == other.nodeType && returnType == other.returnType && value == other.value
+        && left == other.left && right == other.right;
+}
+
+size_t SyntaxTree::HashConsing::ShapeHash::operator()(const Shape& shape) const {
+    // FNV-1a over the fields
+    uint64_t hash = 14695981039346656037ULL;
+    for (uint64_t word: {static_cast<uint64_t>(shape.kind), static_cast<uint64_t>(shape.nodeType), static_cast<uint64_t>(shape.returnType),
+                         shape.value, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(shape.left)), static_cast<uint64_t>(reinterpret_cast<uintptr_t>(shape.right))})
+        hash = (hash ^ word) * 1099511628211ULL;
+    return static_cast<size_t>(hash);
+}
+
+Node* SyntaxTree::find_shared(const HashConsing::Shape& shape) {
+    if (!current_consing)
+        return nullptr;
+    auto it = current_consing->nodes.find(shape);
+    return it == current_consing->nodes.end() ? nullptr : it->second;
+}
+
+Node* SyntaxTree::share(const HashConsing::Shape& shape, Node* node) {
+    HashConsing* consing = current_consing;
+    if (!consing || !ArenaAllocated::in_arena(node) || !shareable(shape.nodeType))
+        return node;
+    // A parent of an unshared child (e.g. a function call) has side effects, or a child that may change.
+    if ((shape.left && !consing->shared.count(shape.left)) || (shape.right && !consing->shared.count(shape.right)))
+        return node;
+    consing->nodes.emplace(shape, node);
+    consing->shared.insert(node);
+    return node;
+}
+
 SyntaxTree::~SyntaxTree() {
+    clear();
+}
+
+void SyntaxTree::clear() {
+    // Trees in an arena are freed in bulk by their arena. Nodes own nothing else, so they need no destruction.
     for (auto& func: functions) {
-        delete func.second.root;
+        if (!ArenaAllocated::in_arena(func.second.root))
+            delete func.second.root;
     }
+    functions.clear();
 }
 
 Node* SyntaxTree::getRoot(size_t id) const {
@@ -16,18 +98,33 @@ Node* SyntaxTree::getRoot(size_t id) const {
 }
 
 Node* SyntaxTree::createParentNode(NodeType nodeType, ReturnType returnType, Node* child) {
-    //TODO: implement me
-    return nullptr;
+    const HashConsing::Shape shape{UnaryNode::KIND, nodeType, returnType, 0, child, nullptr};
+    if (Node* node = find_shared(shape))
+        return node;
+    auto* node = new UnaryNode(nodeType, returnType);
+    node->setChild(child);
+    return share(shape, node);
 }
 
 Node* SyntaxTree::createParentNode(NodeType nodeType, ReturnType ret, Node* leftChild, Node* rightChild) {
-    //TODO: implement me
-    return nullptr;
+    const HashConsing::Shape shape{BinaryNode::KIND, nodeType, ret, 0, leftChild, rightChild};
+    if (Node* node = find_shared(shape))
+        return node;
+    auto* node = new BinaryNode(nodeType, ret);
+    node->setLeftChild(leftChild);
+    node->setRightChild(rightChild);
+    return share(shape, node);
 }
 
 Node* SyntaxTree::createIdNode(size_t id, ReturnType rt) {
-    //TODO: implement me
-    return nullptr;
+    const HashConsing::Shape shape{SymbolNode::KIND, NODE_ID, rt, id, nullptr, nullptr};
+    if (Node* node = find_shared(shape))
+        return node;
+    return share(shape, new SymbolNode(NODE_ID, rt, id));
+}
+
+ListNode* SyntaxTree::createListNode(NodeType nodeType) {
+    return new ListNode(nodeType, RT_VOID);
 }
 
 Node* SyntaxTree::createLeaf() {
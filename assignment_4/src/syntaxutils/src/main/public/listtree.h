@@ -13,15 +13,15 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 
 #include "node.h"
 
+// Holds a list (NODE_STATEMENT_LIST or NODE_EXPRLIST) while the parser builds it.
 struct ListTree {
-    Node* root = nullptr;
-    Node* current = nullptr;
+    // The list built so far, or `nullptr` before the first element is added.
+    ListNode* root = nullptr;
 
-    ListTree(Node* root, Node* current) : root(root), current(current){};
+    explicit ListTree(ListNode* root) : root(root){};
     ListTree() = default;
     ~ListTree() {
         root = nullptr;
-        current = nullptr;
     };
 };
 
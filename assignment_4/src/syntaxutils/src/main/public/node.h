@@ -11,27 +11,50 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #ifndef COCO_FRAMEWORK_SYNTAXUTILS_NODE
 #define COCO_FRAMEWORK_SYNTAXUTILS_NODE
 
+#include <cassert>
+#include <cstdint>
 #include <limits>
 #include <functional>
 #include <typeinfo>
+#include <type_traits>
+#include <vector>
 
 #include "symbol.h"
 #include "symboltable.h"
 #include "types.h"
 
+#include <arena.h>
 #include <to_string.h>
 #include <hacks/template_hacks.h>
 
 
 class SymbolTable;
 
-class Node {
+// The concrete class of a node. Lets us dispatch on nodes with a switch instead of RTTI.
+enum NodeKind : uint8_t {
+    NK_NODE,           // Node
+    NK_UNARY,          // UnaryNode
+    NK_BINARY,         // BinaryNode
+    NK_LIST,           // ListNode
+    NK_SYMBOL,         // SymbolNode
+    NK_CONST_INT8,     // ConstantNode<int8_t>
+    NK_CONST_UINT8,    // ConstantNode<uint8_t>
+    NK_CONST_INT,      // ConstantNode<int>
+    NK_CONST_UNSIGNED, // ConstantNode<unsigned>
+};
+
+// Nodes are created in the current arena, if there is one.
+class Node : public ArenaAllocated {
     public:
-    Node() : nodeType(NODE_UNKNOWN), returnType(RT_UNKNOWN) {}
-    Node(NodeType nodeType, ReturnType returnType) : nodeType(nodeType), returnType(returnType) {}
+    static constexpr NodeKind KIND = NK_NODE;
+
+    Node() : Node(NODE_UNKNOWN, RT_UNKNOWN) {}
+    Node(NodeType nodeType, ReturnType returnType) : Node(NK_NODE, nodeType, returnType) { changed(); }
 
     virtual ~Node() = default;
 
+    NodeKind getKind() const { return kind; }
+
     NodeType getNodeType() const;
     void setNodeType(NodeType nodeType);
 
@@ -61,6 +84,20 @@ class Node {
         return equal_to(other, nullptr, nullptr);
     }
 
+    /**
+     * Structural fingerprint of the subtree: a hash of the node types, return types, constant values and child fingerprints
+     * in it. Symbols are left out, as comparisons look at them through the symbol tables.
+     * Equal (and similar) subtrees of the same node class have equal fingerprints.
+     * The fingerprint is computed when the node is created or changed, from the fingerprints its children have then:
+     * build and change trees bottom-up, and set a changed node on its parent again (or use `rehash_tree`).
+     * A node cannot reach its parents, so fingerprints may be stale: they pick candidates (e.g. for hash-consing), and
+     * `equal_to`/`similar_to` never rely on them.
+     */
+    uint64_t getFingerprint() const;
+
+    // Recomputes the fingerprints in the subtree of `root`, children first. For trees built top-down.
+    static void rehash_tree(Node* root);
+
     /**
      * Checks equivalence with `other`.
      * @param other Node to compare with.
@@ -69,9 +106,7 @@ class Node {
      * @note If any of ltable, rtable is a `nullptr`, does not compare symbols.
      * @return `true` iff equal, `false` otherwise.
      */
-    inline bool equal_to(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const {
-        return equals(other, ltable, rtable);
-    }
+    bool equal_to(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const;
 
     /**
      * Checks similarity with `other`.
@@ -87,9 +122,7 @@ class Node {
      *
      * @note When calling this function from testing code, `this` and `ltable` are the reference trees. `other` and `rtable` are student output tree and table.
      */
-    inline bool similar_to(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const {
-        return similar(other, ltable, rtable);
-    }
+    bool similar_to(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const;
 
     /**
      * Exactly like `similar_to(const Node&, const SymbolTable*, const SymbolTable*)`,
@@ -101,11 +134,24 @@ class Node {
      *
      * @note When calling this function from testing code, `this` and `ltable` are the reference trees. `other` and `rtable` are student output tree and table.
      */
-    inline bool similar_to_debug(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable, std::ostream& stream, int indent, int indent_add) const {
-        return similar_debug(other, ltable, rtable, stream, indent, indent_add);
-    }
+    bool similar_to_debug(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable, std::ostream& stream, int indent, int indent_add) const;
 
     protected:
+    Node(NodeKind kind, NodeType nodeType, ReturnType returnType) : nodeType(nodeType), returnType(returnType), kind(kind) {}
+
+    // Recomputes the fingerprint from this node and its children. Every constructor of a node class and every setter calls this.
+    void changed();
+
+    // Streams the subtree of `root` like doStream, with a heap-allocated work stack instead of recursion: trees may nest
+    // deeper than the native stack allows.
+    static std::ostream& doStreamTree(std::ostream& stream, const Node* root, int indent, int indent_add, const SymbolTable* table);
+
+    // Deletes the descendants of `node`, and detaches them. Iterative, like doStreamTree. Used by the destructors.
+    static void deleteChildren(Node* node);
+
+    // `equals`, `similar` and `similar_debug` compare this node with `other`, but not their children: equal_to, similar_to
+    // and similar_to_debug walk those. `similar_debug` also prints this node, and `other` if they are not similar.
+
     inline virtual bool equals(const Node& other, const SymbolTable* /*ltable*/, const SymbolTable* /*rtable*/) const {
         return nodeType == other.nodeType && returnType == other.returnType;
     }
@@ -119,16 +165,51 @@ class Node {
     }
 
     private:
+    // Compares the subtrees with `compare` (equals or similar) on every pair of nodes, with a heap-allocated work stack.
+    bool compare_tree(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable,
+                      bool (Node::*compare)(const Node&, const SymbolTable*, const SymbolTable*) const) const;
+
     NodeType nodeType;
     ReturnType returnType;
+    NodeKind kind;
+    uint64_t fingerprint = 0;
 };
 
+/**
+ * Casts `node` to node class `T` (`T` may be const-qualified).
+ * @return the cast node, or `nullptr` if `node` is `nullptr` or not a `T`.
+ */
+template<typename T>
+inline T* node_cast(Node* node) {
+    return node && node->getKind() == std::remove_const<T>::type::KIND ? static_cast<T*>(node) : nullptr;
+}
+
+template<typename T>
+inline const T* node_cast(const Node* node) {
+    return node && node->getKind() == std::remove_const<T>::type::KIND ? static_cast<const T*>(node) : nullptr;
+}
+
+// Casts `node` to node class `T`, which the caller knows it is (e.g. from its NodeType).
+template<typename T>
+inline T* node_as(Node* node) {
+    assert(node && node->getKind() == std::remove_const<T>::type::KIND);
+    return static_cast<T*>(node);
+}
+
+template<typename T>
+inline const T* node_as(const Node* node) {
+    assert(node && node->getKind() == std::remove_const<T>::type::KIND);
+    return static_cast<const T*>(node);
+}
+
 class UnaryNode : public Node {
     public:
-    UnaryNode() : child(nullptr) {}
-    UnaryNode(NodeType nodeType, ReturnType returnType) : Node(nodeType, returnType), child(nullptr) {}
+    static constexpr NodeKind KIND = NK_UNARY;
+
+    UnaryNode() : UnaryNode(NODE_UNKNOWN, RT_UNKNOWN) {}
+    UnaryNode(NodeType nodeType, ReturnType returnType) : Node(NK_UNARY, nodeType, returnType), child(nullptr) { changed(); }
 
-    ~UnaryNode() override { delete child; };
+    ~UnaryNode() override { deleteChildren(this); };
 
     Node* getChild() const;
     void setChild(Node* node);
@@ -142,27 +223,16 @@ class UnaryNode : public Node {
     }
 
     inline std::ostream& doStream(std::ostream& stream, int indent, int indent_add, const SymbolTable* table) const override {
-        Node::doStream(stream, indent, indent_add, table);
-        stream << '\n';
-        if (child)
-            child->doStream(stream, indent + indent_add, indent_add, table);
-        else
-            stream << std::setw(indent + indent_add) << "(null)\n";
-        return stream;
+        return doStreamTree(stream, this, indent, indent_add, table);
     }
 
     protected:
     inline bool equals(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
-        if (const auto* unaryNode = dynamic_cast<const UnaryNode*>(&other))
-            return this->Node::equals(other, ltable, rtable) && child->equal_to(*unaryNode->child, ltable, rtable);
-        return false;
-
+        return node_cast<const UnaryNode>(&other) && this->Node::equals(other, ltable, rtable);
     }
 
     inline bool similar(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
-        if (const auto* unaryNode = dynamic_cast<const UnaryNode*>(&other))
-            return this->Node::similar(other, ltable, rtable) && child->similar_to(*unaryNode->child, ltable, rtable);
-        return false;
+        return node_cast<const UnaryNode>(&other) && this->Node::similar(other, ltable, rtable);
     }
 
     inline bool similar_debug(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable, std::ostream& stream, int indent, int indent_add) const override {
@@ -175,23 +245,22 @@ class UnaryNode : public Node {
             return false;
         }
         stream << "\n";
-        if (const auto* unaryNode = dynamic_cast<const UnaryNode*>(&other))
-            return this->Node::similar_debug(other, ltable, rtable, stream, indent, indent_add) && child->similar_to_debug(*unaryNode->child, ltable, rtable, stream, indent+indent_add, indent_add);
-       return false;
+        return node_cast<const UnaryNode>(&other) != nullptr;
     }
 private:
+    friend class Node;
+
     Node* child;
 };
 
 class BinaryNode : public Node {
     public:
-    BinaryNode() : Node(), leftChild(nullptr), rightChild(nullptr) {}
-    BinaryNode(NodeType nodeType, ReturnType returnType) : Node(nodeType, returnType), leftChild(nullptr), rightChild(nullptr) {}
+    static constexpr NodeKind KIND = NK_BINARY;
 
-    ~BinaryNode() override {
-        delete leftChild;
-        delete rightChild;
-    };
+    BinaryNode() : BinaryNode(NODE_UNKNOWN, RT_UNKNOWN) {}
+    BinaryNode(NodeType nodeType, ReturnType returnType) : Node(NK_BINARY, nodeType, returnType), leftChild(nullptr), rightChild(nullptr) { changed(); }
+
+    ~BinaryNode() override { deleteChildren(this); };
 
     Node* getLeftChild() const;
     void setLeftChild(Node* node);
@@ -208,33 +277,16 @@ class BinaryNode : public Node {
     }
 
     inline std::ostream& doStream(std::ostream& stream, int indent, int indent_add, const SymbolTable* table) const override {
-        Node::doStream(stream, indent, indent_add, table);
-        stream << '\n';
-        if (leftChild)
-            leftChild->doStream(stream, indent + indent_add, indent_add, table);
-        else
-            stream << std::setw(indent + indent_add) << "(null)\n";
-
-        if (rightChild)
-            rightChild->doStream(stream, indent + indent_add, indent_add, table);
-        else
-            stream << std::setw(indent + indent_add) << "(null)\n";
-        return stream;
+        return doStreamTree(stream, this, indent, indent_add, table);
     }
 
     protected:
     inline bool equals(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
-        if (const auto* binaryNode = dynamic_cast<const BinaryNode*>(&other))
-            return this->Node::equals(other, ltable, rtable) && leftChild->equal_to(*binaryNode->leftChild, ltable, rtable) && rightChild->equal_to(*binaryNode->rightChild, ltable, rtable);
-        return false;
+        return node_cast<const BinaryNode>(&other) && this->Node::equals(other, ltable, rtable);
     }
 
     inline bool similar(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
-        if (const auto* binaryNode = dynamic_cast<const BinaryNode*>(&other))
-            return this->Node::similar(other, ltable, rtable)
-            && leftChild->similar_to(*binaryNode->leftChild, ltable, rtable)
-            && rightChild->similar_to(*binaryNode->rightChild, ltable, rtable);
-        return false;
+        return node_cast<const BinaryNode>(&other) && this->Node::similar(other, ltable, rtable);
     }
 
     inline bool similar_debug(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable, std::ostream& stream, int indent, int indent_add) const override {
@@ -246,26 +298,114 @@ class BinaryNode : public Node {
             return false;
         }
         stream << "\n";
-        if (const auto* binaryNode = dynamic_cast<const BinaryNode*>(&other))
-            return this->Node::similar_debug(other, ltable, rtable, stream, indent, indent_add)
-                   && leftChild->similar_to_debug(*binaryNode->leftChild, ltable, rtable, stream, indent+indent_add, indent_add)
-                   && rightChild->similar_to_debug(*binaryNode->rightChild, ltable, rtable, stream, indent+indent_add, indent_add);
-        return false;
+        return node_cast<const BinaryNode>(&other) != nullptr;
     }
 private:
+    friend class Node;
+
     Node* leftChild;
     Node* rightChild;
 };
 
+// A node with any number of children, stored contiguously. Used for NODE_STATEMENT_LIST and NODE_EXPRLIST.
+// The children are stored where the node is, so list nodes must be created with `new`, like all nodes.
+class ListNode : public Node {
+    public:
+    using Children = std::vector<Node*, ArenaAllocator<Node*>>;
+
+    static constexpr NodeKind KIND = NK_LIST;
+
+    ListNode() : ListNode(NODE_UNKNOWN, RT_UNKNOWN) {}
+    ListNode(NodeType nodeType, ReturnType returnType) : Node(NK_LIST, nodeType, returnType), children(Children::allocator_type::of(this)), child_hashes(children.get_allocator()) { changed(); }
+
+    ~ListNode() override { deleteChildren(this); };
+
+    const Children& getChildren() const;
+    size_t size() const;
+    Node* getChild(size_t index) const;
+
+    // Appends `node` to the children.
+    void addChild(Node* node);
+
+    // Replaces the child at `index` with `node`. Does not delete the old child.
+    void setChild(size_t index, Node* node);
+
+    inline std::ostream& doStream(std::ostream& stream) const override {
+        return doStream(stream, 0, 4);
+    }
+
+    inline std::ostream& doStream(std::ostream& stream, int indent, int indent_add) const override {
+        return doStream(stream, indent, indent_add, nullptr);
+    }
+
+    inline std::ostream& doStream(std::ostream& stream, int indent, int indent_add, const SymbolTable* table) const override {
+        return doStreamTree(stream, this, indent, indent_add, table);
+    }
+
+    protected:
+    inline bool equals(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
+        const auto* listNode = node_cast<const ListNode>(&other);
+        return listNode && this->Node::equals(other, ltable, rtable) && children.size() == listNode->children.size();
+    }
+
+    inline bool similar(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
+        const auto* listNode = node_cast<const ListNode>(&other);
+        return listNode && this->Node::similar(other, ltable, rtable) && children.size() == listNode->children.size();
+    }
+
+    inline bool similar_debug(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable, std::ostream& stream, int indent, int indent_add) const override {
+        Node::doStream(stream, indent, indent_add, ltable);
+        if (!this->Node::similar_debug(other, ltable, rtable, stream, indent, indent_add)) {
+            stream << " [";
+            other.Node::doStream(stream, 0, 0, rtable);
+            stream << "]\n";
+            return false;
+        }
+        const auto* listNode = node_cast<const ListNode>(&other);
+        if (!listNode) {
+            stream << " [not a list]\n";
+            return false;
+        }
+        if (children.size() != listNode->children.size()) {
+            stream << " (" << children.size() << " children) [" << listNode->children.size() << " children]\n";
+            return false;
+        }
+        stream << "\n";
+        return true;
+    }
+
+    private:
+    friend class Node;
+
+    Children children;
+    // Fingerprints of the children when they were set, as a child may be changed or deleted before it is replaced
+    std::vector<uint64_t, ArenaAllocator<uint64_t>> child_hashes;
+    // Sum of `child_hashes`, the one at index x times P^(x + 1) (see node.cpp): replacing or appending a child updates it
+    // in constant time.
+    uint64_t children_hash = 0;
+};
+
+// Maps the value type of a ConstantNode to its NodeKind. Only the value types below are supported.
+template<typename T> struct ConstantNodeKind;
+template<> struct ConstantNodeKind<int8_t> { static constexpr NodeKind value = NK_CONST_INT8; };
+template<> struct ConstantNodeKind<uint8_t> { static constexpr NodeKind value = NK_CONST_UINT8; };
+template<> struct ConstantNodeKind<int> { static constexpr NodeKind value = NK_CONST_INT; };
+template<> struct ConstantNodeKind<unsigned> { static constexpr NodeKind value = NK_CONST_UNSIGNED; };
+
 template<typename T>
 class ConstantNode : public Node {
     public:
-    ConstantNode() : Node() {}
-    ConstantNode(NodeType nodeType, ReturnType returnType) : Node(nodeType, returnType) {}
-    ConstantNode(NodeType nodeType, ReturnType returnType, T value) : Node(nodeType, returnType), value(value) {}
+    static constexpr NodeKind KIND = ConstantNodeKind<T>::value;
+
+    ConstantNode() : ConstantNode(NODE_UNKNOWN, RT_UNKNOWN) {}
+    ConstantNode(NodeType nodeType, ReturnType returnType) : ConstantNode(nodeType, returnType, T()) {}
+    ConstantNode(NodeType nodeType, ReturnType returnType, T value) : Node(KIND, nodeType, returnType), value(value) { changed(); }
 
     T getValue() const { return value; }
-    void setValue(T new_value) { value = new_value; };
+    void setValue(T new_value) {
+        value = new_value;
+        changed();
+    };
 
     inline std::ostream& doStream(std::ostream& stream) const override {
         return doStream(stream, 0, 4);
@@ -282,14 +422,14 @@ class ConstantNode : public Node {
 
     protected:
     inline bool equals(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
-        if (const auto* constantNode = dynamic_cast<const ConstantNode<T>*>(&other))
+        if (const auto* constantNode = node_cast<const ConstantNode<T>>(&other))
             return this->Node::equals(other, ltable, rtable) && value == constantNode->value;
         return false;
 
     }
 
     inline bool similar(const Node& other, const SymbolTable* ltable, const SymbolTable* rtable) const override {
-        if (const auto* constantNode = dynamic_cast<const ConstantNode<T>*>(&other))
+        if (const auto* constantNode = node_cast<const ConstantNode<T>>(&other))
             return this->Node::similar(other, ltable, rtable) && value == constantNode->value;
         return false;
     }
@@ -299,23 +439,28 @@ class ConstantNode : public Node {
         stream << " (Type: ConstantNode<" << hack::get_name<T>() << ">) value: " << std::to_string(value);
         if (!this->similar(other, ltable, rtable)) {
             stream << " [";
-            if (const auto* constantNode = dynamic_cast<const ConstantNode<T>*>(&other)) {
+            if (const auto* constantNode = node_cast<const ConstantNode<T>>(&other)) {
                 constantNode->doStream(stream, 0, 0, rtable);
             } else {
-                if (const auto* int8Constant = dynamic_cast<const ConstantNode<int8_t>*>(&other)) {
-                    int8Constant->Node::doStream(stream, 0, 0, ltable);
-                    stream << " (Type: ConstantNode<int8>) value: " << std::to_string(int8Constant->getValue());
-                } else if (const auto* uint8Constant = dynamic_cast<const ConstantNode<uint8_t>*>(&other)) {
-                    uint8Constant->Node::doStream(stream, 0, 0, ltable);
-                    stream << " (Type: ConstantNode<uint8>) value: " << std::to_string(uint8Constant->getValue());
-                } else if (const auto* intConstant = dynamic_cast<const ConstantNode<int>*>(&other)) {
-                    intConstant->Node::doStream(stream, 0, 0, ltable);
-                    stream << " (Type: ConstantNode<int>) value: " << std::to_string(intConstant->getValue());
-                } else if (const auto* uintConstant = dynamic_cast<const ConstantNode<unsigned>*>(&other)) {
-                    uintConstant->Node::doStream(stream, 0, 0, rtable);
-                    stream << " (Type: ConstantNode<unsigned>) value: " << std::to_string(uintConstant->getValue());
-                } else {
-                    other.Node::doStream(stream, 0, 0, rtable);
+                switch (other.getKind()) {
+                    case NK_CONST_INT8:
+                        other.Node::doStream(stream, 0, 0, ltable);
+                        stream << " (Type: ConstantNode<int8>) value: " << std::to_string(static_cast<const ConstantNode<int8_t>&>(other).getValue());
+                        break;
+                    case NK_CONST_UINT8:
+                        other.Node::doStream(stream, 0, 0, ltable);
+                        stream << " (Type: ConstantNode<uint8>) value: " << std::to_string(static_cast<const ConstantNode<uint8_t>&>(other).getValue());
+                        break;
+                    case NK_CONST_INT:
+                        other.Node::doStream(stream, 0, 0, ltable);
+                        stream << " (Type: ConstantNode<int>) value: " << std::to_string(static_cast<const ConstantNode<int>&>(other).getValue());
+                        break;
+                    case NK_CONST_UNSIGNED:
+                        other.Node::doStream(stream, 0, 0, rtable);
+                        stream << " (Type: ConstantNode<unsigned>) value: " << std::to_string(static_cast<const ConstantNode<unsigned>&>(other).getValue());
+                        break;
+                    default:
+                        other.Node::doStream(stream, 0, 0, rtable);
                 }
             }
             stream << "]\n";
@@ -329,11 +474,16 @@ private:
     T value;
 };
 
+template<typename T>
+constexpr NodeKind ConstantNode<T>::KIND;
+
 class SymbolNode : public Node {
     public:
-    SymbolNode() : Node() {}
-    SymbolNode(NodeType nodeType, ReturnType returnType) : Node(nodeType, returnType) {}
-    SymbolNode(NodeType nodeType, ReturnType returnType, size_t sym_id) : Node(nodeType, returnType), sym_id(sym_id) {}
+    static constexpr NodeKind KIND = NK_SYMBOL;
+
+    SymbolNode() : Node(NK_SYMBOL, NODE_UNKNOWN, RT_UNKNOWN) { changed(); }
+    SymbolNode(NodeType nodeType, ReturnType returnType) : Node(NK_SYMBOL, nodeType, returnType) { changed(); }
+    SymbolNode(NodeType nodeType, ReturnType returnType, size_t sym_id) : Node(NK_SYMBOL, nodeType, returnType), sym_id(sym_id) { changed(); }
 
     size_t getSymbolId() const;
     void setSymbolId(size_t id);
@@ -366,6 +516,8 @@ namespace util { // Adding `to_string` implementation for IOperator, so we can u
     inline std::string to_string(const UnaryNode&);
     template<const BinaryNode&>
     inline std::string to_string(const BinaryNode&);
+    template<const ListNode&>
+    inline std::string to_string(const ListNode&);
 
     template<typename T, const ConstantNode<T>&>
     inline std::string to_string(const ConstantNode<T>&);
@@ -0,0 +1,77 @@
+/*
+_ _ _ ____ ____ _  _ _ _  _ ____     ___  ____    _  _ ____ ___
+| | | |__| |__/ |\ | | |\ | | __ .   |  \ |  |    |\ | |  |  |
+|_|_| |  | |  \ | \| | | \| |__] .   |__/ |__|    | \| |__|  |
+
+____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
+|    |__| |__| |\ | | __ |___    |___ | |    |___  /
+|___ |  | |  | | \| |__] |___    |    | |___ |___ .
+*/
+
+#ifndef COCO_FRAMEWORK_SYNTAXUTILS_NODEVISITOR
+#define COCO_FRAMEWORK_SYNTAXUTILS_NODEVISITOR
+
+#include <type_traits>
+
+#include "node.h"
+
+/**
+ * Dispatches nodes to the visit function for their class, with a switch on `Node::getKind()`.
+ * Derived classes hide the visit functions they handle. The rest fall back to `visit_node()`.
+ * Usage:
+ *     struct Counter : NodeVisitor<Counter, size_t, const Node> {
+ *         size_t visit_node(const Node*) { return 1; }
+ *         size_t visit_unary(const UnaryNode* node) { return 1 + dispatch(node->getChild()); }
+ *     };
+ * @tparam Derived The visitor class deriving from this class.
+ * @tparam R Return type of the visit functions.
+ * @tparam NodeT `Node` or `const Node`.
+ */
+template<typename Derived, typename R = void, typename NodeT = Node>
+class NodeVisitor {
+    template<typename T>
+    using Ptr = typename std::conditional<std::is_const<NodeT>::value, const T, T>::type*;
+
+    public:
+    // Visits `node` with the function for its class. Returns `R()` for `nullptr`.
+    inline R dispatch(NodeT* node) {
+        if (!node)
+            return R();
+        switch (node->getKind()) {
+            case NK_UNARY:
+                return self().visit_unary(static_cast<Ptr<UnaryNode>>(node));
+            case NK_BINARY:
+                return self().visit_binary(static_cast<Ptr<BinaryNode>>(node));
+            case NK_LIST:
+                return self().visit_list(static_cast<Ptr<ListNode>>(node));
+            case NK_SYMBOL:
+                return self().visit_symbol(static_cast<Ptr<SymbolNode>>(node));
+            case NK_CONST_INT8:
+                return self().visit_constant(static_cast<Ptr<ConstantNode<int8_t>>>(node));
+            case NK_CONST_UINT8:
+                return self().visit_constant(static_cast<Ptr<ConstantNode<uint8_t>>>(node));
+            case NK_CONST_INT:
+                return self().visit_constant(static_cast<Ptr<ConstantNode<int>>>(node));
+            case NK_CONST_UNSIGNED:
+                return self().visit_constant(static_cast<Ptr<ConstantNode<unsigned>>>(node));
+            case NK_NODE:
+                break;
+        }
+        return self().visit_node(node);
+    }
+
+    inline R visit_node(NodeT*) { return R(); }
+    inline R visit_unary(Ptr<UnaryNode> node) { return self().visit_node(node); }
+    inline R visit_binary(Ptr<BinaryNode> node) { return self().visit_node(node); }
+    inline R visit_list(Ptr<ListNode> node) { return self().visit_node(node); }
+    inline R visit_symbol(Ptr<SymbolNode> node) { return self().visit_node(node); }
+    inline R visit_constant(Ptr<ConstantNode<int8_t>> node) { return self().visit_node(node); }
+    inline R visit_constant(Ptr<ConstantNode<uint8_t>> node) { return self().visit_node(node); }
+    inline R visit_constant(Ptr<ConstantNode<int>> node) { return self().visit_node(node); }
+    inline R visit_constant(Ptr<ConstantNode<unsigned>> node) { return self().visit_node(node); }
+
+    private:
+    inline Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+#endif
@@ -11,11 +11,15 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #ifndef COCO_FRAMEWORK_SYNTAXUTILS_SCOPE
 #define COCO_FRAMEWORK_SYNTAXUTILS_SCOPE
 
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <interner.h>
+
 #include "symbol.h"
 
 // Class representing a scope
@@ -24,6 +28,14 @@ class Scope {
     Scope() = default;
     ~Scope() = default;
 
+    /**
+     * Adds the given symbol to this scope
+     * @param name interned name of the symbol
+     * @param sym_id sym_id of the symbol
+     * @return `true` on success, `false` if the symbol could not be added (already exists)
+     */
+    bool addSymbol(Atom name, size_t sym_id);
+
     /**
      * Adds the given symbol to this scope
      * @param name name of the symbol
@@ -32,6 +44,13 @@ class Scope {
      */
     bool addSymbol(const std::string& name, size_t sym_id);
 
+    /**
+     * Returns the id of the symbol identified by <sym_name> in this scope.
+     * @param sym_name interned name of the symbol
+     * @return the found id or std::numeric_limits<size_t>::max() on error
+     */
+    size_t getSymbolId(Atom sym_name);
+
     /**
      * Returns the id of the symbol identified by <sym_name> in this scope.
      * @param sym_name name of the symbol
@@ -44,6 +63,80 @@ class Scope {
 
     private:
     // Note: name of symbols should be unique within each scope
-    std::unordered_map<std::string, size_t> symbols;
+    std::unordered_map<Atom, size_t> symbols;
 };
+
+/**
+ * Nested scopes in one table, from the outermost scope (depth 0, always open) to the innermost one.
+ * Every name maps to its innermost declaration, which keeps a link to the declaration it shadows.
+ * Declarations are logged in order, so closing a scope undoes the declarations at the end of the log.
+ * Lookup takes one hash probe at any depth, and opening a scope allocates nothing.
+ */
+class ScopeStack {
+    public:
+    ScopeStack() = default;
+
+    // Opens a new innermost scope.
+    void enter();
+
+    // Closes the innermost scope, making the declarations it shadowed visible again. Does nothing at depth 0.
+    void exit();
+
+    // Returns the number of open scopes above the outermost one.
+    size_t depth() const;
+
+    /**
+     * Declares a symbol in the innermost scope.
+     * @param name interned name of the symbol
+     * @param sym_id sym_id of the symbol
+     * @return `true` on success, `false` if the innermost scope already declares `name`
+     */
+    bool addSymbol(Atom name, size_t sym_id);
+
+    /**
+     * Returns the id of the innermost visible symbol called <sym_name>.
+     * @param sym_name interned name of the symbol
+     * @return the found id or std::numeric_limits<size_t>::max() if no open scope declares it
+     */
+    size_t getSymbolId(Atom sym_name) const;
+
+    // @see ScopeStack::getSymbolId(Atom)
+    size_t getSymbolId(const std::string& sym_name) const;
+
+    // Returns a mark of the declarations made so far, for `rewind`.
+    size_t mark() const;
+
+    /**
+     * Hides the declarations made since `mark` was taken, until `restore`, so names resolve as they did at the mark.
+     * Scopes opened after the mark must have been closed. Only one rewind can be active at a time.
+     */
+    void rewind(size_t mark);
+
+    // Closes the scopes opened since `rewind`, and makes the declarations it hid visible again.
+    void restore();
+
+    private:
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    struct Declaration {
+        Atom name;
+        uint32_t depth;
+        // Index of the declaration this one shadows, or NONE
+        uint32_t shadowed;
+        size_t sym_id;
+    };
+
+    // Innermost declaration of every visible name, as an index into `log`
+    std::unordered_map<Atom, uint32_t> visible;
+    // All visible declarations, in order of declaration
+    std::vector<Declaration> log;
+    uint32_t current_depth = 0;
+    // Declarations hidden by `rewind`, last declared first
+    std::vector<Declaration> hidden;
+    uint32_t rewound_depth = 0;
+
+    // Makes the declaration at the end of the log invisible, and removes it from the log.
+    void pop();
+};
+
 #endif
@@ -17,19 +17,28 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #include <string>
 #include <utility>
 #include <limits>
+#include <arena.h>
+#include <interner.h>
 #include <to_string.h>
 
-// The base class for Symbols
-class Symbol {
+/**
+ * A symbol: a plain record, copied by value. Array symbols (with an array ReturnType) also carry their size.
+ * The symbol table stores symbols by value. Symbols created with `new` are created in the current arena, if there is one.
+ * Names are atoms of the current interner (see Interner::current), so use symbols where the same interner is current.
+ */
+class Symbol : public ArenaAllocated {
     public:
     Symbol() = default;
-    Symbol(std::string name, int line, ReturnType returnType, SymbolType symbolType) : name(std::move(name)), line(line), returnType(returnType), symbolType(symbolType) {}
-
-    virtual ~Symbol() = default;
+    Symbol(const std::string& name, int line, ReturnType returnType, SymbolType symbolType, ssize_t size = 0) : name(Interner::current().intern(name)), line(line), returnType(returnType), symbolType(symbolType), size(size) {}
+    Symbol(Atom name, int line, ReturnType returnType, SymbolType symbolType, ssize_t size = 0) : name(name), line(line), returnType(returnType), symbolType(symbolType), size(size) {}
 
     const std::string& getName() const;
     void setName(const std::string& name);
 
+    // Returns the interned name of this symbol. Compare these instead of names, where possible.
+    Atom getNameAtom() const;
+    void setName(Atom name);
+
     int getLine() const;
     void setLine(int line);
 
@@ -39,6 +48,13 @@ class Symbol {
     SymbolType getSymbolType() const;
     void setSymbolType(SymbolType newSymbolType);
 
+    // Whether this is an array symbol, by its ReturnType.
+    bool isArray() const;
+
+    // Number of elements of an array symbol. 0 for other symbols.
+    ssize_t getSize() const;
+    void setSize(ssize_t new_value);
+
 
     inline bool operator==(const Symbol& other) const {
         return equal_to(other);
@@ -49,8 +65,8 @@ class Symbol {
      * @param other Object to compare with.
      * @return `true` iff other is equivalent to this, `false` otherwise.
      */
-    inline virtual bool equal_to(const Symbol& other) const {
-        return equals(other);
+    inline bool equal_to(const Symbol& other) const {
+        return name == other.name && line == other.line && returnType == other.returnType && symbolType == other.symbolType && size == other.size;
     }
 
     /**
@@ -59,64 +75,39 @@ class Symbol {
      * @return `true` iff other is similar to this, `false` otherwise.
      * @note We enforce equivalent names, since compiler implementations really should do that.
      */
-    inline virtual bool similar_to(const Symbol& other) const {
-        return similar(other);
+    inline bool similar_to(const Symbol& other) const {
+        return equal_to(other);
     }
 
     inline friend std::ostream& operator<<(std::ostream& stream, const Symbol& symbol) {
         return symbol.doStream(stream);
     }
 
-    inline virtual std::ostream& doStream(std::ostream& stream, int width_line, int width_name, int width_returntype) const {
-        return stream << std::setw(width_line) << line << std::setw(width_name) << name << std::setw(width_returntype) << util::to_string(returnType) << util::to_string(symbolType);
+    inline std::ostream& doStream(std::ostream& stream, int width_line, int width_name, int width_returntype) const {
+        return stream << std::setw(width_line) << line << std::setw(width_name) << getName() << std::setw(width_returntype) << util::to_string(returnType) << util::to_string(symbolType);
     }
 
-    inline virtual std::ostream& doStream(std::ostream& stream) const {
+    inline std::ostream& doStream(std::ostream& stream) const {
+        if (isArray())
+            return stream << std::setw(6) << line << std::setw(12) << util::to_string(returnType) << std::setw(12) << util::to_string(symbolType) << getName() << '[' << size << ']';
         return doStream(stream, 6, 16, 12);
     }
 
-    protected:
-    inline virtual bool equals(const Symbol& other) const {
-        return name == other.name && line == other.line && returnType == other.returnType && symbolType == other.symbolType;
-    }
-
-    inline virtual bool similar(const Symbol& other) const {
-        return name == other.name && line == other.line && returnType == other.returnType && symbolType == other.symbolType;
-    }
-
-    std::string name;
+    private:
+    Atom name = Interner::EMPTY;
     int line = -1;
     ReturnType returnType = RT_UNKNOWN;
     SymbolType symbolType = ST_UNKNOWN;
+    ssize_t size = 0;
 };
 
+// Array symbols are symbols with an array ReturnType and a size. This class adds nothing to Symbol: it keeps the
+// name, and exports `getSize` under it for libraries built when it was a separate class (e.g. prebuilt/libmachinecode.so).
 class ArraySymbol : public Symbol {
     public:
-    ArraySymbol() = default;
-    ArraySymbol(std::string name, int line, ReturnType returnType, SymbolType symbolType, ssize_t arraySize) : Symbol(std::move(name), line, returnType, symbolType), size(arraySize) {}
-
+    using Symbol::Symbol;
 
     ssize_t getSize() const;
-    void setSize(ssize_t new_value);
-
-    inline std::ostream& doStream(std::ostream& stream) const override {
-        return stream << std::setw(6) << line << std::setw(12) << util::to_string(returnType) << std::setw(12) << util::to_string(symbolType) << name << '[' << size << ']';
-    }
-
-    protected:
-    inline bool equals(const Symbol& other) const override {
-        if (const auto* arraySymbol = dynamic_cast<const ArraySymbol*>(&other))
-            return Symbol::equals(other) && size == arraySymbol->size;
-        return false;
-    }
-
-    inline bool similar(const Symbol& other) const override {
-        if (const auto* arraySymbol = dynamic_cast<const ArraySymbol*>(&other))
-            return Symbol::similar(other) && size == arraySymbol->size;
-        return false;
-    }
-
-    ssize_t size = 0;
 };
 
 #endif
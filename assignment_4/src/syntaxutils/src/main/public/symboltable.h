@@ -11,8 +11,13 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #ifndef COCO_FRAMEWORK_SYNTAXUTILS_SYMBOLTABLE
 #define COCO_FRAMEWORK_SYNTAXUTILS_SYMBOLTABLE
 
+#include <cstdint>
+#include <deque>
 #include <iomanip>
+#include <limits>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "node.h"
@@ -21,36 +26,90 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 
 class SymbolTable {
     public:
+    /**
+     * A read-only view of a list of symbol ids in the table. Allocates nothing.
+     * Valid until the next symbol is added to the table.
+     */
+    class Ids {
+        public:
+        Ids() = default;
+        Ids(const uint32_t* first, const uint32_t* last) : first(first), last(last) {}
+
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+        size_t operator[](size_t index) const { return first[index]; }
+
+        private:
+        const uint32_t* first = nullptr;
+        const uint32_t* last = nullptr;
+    };
+
     SymbolTable() = default;
+    // Out of line, for libraries built against it (e.g. prebuilt/libmachinecode.so).
     ~SymbolTable();
 
     /**
      * Adds a (non-function) symbol corresponding to a function to the table.
      * Does nothing if function does not exist.
-     * @param symbol the symbol to add.
+     * @param symbol the symbol to add. The table stores a copy.
      * @param function the identifier of the function to which it belongs or 0 for global.
      * @return the identifier of the added symbol or std::numeric_limits<size_t>::max() if function does not exist.
      */
+    size_t addSymbol(const Symbol& symbol, size_t function);
+
+    /**
+     * Adds a (non-function) symbol to the table. The table stores a copy and frees `symbol`, also on failure.
+     * @see SymbolTable::addSymbol(const Symbol&, size_t)
+     */
+    size_t addSymbol(std::unique_ptr<Symbol> symbol, size_t function);
+
+    /**
+     * Adds a (non-function) symbol, created with `new`, to the table.
+     * The table copies and deletes the symbol on success: use `getSymbol` to access it afterwards.
+     * @see SymbolTable::addSymbol(const Symbol&, size_t)
+     */
+    [[deprecated("the table deletes `symbol`: pass a Symbol or a std::unique_ptr<Symbol> instead")]]
     size_t addSymbol(Symbol* symbol, size_t function);
 
     /**
      * Adds a function symbol to the table.
+     * @param symbol the function symbol to add. The table stores a copy.
+     * @return the identifier of the added symbol.
+     */
+    size_t addFunction(const Symbol& symbol);
+
+    /**
+     * Adds a function symbol to the table. The table stores a copy and frees `symbol`.
+     * @see SymbolTable::addFunction(const Symbol&)
+     */
+    size_t addFunction(std::unique_ptr<Symbol> symbol);
+
+    /**
+     * Adds a function symbol to the table. Copies and deletes all passed symbols, which must be created with `new`.
      * @param symbol the function symbol to add.
      * @param variables (optional) a vector of Symbol* corresponding to the variables of the function.
      * @param parameters (optional) a vector of Symbol* corresponding to the parameters of the function.
      * @return the identifier of the added symbol.
      */
+    [[deprecated("the table deletes all passed symbols: pass Symbols or std::unique_ptr<Symbol>s instead")]]
     size_t addFunction(Symbol* symbol, const std::vector<Symbol*>& variables = {}, const std::vector<Symbol*>& parameters = {});
 
     /**
-     * Find a symbol by its id.
+     * Find a symbol by its id. Symbols never move: the pointer stays valid for the lifetime of the table.
      * @param id id of the symbol to find.
      * @return Returns found symbol on success, `nullptr` if the symbol cannot be found.
      */
     Symbol* getSymbol(size_t id) const;
 
     /**
-     * @return all global (non-function) symbols.
+     * @return ids of all global (non-function) symbols, in order of addition.
+     */
+    Ids globalIds() const;
+
+    /**
+     * @return all global (non-function) symbols. Builds a map: use `globalIds` instead.
      */
     std::unordered_map<size_t, Symbol*> getGlobals() const;
 
@@ -66,6 +125,18 @@ class SymbolTable {
      */
     std::vector<size_t> getFunctions() const;
 
+    /**
+     * @param id the identifier of a function.
+     * @return ids of the variables of the function, or an empty view if there is no such function.
+     */
+    Ids getVariables(size_t id) const;
+
+    /**
+     * @param id the identifier of a function.
+     * @return ids of the parameters of the function, or an empty view if there is no such function.
+     */
+    Ids getParameters(size_t id) const;
+
     /**
      * pushes all function variables into the given vector.
      * @param Function ID to push variables for.
@@ -94,17 +165,24 @@ class SymbolTable {
      */
     bool getParameters(size_t id, std::vector<Symbol*>& parameters) const;
 
+    /**
+     * Removes all symbols, keeping the capacity of the table for the next program. Ids start over at 1.
+     */
+    void clear();
+
+    // Returns the number of symbols the table holds before it allocates again.
+    size_t capacity() const;
+
     size_t addTempvar(ReturnType rt, const std::string& name, size_t func_id);
     size_t addLabel(ReturnType rt, const std::string& name, size_t func_id);
 
     inline friend std::ostream& operator<<(std::ostream& stream, const SymbolTable& table) {
         stream << "===== Symbol table dump =====\n";
-        if (table.getGlobals().size() > 0) {
+        if (!table.globalIds().empty()) {
             stream << "----- Global symbols -----\n";
             stream << std::left << std::setw(4) << "id" << std::setw(6) << "Line" << std::setw(16) << "name" << std::setw(12) << "ReturnType"
                    << "SymbolType\n";
-            for (const auto& global: table.getGlobals()) {
-                const auto& id = global.first;
+            for (const size_t id: table.globalIds()) {
                 const auto& globalsym = table.getSymbol(id);
                 if (globalsym)
                     stream << std::setw(4) << id << *globalsym << '\n';
@@ -114,20 +192,20 @@ class SymbolTable {
         }
         stream << "----- Function symbols -----\n";
         for (const auto& function: table.functions) {
-            const auto& funsym = table.getSymbol(function.first);
-            stream << std::left << "FUNCTION: " << std::setw(16) << funsym->getName() << "id: " << std::setw(4) << function.first << "line: " << funsym->getLine() << '\n';
-            if (function.second.parameters.empty() && function.second.variables.empty())
+            const auto& funsym = table.getSymbol(function.id);
+            stream << std::left << "FUNCTION: " << std::setw(16) << funsym->getName() << "id: " << std::setw(4) << function.id << "line: " << funsym->getLine() << '\n';
+            if (function.parameters.size == 0 && function.variables.size == 0)
                 continue;
             stream << std::setw(4) << "id" << std::setw(6) << "Line" << std::setw(16) << "name" << std::setw(12) << "ReturnType"
                    << "SymbolType\n";
-            for (const auto& id: function.second.parameters) {
+            for (const size_t id: table.view(function.parameters)) {
                 const auto& paramsym = table.getSymbol(id);
                 if (paramsym)
                     stream << std::left << std::setw(4) << id << *paramsym << '\n';
                 else
                     stream << std::left << std::setw(4) << id << "Parameter not found!\n";
             }
-            for (const auto& id: function.second.variables) {
+            for (const size_t id: table.view(function.variables)) {
                 const auto& varsym = table.getSymbol(id);
                 if (varsym)
                     stream << std::setw(4) << id << *varsym << '\n';
@@ -142,34 +220,58 @@ class SymbolTable {
     private:
     friend class FrontendBuilder;
 
+    // Marks symbols that are not functions, in SymbolInfo::function.
+    static constexpr uint32_t NO_FUNCTION = std::numeric_limits<uint32_t>::max();
+
     // Struct to maintain some metadata of Symbols
     struct SymbolInfo {
-        size_t id = 0;
         // id of function to which this variable belongs
         // if symbol is global this should be 0
-        size_t func_id = 0;
-        Symbol* symbol = nullptr;
+        uint32_t func_id = 0;
+        // Index in `functions`, if this symbol is a function
+        uint32_t function = NO_FUNCTION;
 
         inline friend std::ostream& operator<<(std::ostream& stream, const SymbolInfo& sym_info) {
-            stream << "--- Symbol: id " << sym_info.id << ", function: " << sym_info.func_id << std::endl;
-            stream << sym_info.symbol;
-            return stream;
+            return stream << "--- Symbol: function " << sym_info.func_id << std::endl;
         }
     };
 
+    // A list of symbol ids, stored as the range [begin, begin + size) of `members`, with room for `capacity` ids.
+    struct Members {
+        uint32_t begin = 0;
+        uint32_t size = 0;
+        uint32_t capacity = 0;
+    };
+
     // Struct to maintain some metadata of Functions
     struct FunctionInfo {
+        uint32_t id = 0;
         // Ids of variables in the scope of the Function
         // includes all non-parameter symbol types
-        std::vector<size_t> variables;
+        Members variables;
         // Ids of parameters in the scope of the Function
-        std::vector<size_t> parameters;
+        Members parameters;
     };
 
-    // Map from symbol-id to its symbolInfo
-    std::unordered_map<size_t, SymbolInfo> symbols;
-    // Map from function-id to all its variables
-    std::unordered_map<size_t, FunctionInfo> functions;
+    // Metadata of symbols by id. Ids are handed out in order, starting at 1: id 0 is no symbol.
+    std::vector<SymbolInfo> symbols = std::vector<SymbolInfo>(1);
+    // Symbols by id, by value. A deque never moves its elements when growing, so pointers to symbols stay valid.
+    // After a `clear`, it may hold more symbols than `symbols`: those are reused by later ones (see `store`).
+    // Mutable, as the table hands out modifiable symbols from const functions, like when it stored pointers.
+    mutable std::deque<Symbol> values = std::deque<Symbol>(1);
+    // Functions, in order of addition
+    std::vector<FunctionInfo> functions;
+    // Global (non-function) symbols
+    Members globals;
+    // Storage of all Members lists. A list that outgrows its capacity moves to the end.
+    std::vector<uint32_t> members;
+
+    Ids view(const Members& list) const { return Ids(members.data() + list.begin, members.data() + list.begin + list.size); }
+    void append(Members& list, uint32_t id);
+    // Stores the symbol of the id just added to `symbols`.
+    void store(const Symbol& symbol);
+    // The FunctionInfo of the function with id `func_id`, or `nullptr` if there is no such function.
+    const FunctionInfo* function(size_t func_id) const;
 
     size_t addSymbol(SymbolType st, ReturnType rt, const std::string& name, size_t func_id);
 };
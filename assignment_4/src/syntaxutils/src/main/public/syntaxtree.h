@@ -11,10 +11,12 @@ ____ _  _ ____ _  _ ____ ____    ____ _ _    ____   /
 #ifndef COCO_FRAMEWORK_SYNTAXUTILS_SYNTAXTREE
 #define COCO_FRAMEWORK_SYNTAXUTILS_SYNTAXTREE
 
+#include <cstdint>
 #include <iostream>
 #include <map>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "node.h"
@@ -24,8 +26,51 @@ class SyntaxTree {
     SyntaxTree() = default;
     virtual ~SyntaxTree();
 
+    /**
+     * Hash-consing of expressions: while a HashConsing object is alive, the factories below on this thread return the
+     * earlier node for an expression without side effects (no function calls or assignments) that they created before,
+     * instead of a new one. Equal subexpressions then are one shared subtree, which compares in O(1).
+     * Only nodes in an arena are shared, as nodes delete their children. Passes must treat shared nodes as values:
+     * a node may have several parents, so it may only be changed in ways that are right for every one of them.
+     */
+    class HashConsing {
+        public:
+        HashConsing();
+        ~HashConsing();
+
+        HashConsing(const HashConsing&) = delete;
+        HashConsing& operator=(const HashConsing&) = delete;
+
+        private:
+        friend class SyntaxTree;
+
+        // What the factories make a node from. Children of shared nodes are shared nodes, so they compare by identity.
+        struct Shape {
+            NodeKind kind;
+            NodeType nodeType;
+            ReturnType returnType;
+            uint64_t value; // Constant value or symbol id
+            const Node* left;
+            const Node* right;
+
+            bool operator==(const Shape& other) const;
+        };
+
+        struct ShapeHash {
+            size_t operator()(const Shape& shape) const;
+        };
+
+        HashConsing* previous;
+        std::unordered_map<Shape, Node*, ShapeHash> nodes;
+        // The nodes in `nodes`: expressions without side effects
+        std::unordered_set<const Node*> shared;
+    };
+
     Node* getRoot(size_t id) const;
 
+    // Removes all functions, like destruction does, but keeps the memory of the tree itself for the next program.
+    void clear();
+
     // creates an unary parent node
     static Node* createParentNode(NodeType nodeType, ReturnType returnType, Node* child);
 
@@ -35,12 +80,15 @@ class SyntaxTree {
     // creates an integer leaf with node type NODE_NUM
     template<typename T>
     static Node* createNumNode(T value, ReturnType rt) {
+        const HashConsing::Shape shape{ConstantNode<T>::KIND, NODE_NUM, rt, static_cast<uint64_t>(static_cast<int64_t>(value)), nullptr, nullptr};
+        if (Node* node = find_shared(shape))
+            return node;
         auto* node = new ConstantNode<T>;
         node->setNodeType(NODE_NUM);
         node->setReturnType(rt);
         node->setValue(value);
 
-        return node;
+        return share(shape, node);
     }
 
     // creates a symbol leaf with node type NODE_ID
@@ -49,6 +97,9 @@ class SyntaxTree {
     // creates a leaf with node type NODE_EMPTY
     static Node* createLeaf();
 
+    // creates an empty list node with node type `nodeType` (NODE_STATEMENT_LIST or NODE_EXPRLIST)
+    static ListNode* createListNode(NodeType nodeType);
+
     inline friend std::ostream& operator<<(std::ostream& stream, const SyntaxTree& tree) {
         return tree.doStream(stream, 4, nullptr);
     }
@@ -66,6 +117,11 @@ class SyntaxTree {
     private:
     friend class FrontendBuilder;
 
+    // The node of `shape` created earlier under the current HashConsing object, or `nullptr`.
+    static Node* find_shared(const HashConsing::Shape& shape);
+    // Shares `node`, made from `shape`, if possible. Returns `node`.
+    static Node* share(const HashConsing::Shape& shape, Node* node);
+
     struct FunctionInfo {
         std::string name;
         Node* root = nullptr;
@@ -49,11 +49,9 @@ typedef enum nodetype {
     NODE_UNKNOWN, // Unknown (yet)
     NODE_ERROR,   // Error
 
-    /* Statement list
-     left child     One of: NODE_ASSIGNMENT, NODE_IF, NODE_WHILE,
-                    NODE_FUNCTIONCALL, NODE_STATEMENT_LIST, NODE_RETURN.
-     right child    NODE_STATEMENT_LIST, or
-                    NODE_EMPTY if no more statements follow. */
+    /* Statement list (ListNode)
+     children       The statements, in order. Each one of: NODE_ASSIGNMENT, NODE_IF, NODE_WHILE,
+                    NODE_FUNCTIONCALL, NODE_STATEMENT_LIST, NODE_RETURN. */
     NODE_STATEMENT_LIST,
 
     /* Assignment
@@ -100,11 +98,8 @@ typedef enum nodetype {
                     NODE_EMPTY if no arguments required. */
     NODE_FUNCTIONCALL,
 
-    /* Expression list
-     left child     A subtree representing an expression
-     right child    A subtree representing an expression, another
-                    NODE_EXPRLIST, or NODE_EMPTY if no more expressions follow
-                    in the expression list. */
+    /* Expression list (ListNode)
+     children       The subtrees representing the expressions, in order. */
     NODE_EXPRLIST,
 
     /* Relational operators